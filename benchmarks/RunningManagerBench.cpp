@@ -0,0 +1,373 @@
+#include "AllocationCounter.hpp"
+#include "TestFixtures.hpp"
+#include "runtime/AlertRules.hpp"
+#include "runtime/ProcessMetricsProvider.hpp"
+#include "runtime/RunningManager.hpp"
+
+#include <QCoreApplication>
+#include <QTemporaryDir>
+#include <QTest>
+
+#include <memory>
+#include <sys/resource.h>
+
+// Benchmarks for the per-tick hot paths, parameterized by the number of
+// tracked games. Every benchmark is data-driven over the same game counts so
+// that results line up across functions and releases. Use QtTest's loggers
+// for machine-readable output, e.g.
+//
+//     runtime_manager_bench -o bench.xml,xml
+//     runtime_manager_bench -o bench.csv,csv
+//
+// The alloc* functions report heap allocations per tick as "Events" instead
+// of a time.
+
+namespace {
+constexpr qint64 FIRST_PID = 10000;
+constexpr int MAX_GAMES = 1000;
+constexpr int WARMUP_TICKS = 3;
+
+// Returns the same plausible sample for every PID, so that the manager side
+// is measured without any I/O.
+class StaticMetricsProvider : public Runtime::ProcessMetricsProvider {
+public:
+    Runtime::ProcessMetrics metricsForPid(qint64 pid) override
+    {
+        Runtime::ProcessMetrics metrics;
+        metrics.pid = pid;
+        metrics.cpuPercent = 35.0;
+        metrics.gpuPercent = 60.0;
+        metrics.ramMb = 2048.0;
+        metrics.ramPercent = 25.0;
+        metrics.temperatureC = 70.0;
+        metrics.gpuTemperatureC = 65.0;
+        metrics.powerWatts = 25.0;
+        metrics.fps = 60.0;
+        metrics.frameTimeMs = 16.7;
+        metrics.frameTimeMaxMs = 20.0;
+        metrics.valid = true;
+        return metrics;
+    }
+};
+
+// The same handheld-like layout as the provider tests: CPU hwmon, an APU on
+// card1 with its own hwmon, and a battery.
+bool buildSysFixture(const QString& sys)
+{
+    return writeFixture(sys, "class/hwmon/hwmon0/name", "k10temp\n")
+        && writeFixture(sys, "class/hwmon/hwmon0/temp1_label", "Tctl\n")
+        && writeFixture(sys, "class/hwmon/hwmon0/temp1_input", "61500\n")
+        && writeFixture(sys, "class/drm/card1-eDP-1/status", "connected\n")
+        && linkFixture(sys, "class/drm/card1/device/driver", "../../../../bus/pci/drivers/amdgpu")
+        && writeFixture(sys, "class/drm/card1/device/gpu_busy_percent", "37\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon1/name", "amdgpu\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon1/temp1_label", "edge\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon1/temp1_input", "55000\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon1/power1_average", "15000000\n")
+        && writeFixture(sys, "class/power_supply/BAT1/type", "Battery\n")
+        && writeFixture(sys, "class/power_supply/BAT1/power_now", "21500000\n");
+}
+
+bool buildProcFixture(const QString& proc, int processes)
+{
+    if (!writeFixture(proc, "meminfo", "MemTotal:       16384000 kB\nMemFree:         8000000 kB\n")) {
+        return false;
+    }
+    for (int i = 0; i < processes; ++i) {
+        const QByteArray pid = QByteArray::number(FIRST_PID + i);
+        const QString dir = QString::fromLatin1(pid);
+        if (!writeFixture(proc, dir + "/stat",
+                          pid + " (Game Shipping) S 1 " + pid + ' ' + pid
+                              + " 0 -1 4194560 1200 0 3 0 250 75 0 0 20 0 48 0 1000 8000000 51200\n")
+            || !writeFixture(proc, dir + "/statm", statmFixture(1638400))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+QVector<qint64> pidRange(int count)
+{
+    QVector<qint64> pids;
+    pids.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        pids.append(FIRST_PID + i);
+    }
+    return pids;
+}
+} // namespace
+
+class RunningManagerBench : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void benchUpdateTick_data();
+    void benchUpdateTick();
+    void allocUpdateTick_data();
+    void allocUpdateTick();
+    void benchGames_data();
+    void benchGames();
+    void benchMetricsFor_data();
+    void benchMetricsFor();
+    void benchEvaluateAlerts_data();
+    void benchEvaluateAlerts();
+    void allocEvaluateAlerts_data();
+    void allocEvaluateAlerts();
+    void benchProviderMetricsForPid();
+    void benchProviderMetricsForPids_data();
+    void benchProviderMetricsForPids();
+    void allocProviderMetricsForPids_data();
+    void allocProviderMetricsForPids();
+
+private:
+    static void addGameCounts();
+    std::unique_ptr<Runtime::RunningManager> createManager(int games) const;
+    std::shared_ptr<Runtime::ProcessMetricsProvider> createFixtureProvider() const;
+
+    QTemporaryDir m_fixtureRoot;
+    Runtime::SystemPaths m_paths;
+};
+
+void RunningManagerBench::initTestCase()
+{
+    QVERIFY(m_fixtureRoot.isValid());
+
+    // The provider keeps two descriptors open per process.
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+
+    m_paths.procRoot = m_fixtureRoot.path() + QStringLiteral("/proc");
+    m_paths.sysRoot = m_fixtureRoot.path() + QStringLiteral("/sys");
+    // No game publishes frames; keep the lookups away from real channels.
+    m_paths.frameChannelPrefix = QStringLiteral("/runtime-frames-bench-%1-").arg(QCoreApplication::applicationPid());
+    QVERIFY(buildProcFixture(m_paths.procRoot, MAX_GAMES));
+    QVERIFY(buildSysFixture(m_paths.sysRoot));
+}
+
+void RunningManagerBench::addGameCounts()
+{
+    QTest::addColumn<int>("games");
+    for (int games : {1, 10, 100, 1000}) {
+        QTest::newRow(QByteArray::number(games).constData()) << games;
+    }
+}
+
+std::unique_ptr<Runtime::RunningManager> RunningManagerBench::createManager(int games) const
+{
+    auto manager = std::make_unique<Runtime::RunningManager>(std::make_shared<StaticMetricsProvider>());
+    // Only refreshNow() samples, and it reads every metric.
+    manager->setUpdateIntervalMs(3600 * 1000);
+    manager->subscribeAll();
+    for (int i = 0; i < games; ++i) {
+        manager->registerGame(QStringLiteral("game%1").arg(i), QStringLiteral("Game %1").arg(i), FIRST_PID + i, true,
+                              QString());
+    }
+    for (int i = 0; i < WARMUP_TICKS; ++i) {
+        manager->refreshNow();
+    }
+    return manager;
+}
+
+std::shared_ptr<Runtime::ProcessMetricsProvider> RunningManagerBench::createFixtureProvider() const
+{
+    return Runtime::createSystemMetricsProvider(m_paths);
+}
+
+void RunningManagerBench::benchUpdateTick_data()
+{
+    addGameCounts();
+}
+
+// A full tick: sample, merge, history, alerts, model updates and the change
+// notification.
+void RunningManagerBench::benchUpdateTick()
+{
+    QFETCH(int, games);
+    auto manager = createManager(games);
+
+    QBENCHMARK {
+        manager->refreshNow();
+    }
+}
+
+void RunningManagerBench::allocUpdateTick_data()
+{
+    addGameCounts();
+}
+
+void RunningManagerBench::allocUpdateTick()
+{
+    QFETCH(int, games);
+    auto manager = createManager(games);
+
+    qint64 allocations = 0;
+    {
+        AllocationCounter counter;
+        manager->refreshNow();
+        allocations = counter.count();
+    }
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+}
+
+void RunningManagerBench::benchGames_data()
+{
+    addGameCounts();
+}
+
+void RunningManagerBench::benchGames()
+{
+    QFETCH(int, games);
+    auto manager = createManager(games);
+
+    QBENCHMARK {
+        const QVariantList list = manager->games();
+        Q_UNUSED(list);
+    }
+}
+
+void RunningManagerBench::benchMetricsFor_data()
+{
+    addGameCounts();
+}
+
+// One lookup per game, as a delegate per row would do.
+void RunningManagerBench::benchMetricsFor()
+{
+    QFETCH(int, games);
+    auto manager = createManager(games);
+    QStringList titleIds;
+    for (int i = 0; i < games; ++i) {
+        titleIds.append(QStringLiteral("game%1").arg(i));
+    }
+
+    double sum = 0.0;
+    QBENCHMARK {
+        for (const QString& titleId : std::as_const(titleIds)) {
+            sum += manager->metricsFor(titleId).cpuPercent;
+        }
+    }
+    QVERIFY(sum > 0.0);
+}
+
+void RunningManagerBench::benchEvaluateAlerts_data()
+{
+    addGameCounts();
+}
+
+// A tenth of the games sit in the hysteresis band of the temperature rule so
+// that the scalar state machine sees some work without raising every tick.
+void RunningManagerBench::benchEvaluateAlerts()
+{
+    QFETCH(int, games);
+    StaticMetricsProvider provider;
+    QVector<Runtime::ProcessMetrics> metrics(games);
+    QVector<Runtime::AlertState> states(games);
+    QVector<const Runtime::ProcessMetrics*> metricPointers(games);
+    QVector<Runtime::AlertState*> statePointers(games);
+    for (int i = 0; i < games; ++i) {
+        metrics[i] = provider.metricsForPid(FIRST_PID + i);
+        if (i % 10 == 0) {
+            metrics[i].temperatureC = 82.0;
+        }
+        metricPointers[i] = &metrics[i];
+        statePointers[i] = &states[i];
+    }
+
+    Runtime::AlertEngine engine;
+    QVector<Runtime::AlertTransition> transitions;
+    qint64 nowMs = 0;
+    QBENCHMARK {
+        transitions.clear();
+        engine.evaluate(metricPointers.constData(), statePointers.constData(), games, nowMs += 1000, transitions);
+    }
+}
+
+void RunningManagerBench::allocEvaluateAlerts_data()
+{
+    addGameCounts();
+}
+
+void RunningManagerBench::allocEvaluateAlerts()
+{
+    QFETCH(int, games);
+    StaticMetricsProvider provider;
+    QVector<Runtime::ProcessMetrics> metrics(games);
+    QVector<Runtime::AlertState> states(games);
+    QVector<const Runtime::ProcessMetrics*> metricPointers(games);
+    QVector<Runtime::AlertState*> statePointers(games);
+    for (int i = 0; i < games; ++i) {
+        metrics[i] = provider.metricsForPid(FIRST_PID + i);
+        metricPointers[i] = &metrics[i];
+        statePointers[i] = &states[i];
+    }
+
+    Runtime::AlertEngine engine;
+    QVector<Runtime::AlertTransition> transitions;
+    engine.evaluate(metricPointers.constData(), statePointers.constData(), games, 0, transitions);
+
+    qint64 allocations = 0;
+    {
+        AllocationCounter counter;
+        transitions.clear();
+        engine.evaluate(metricPointers.constData(), statePointers.constData(), games, 1000, transitions);
+        allocations = counter.count();
+    }
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+}
+
+// One process through the fixture tree, with warm descriptors.
+void RunningManagerBench::benchProviderMetricsForPid()
+{
+    auto provider = createFixtureProvider();
+    QVERIFY(provider->metricsForPid(FIRST_PID).valid);
+
+    QBENCHMARK {
+        provider->metricsForPid(FIRST_PID);
+    }
+}
+
+void RunningManagerBench::benchProviderMetricsForPids_data()
+{
+    addGameCounts();
+}
+
+void RunningManagerBench::benchProviderMetricsForPids()
+{
+    QFETCH(int, games);
+    auto provider = createFixtureProvider();
+    const QVector<qint64> pids = pidRange(games);
+    QCOMPARE(provider->metricsForPids(pids).size(), games);
+
+    QBENCHMARK {
+        provider->metricsForPids(pids);
+    }
+}
+
+void RunningManagerBench::allocProviderMetricsForPids_data()
+{
+    addGameCounts();
+}
+
+void RunningManagerBench::allocProviderMetricsForPids()
+{
+    QFETCH(int, games);
+    auto provider = createFixtureProvider();
+    const QVector<qint64> pids = pidRange(games);
+    provider->metricsForPids(pids);
+
+    qint64 allocations = 0;
+    {
+        AllocationCounter counter;
+        provider->metricsForPids(pids);
+        allocations = counter.count();
+    }
+    QTest::setBenchmarkResult(allocations, QTest::Events);
+}
+
+QTEST_MAIN(RunningManagerBench)
+#include "RunningManagerBench.moc"
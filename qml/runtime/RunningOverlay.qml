@@ -12,6 +12,35 @@ ApplicationWindow {
     focus: true
 
     property var runningManager: null
+    property int metricsSubscription: 0
+
+    // Only the metrics shown below are read while the overlay is up; hidden,
+    // the manager falls back to what alerts need.
+    function updateMetricsSubscription() {
+        if (!runningManager)
+            return
+        const wanted = visible && visibility !== Window.Minimized
+        if (wanted && metricsSubscription === 0) {
+            metricsSubscription = runningManager.subscribe(["cpuPercent", "gpuPercent", "ramMb", "ramPercent",
+                                                            "temperatureC", "powerWatts", "fps", "frameTimeMaxMs"])
+        } else if (!wanted && metricsSubscription !== 0) {
+            runningManager.unsubscribe(metricsSubscription)
+            metricsSubscription = 0
+        }
+    }
+
+    onRunningManagerChanged: updateMetricsSubscription()
+    onVisibleChanged: updateMetricsSubscription()
+    onVisibilityChanged: updateMetricsSubscription()
+    Component.onCompleted: updateMetricsSubscription()
+
+    // Sample at low-power rates while nobody is looking.
+    Binding {
+        target: overlayWindow.runningManager
+        property: "overlayVisible"
+        value: overlayWindow.visible && overlayWindow.visibility !== Window.Minimized
+        when: overlayWindow.runningManager !== null
+    }
 
     Keys.onPressed: function(event) {
         if (event.key === Qt.Key_Guide) {
@@ -127,15 +156,15 @@ ApplicationWindow {
 
                     Repeater {
                         id: alertsRepeater
-                        model: runningManager ? runningManager.alerts : []
+                        model: runningManager ? runningManager.alertsModel : null
 
                         Rectangle {
                             width: alertsColumn.width
                             height: 50
                             radius: 8
-                            color: modelData.severity === "critical" ? "#663333" : "#665533"
+                            color: model.severity === "critical" ? "#663333" : "#665533"
                             border.width: 2
-                            border.color: modelData.severity === "critical" ? "#ff4444" : "#ffaa44"
+                            border.color: model.severity === "critical" ? "#ff4444" : "#ffaa44"
 
                             RowLayout {
                                 anchors.fill: parent
@@ -143,12 +172,12 @@ ApplicationWindow {
                                 spacing: 15
 
                                 Label {
-                                    text: modelData.severity === "critical" ? "⚠️" : "⚡"
+                                    text: model.severity === "critical" ? "⚠️" : "⚡"
                                     font.pixelSize: 24
                                 }
 
                                 Label {
-                                    text: modelData.message
+                                    text: model.message
                                     font.pixelSize: 14
                                     color: "#ffffff"
                                     Layout.fillWidth: true
@@ -156,7 +185,7 @@ ApplicationWindow {
                                 }
 
                                 Label {
-                                    text: modelData.type
+                                    text: model.type
                                     font.pixelSize: 12
                                     color: "#aaaaaa"
                                 }
@@ -174,15 +203,15 @@ ApplicationWindow {
                 ListView {
                     id: gamesListView
                     spacing: 15
-                    model: runningManager ? runningManager.games : []
+                    model: runningManager ? runningManager.gamesModel : null
 
                     delegate: Rectangle {
                         width: gamesListView.width
                         height: 150
                         color: "#2a2a2a"
                         radius: 10
-                        border.width: modelData.state === "running" ? 2 : 1
-                        border.color: modelData.state === "running" ? "#4a90e2" : "#444444"
+                        border.width: model.state === "running" ? 2 : 1
+                        border.color: model.state === "running" ? "#4a90e2" : "#444444"
 
                         ColumnLayout {
                             anchors.fill: parent
@@ -194,7 +223,7 @@ ApplicationWindow {
                                 spacing: 15
 
                                 Label {
-                                    text: modelData.displayName
+                                    text: model.displayName
                                     font.pixelSize: 20
                                     font.bold: true
                                     color: "#ffffff"
@@ -202,13 +231,13 @@ ApplicationWindow {
                                 }
 
                                 Label {
-                                    text: modelData.state === "running" ? qsTr("Running") : qsTr("Suspended")
+                                    text: model.state === "running" ? qsTr("Running") : qsTr("Suspended")
                                     font.pixelSize: 14
-                                    color: modelData.state === "running" ? "#66ff66" : "#ffaa44"
+                                    color: model.state === "running" ? "#66ff66" : "#ffaa44"
                                 }
 
                                 Label {
-                                    text: qsTr("PID: %1").arg(modelData.pid)
+                                    text: qsTr("PID: %1").arg(model.pid)
                                     font.pixelSize: 12
                                     color: "#888888"
                                 }
@@ -220,38 +249,38 @@ ApplicationWindow {
 
                                 MetricDisplay {
                                     label: qsTr("CPU")
-                                    value: modelData.metrics.cpuPercent.toFixed(1) + "%"
-                                    color: modelData.metrics.cpuPercent > 90 ? "#ff4444" : "#4a90e2"
+                                    value: model.cpuPercent.toFixed(1) + "%"
+                                    color: model.cpuPercent > 90 ? "#ff4444" : "#4a90e2"
                                 }
 
                                 MetricDisplay {
                                     label: qsTr("GPU")
-                                    value: modelData.metrics.gpuPercent.toFixed(1) + "%"
-                                    color: modelData.metrics.gpuPercent > 90 ? "#ff4444" : "#4a90e2"
+                                    value: model.gpuPercent.toFixed(1) + "%"
+                                    color: model.gpuPercent > 90 ? "#ff4444" : "#4a90e2"
                                 }
 
                                 MetricDisplay {
                                     label: qsTr("RAM")
-                                    value: modelData.metrics.ramMb.toFixed(0) + " MB"
-                                    color: modelData.metrics.ramPercent > 90 ? "#ff4444" : "#4a90e2"
+                                    value: model.ramMb.toFixed(0) + " MB"
+                                    color: model.ramPercent > 90 ? "#ff4444" : "#4a90e2"
                                 }
 
                                 MetricDisplay {
                                     label: qsTr("Temp")
-                                    value: modelData.metrics.temperatureC.toFixed(1) + "°C"
-                                    color: modelData.metrics.temperatureC > 85 ? "#ff4444" : "#4a90e2"
+                                    value: model.temperatureC.toFixed(1) + "°C"
+                                    color: model.temperatureC > 85 ? "#ff4444" : "#4a90e2"
                                 }
 
                                 MetricDisplay {
                                     label: qsTr("Power")
-                                    value: modelData.metrics.powerWatts.toFixed(1) + " W"
+                                    value: model.powerWatts.toFixed(1) + " W"
                                     color: "#4a90e2"
                                 }
 
                                 MetricDisplay {
                                     label: qsTr("FPS")
-                                    value: Math.round(modelData.metrics.fps).toString()
-                                    color: modelData.metrics.fps < 30 ? "#ffaa44" : "#66ff66"
+                                    value: model.fps > 0 ? Math.round(model.fps) + " (" + model.frameTimeMaxMs.toFixed(0) + " ms)" : "–"
+                                    color: model.fps > 0 && model.fps < 30 ? "#ffaa44" : "#66ff66"
                                 }
                             }
 
@@ -261,20 +290,20 @@ ApplicationWindow {
 
                                 Button {
                                     text: qsTr("Focus")
-                                    enabled: modelData.state === "running"
-                                    onClicked: runningManager.focusGame(modelData.titleId)
+                                    enabled: model.state === "running"
+                                    onClicked: runningManager.focusGame(model.titleId)
                                 }
 
                                 Button {
-                                    text: modelData.state === "running" ? qsTr("Suspend") : qsTr("Resume")
-                                    enabled: modelData.supportsSuspend
-                                    ToolTip.visible: !modelData.supportsSuspend && hovered
-                                    ToolTip.text: modelData.suspendUnsupportedReason || qsTr("Suspend not supported")
+                                    text: model.state === "running" ? qsTr("Suspend") : qsTr("Resume")
+                                    enabled: model.supportsSuspend
+                                    ToolTip.visible: !model.supportsSuspend && hovered
+                                    ToolTip.text: model.suspendUnsupportedReason || qsTr("Suspend not supported")
                                     onClicked: {
-                                        if (modelData.state === "running") {
-                                            runningManager.suspendGame(modelData.titleId)
+                                        if (model.state === "running") {
+                                            runningManager.suspendGame(model.titleId)
                                         } else {
-                                            runningManager.resumeGame(modelData.titleId)
+                                            runningManager.resumeGame(model.titleId)
                                         }
                                     }
                                 }
@@ -282,7 +311,7 @@ ApplicationWindow {
                                 Button {
                                     text: qsTr("Force Quit")
                                     highlighted: true
-                                    onClicked: forceQuitDialog.showForGame(modelData)
+                                    onClicked: forceQuitDialog.showForGame({ titleId: model.titleId, displayName: model.displayName })
                                 }
 
                                 Item {
@@ -295,11 +324,11 @@ ApplicationWindow {
             }
 
             Label {
-                text: runningManager && runningManager.games.length === 0 ? qsTr("No running games") : ""
+                text: runningManager && runningManager.gamesModel.count === 0 ? qsTr("No running games") : ""
                 font.pixelSize: 18
                 color: "#888888"
                 Layout.alignment: Qt.AlignHCenter
-                visible: runningManager && runningManager.games.length === 0
+                visible: runningManager && runningManager.gamesModel.count === 0
             }
         }
     }
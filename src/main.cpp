@@ -1,20 +1,68 @@
+#include "runtime/ReplayMetricsProvider.hpp"
 #include "runtime/RunningManager.hpp"
 
+#include <QCommandLineParser>
 #include <QCoreApplication>
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
 
+#include <memory>
+
 using namespace Qt::StringLiterals;
 
 int main(int argc, char* argv[])
 {
     QGuiApplication app(argc, argv);
 
-    Runtime::RunningManager manager;
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    const QCommandLineOption replayOption(u"replay"_s,
+                                          u"Replay a recorded trace (FlightRecorder file or CSV) instead of reading /proc."_s,
+                                          u"file"_s);
+    const QCommandLineOption speedOption(u"replay-speed"_s,
+                                         u"Replay speed factor; 0 steps one sample per tick."_s,
+                                         u"factor"_s,
+                                         u"1"_s);
+    const QCommandLineOption metricsPortOption(u"metrics-port"_s,
+                                               u"Serve OpenMetrics at http://127.0.0.1:<port>/metrics."_s,
+                                               u"port"_s);
+    parser.addOption(replayOption);
+    parser.addOption(speedOption);
+    parser.addOption(metricsPortOption);
+    parser.process(app);
+
+    std::unique_ptr<Runtime::RunningManager> manager;
+    if (parser.isSet(replayOption)) {
+        const QString trace = parser.value(replayOption);
+        auto provider = std::make_shared<Runtime::ReplayMetricsProvider>();
+        const bool loaded = trace.endsWith(u".csv"_s, Qt::CaseInsensitive) ? provider->loadCsv(trace)
+                                                                            : provider->loadRecording(trace);
+        if (!loaded) {
+            qCritical("Cannot read trace %s", qPrintable(trace));
+            return 1;
+        }
+        provider->setSpeed(parser.value(speedOption).toDouble());
+        manager = std::make_unique<Runtime::RunningManager>(provider);
+        for (const auto& game : provider->games()) {
+            manager->registerGame(game.titleId, game.titleId, game.pid, false, u"Replayed from a trace"_s);
+        }
+    } else {
+        manager = std::make_unique<Runtime::RunningManager>();
+        manager->setThreadedSampling(true);
+        manager->setAggregateProcessTree(true);
+    }
+
+    if (parser.isSet(metricsPortOption)) {
+        const QString port = parser.value(metricsPortOption);
+        if (!manager->startExporter(port.toInt())) {
+            qCritical("Cannot serve metrics on port %s", qPrintable(port));
+            return 1;
+        }
+    }
 
     QQmlApplicationEngine engine;
-    engine.rootContext()->setContextProperty("runningManager", &manager);
+    engine.rootContext()->setContextProperty("runningManager", manager.get());
 
     const QUrl url(u"qrc:/qt/qml/RuntimeOverlay/RunningOverlay.qml"_qs);
     QObject::connect(
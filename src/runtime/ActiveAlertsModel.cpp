@@ -0,0 +1,123 @@
+#include "ActiveAlertsModel.hpp"
+
+namespace Runtime {
+
+ActiveAlertsModel::ActiveAlertsModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int ActiveAlertsModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rows.size();
+}
+
+QVariant ActiveAlertsModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_rows.size()) {
+        return {};
+    }
+
+    const AlertRow& alert = m_rows.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case MessageRole:
+        return alert.message;
+    case TypeRole:
+        return alert.type;
+    case TitleIdRole:
+        return alert.titleId;
+    case SeverityRole:
+        return alert.severity;
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> ActiveAlertsModel::roleNames() const
+{
+    return {
+        {TypeRole, "type"},
+        {TitleIdRole, "titleId"},
+        {MessageRole, "message"},
+        {SeverityRole, "severity"}
+    };
+}
+
+int ActiveAlertsModel::count() const
+{
+    return m_rows.size();
+}
+
+void ActiveAlertsModel::upsertAlert(const AlertRow& alert)
+{
+    const int row = rowFor(alert.titleId, alert.type);
+    if (row < 0) {
+        const int inserted = m_rows.size();
+        beginInsertRows(QModelIndex(), inserted, inserted);
+        m_rows.append(alert);
+        endInsertRows();
+        emit countChanged();
+        return;
+    }
+
+    AlertRow& current = m_rows[row];
+    QList<int> roles;
+    if (current.message != alert.message) {
+        roles.append(MessageRole);
+        roles.append(Qt::DisplayRole);
+    }
+    if (current.severity != alert.severity) {
+        roles.append(SeverityRole);
+    }
+    current = alert;
+    if (!roles.isEmpty()) {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, roles);
+    }
+}
+
+void ActiveAlertsModel::removeAlert(const QString& titleId, const QString& type)
+{
+    const int row = rowFor(titleId, type);
+    if (row < 0) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rows.removeAt(row);
+    endRemoveRows();
+    emit countChanged();
+}
+
+void ActiveAlertsModel::removeAlertsFor(const QString& titleId)
+{
+    bool removed = false;
+    for (int row = m_rows.size() - 1; row >= 0; --row) {
+        if (m_rows[row].titleId != titleId) {
+            continue;
+        }
+        beginRemoveRows(QModelIndex(), row, row);
+        m_rows.removeAt(row);
+        endRemoveRows();
+        removed = true;
+    }
+    if (removed) {
+        emit countChanged();
+    }
+}
+
+int ActiveAlertsModel::rowFor(const QString& titleId, const QString& type) const
+{
+    for (int row = 0; row < m_rows.size(); ++row) {
+        if (m_rows[row].titleId == titleId && m_rows[row].type == type) {
+            return row;
+        }
+    }
+    return -1;
+}
+
+} // namespace Runtime
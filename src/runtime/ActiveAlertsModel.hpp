@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVector>
+
+namespace Runtime {
+
+// List model of the currently active alerts across all games. Rows are
+// inserted when an alert is raised, updated in place when its message or
+// severity changes, and removed when it clears or its game exits.
+class ActiveAlertsModel : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Role {
+        TypeRole = Qt::UserRole + 1,
+        TitleIdRole,
+        MessageRole,
+        SeverityRole
+    };
+    Q_ENUM(Role)
+
+    struct AlertRow {
+        QString type;
+        QString titleId;
+        QString message;
+        QString severity;
+    };
+
+    explicit ActiveAlertsModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int count() const;
+
+    void upsertAlert(const AlertRow& alert);
+    void removeAlert(const QString& titleId, const QString& type);
+    void removeAlertsFor(const QString& titleId);
+
+signals:
+    void countChanged();
+
+private:
+    int rowFor(const QString& titleId, const QString& type) const;
+
+    QVector<AlertRow> m_rows;
+};
+
+} // namespace Runtime
@@ -0,0 +1,218 @@
+#include "AlertRules.hpp"
+
+namespace Runtime {
+
+namespace {
+// Each default rule clears a few units inside its enter threshold so that a
+// value hovering at the threshold does not raise and clear on every tick.
+AlertRule makeRule(AlertKind kind, MetricField field, double enter, double exit,
+                   double critical = qQNaN(), bool below = false)
+{
+    AlertRule rule;
+    rule.kind = kind;
+    rule.field = field;
+    rule.below = below;
+    rule.enterThreshold = enter;
+    rule.exitThreshold = exit;
+    rule.criticalThreshold = critical;
+    return rule;
+}
+} // namespace
+
+QString alertKindName(AlertKind kind)
+{
+    switch (kind) {
+    case AlertKind::Temperature:
+        return QStringLiteral("temperature");
+    case AlertKind::GpuTemperature:
+        return QStringLiteral("gpuTemperature");
+    case AlertKind::Cpu:
+        return QStringLiteral("cpu");
+    case AlertKind::Gpu:
+        return QStringLiteral("gpu");
+    case AlertKind::Memory:
+        return QStringLiteral("memory");
+    case AlertKind::Power:
+        return QStringLiteral("power");
+    case AlertKind::Fps:
+        return QStringLiteral("fps");
+    case AlertKind::CpuThread:
+        return QStringLiteral("cpuThread");
+    case AlertKind::Pss:
+        return QStringLiteral("pss");
+    case AlertKind::Swap:
+        return QStringLiteral("swap");
+    case AlertKind::MemoryStall:
+        return QStringLiteral("memoryStall");
+    case AlertKind::IoStall:
+        return QStringLiteral("ioStall");
+    case AlertKind::Count:
+        break;
+    }
+    return {};
+}
+
+bool alertKindFromName(const QString& name, AlertKind* kind)
+{
+    for (int i = 0; i < ALERT_KIND_COUNT; ++i) {
+        const auto candidate = static_cast<AlertKind>(i);
+        if (alertKindName(candidate) == name) {
+            *kind = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+AlertState::AlertState()
+{
+    for (qint64& since : breachSinceMs) {
+        since = -1;
+    }
+}
+
+AlertEngine::AlertEngine()
+{
+    for (const AlertRule& rule : defaultRules()) {
+        m_rules[static_cast<int>(rule.kind)] = rule;
+    }
+}
+
+QVector<AlertRule> AlertEngine::defaultRules()
+{
+    return {
+        makeRule(AlertKind::Temperature, MetricField::TemperatureC, 85.0, 80.0, 90.0),
+        makeRule(AlertKind::GpuTemperature, MetricField::GpuTemperatureC, 85.0, 80.0, 90.0),
+        makeRule(AlertKind::Cpu, MetricField::CpuPercent, 95.0, 90.0),
+        makeRule(AlertKind::Gpu, MetricField::GpuPercent, 95.0, 90.0),
+        makeRule(AlertKind::Memory, MetricField::RamPercent, 90.0, 85.0),
+        makeRule(AlertKind::Power, MetricField::PowerWatts, 120.0, 110.0),
+        makeRule(AlertKind::Fps, MetricField::Fps, 15.0, 18.0, qQNaN(), true),
+        makeRule(AlertKind::CpuThread, MetricField::ThreadCpuPercent, 98.0, 90.0),
+        makeRule(AlertKind::Pss, MetricField::PssPercent, 90.0, 85.0),
+        makeRule(AlertKind::Swap, MetricField::SwapMb, 512.0, 256.0, 2048.0),
+        makeRule(AlertKind::MemoryStall, MetricField::MemoryStallPercent, 10.0, 5.0, 40.0),
+        makeRule(AlertKind::IoStall, MetricField::IoStallPercent, 10.0, 5.0, 40.0),
+    };
+}
+
+const AlertRule& AlertEngine::rule(AlertKind kind) const
+{
+    return m_rules[static_cast<int>(kind)];
+}
+
+void AlertEngine::setRule(const AlertRule& rule)
+{
+    if (rule.kind == AlertKind::Count || rule.field == MetricField::Count) {
+        return;
+    }
+    m_rules[static_cast<int>(rule.kind)] = rule;
+}
+
+MetricFieldMask AlertEngine::fields() const
+{
+    MetricFieldMask fields = 0;
+    for (const AlertRule& rule : m_rules) {
+        if (rule.enabled) {
+            fields |= metricFieldBit(rule.field);
+        }
+    }
+    return fields;
+}
+
+void AlertEngine::evaluate(const ProcessMetrics* const* metrics, AlertState* const* states, int count, qint64 nowMs,
+                           QVector<AlertTransition>& transitions)
+{
+    if (count <= 0) {
+        return;
+    }
+    // Scratch columns keep their capacity between ticks.
+    m_values.resize(count);
+    m_enter.resize(count);
+    m_hold.resize(count);
+    m_critical.resize(count);
+    double* values = m_values.data();
+    quint8* enter = m_enter.data();
+    quint8* hold = m_hold.data();
+    quint8* critical = m_critical.data();
+
+    for (const AlertRule& rule : m_rules) {
+        const AlertMask bit = alertKindBit(rule.kind);
+        const int slot = static_cast<int>(rule.kind);
+
+        if (!rule.enabled) {
+            for (int i = 0; i < count; ++i) {
+                AlertState& state = *states[i];
+                state.breachSinceMs[slot] = -1;
+                if (state.active & bit) {
+                    state.active &= ~bit;
+                    state.critical &= ~bit;
+                    transitions.append(AlertTransition{i, rule.kind, AlertTransition::Type::Cleared, false, 0.0});
+                }
+            }
+            continue;
+        }
+
+        double ProcessMetrics::*member = metricMember(rule.field);
+        for (int i = 0; i < count; ++i) {
+            values[i] = metrics[i]->*member;
+        }
+
+        // NaN thresholds compare false, so a rule without a critical level
+        // never sets the critical flag.
+        const double enterAt = rule.enterThreshold;
+        const double exitAt = rule.exitThreshold;
+        const double criticalAt = rule.criticalThreshold;
+        if (rule.below) {
+            for (int i = 0; i < count; ++i) {
+                const double value = values[i];
+                const bool known = value > 0.0;
+                enter[i] = known & (value < enterAt);
+                hold[i] = known & (value < exitAt);
+                critical[i] = known & (value < criticalAt);
+            }
+        } else {
+            for (int i = 0; i < count; ++i) {
+                const double value = values[i];
+                enter[i] = value >= enterAt;
+                hold[i] = value >= exitAt;
+                critical[i] = value >= criticalAt;
+            }
+        }
+
+        for (int i = 0; i < count; ++i) {
+            AlertState& state = *states[i];
+            if (state.active & bit) {
+                if (!hold[i]) {
+                    state.active &= ~bit;
+                    state.critical &= ~bit;
+                    state.breachSinceMs[slot] = -1;
+                    transitions.append(AlertTransition{i, rule.kind, AlertTransition::Type::Cleared, false, values[i]});
+                } else if (bool(critical[i]) != bool(state.critical & bit)) {
+                    state.critical ^= bit;
+                    transitions.append(AlertTransition{i, rule.kind, AlertTransition::Type::SeverityChanged,
+                                                       bool(critical[i]), values[i]});
+                }
+                continue;
+            }
+
+            if (!enter[i]) {
+                state.breachSinceMs[slot] = -1;
+                continue;
+            }
+            if (state.breachSinceMs[slot] < 0) {
+                state.breachSinceMs[slot] = nowMs;
+            }
+            if (nowMs - state.breachSinceMs[slot] >= rule.minDurationMs) {
+                state.active |= bit;
+                if (critical[i]) {
+                    state.critical |= bit;
+                }
+                transitions.append(AlertTransition{i, rule.kind, AlertTransition::Type::Raised,
+                                                   bool(critical[i]), values[i]});
+            }
+        }
+    }
+}
+
+} // namespace Runtime
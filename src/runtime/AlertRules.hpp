@@ -0,0 +1,137 @@
+#pragma once
+
+#include "ProcessMetricsProvider.hpp"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <QtNumeric>
+
+namespace Runtime {
+
+// Metric alerts, one slot per kind. The order is the order alerts are listed in.
+enum class AlertKind {
+    Temperature,
+    GpuTemperature,
+    Cpu,
+    Gpu,
+    Memory,
+    Power,
+    Fps,
+    CpuThread,
+    Pss,
+    Swap,
+    MemoryStall,
+    IoStall,
+    Count
+};
+
+constexpr int ALERT_KIND_COUNT = static_cast<int>(AlertKind::Count);
+
+// A set of AlertKinds, one bit per kind.
+using AlertMask = quint32;
+
+constexpr AlertMask alertKindBit(AlertKind kind)
+{
+    return 1u << static_cast<int>(kind);
+}
+
+// Names match the "type" key of serialized alerts.
+QString alertKindName(AlertKind kind);
+bool alertKindFromName(const QString& name, AlertKind* kind);
+
+// One row of the rule table. An upper-bound rule raises once the metric
+// reaches enterThreshold and clears once it drops below exitThreshold; a
+// lower-bound rule (below) raises under enterThreshold and clears at or above
+// exitThreshold, and treats 0 as "no data". The gap between the two
+// thresholds is the hysteresis band. A breach must last minDurationMs before
+// the alert is raised. criticalThreshold is compared the same way as
+// enterThreshold; NaN means the alert never turns critical.
+struct AlertRule {
+    AlertKind kind = AlertKind::Temperature;
+    MetricField field = MetricField::TemperatureC;
+    bool below = false;
+    double enterThreshold = 0.0;
+    double exitThreshold = 0.0;
+    double criticalThreshold = qQNaN();
+    qint64 minDurationMs = 0;
+    bool enabled = true;
+};
+
+// Per-game alert state, owned by the caller.
+struct AlertState {
+    AlertState();
+
+    AlertMask active = 0;
+    AlertMask critical = 0;
+    // When the current breach began, or -1 outside a breach.
+    qint64 breachSinceMs[ALERT_KIND_COUNT];
+};
+
+struct AlertTransition {
+    enum class Type {
+        Raised,
+        SeverityChanged,
+        Cleared
+    };
+
+    int game = 0;
+    AlertKind kind = AlertKind::Temperature;
+    Type type = Type::Raised;
+    bool critical = false;
+    double value = 0.0;
+};
+
+// An alert as published to QML and signal handlers. The message and the
+// timestamp are fixed when the alert is raised or changes severity, not when
+// it is read.
+struct AlertInfo {
+    Q_GADGET
+    Q_PROPERTY(QString type MEMBER type)
+    Q_PROPERTY(QString titleId MEMBER titleId)
+    Q_PROPERTY(QString message MEMBER message)
+    Q_PROPERTY(QString severity MEMBER severity)
+    Q_PROPERTY(double value MEMBER value)
+    Q_PROPERTY(qint64 raisedAtMs MEMBER raisedAtMs)
+
+public:
+    QString type;
+    QString titleId;
+    QString message;
+    QString severity;
+    double value = 0.0;
+    qint64 raisedAtMs = 0;
+};
+
+// Evaluates the rule table over all tracked games at once. Each rule reads
+// its metric into a contiguous column and computes the enter, hold and
+// critical flags for every game in branch-free loops; only the games whose
+// flags disagree with their state go through the scalar state machine, which
+// appends a transition. Nothing is formatted here: callers build messages
+// from the transitions, i.e. only when an alert actually changes.
+class AlertEngine {
+public:
+    AlertEngine();
+
+    static QVector<AlertRule> defaultRules();
+
+    const AlertRule& rule(AlertKind kind) const;
+    void setRule(const AlertRule& rule);
+
+    // Metrics read by the enabled rules.
+    MetricFieldMask fields() const;
+
+    // metrics[i] and states[i] belong to game i. Transitions carry that index.
+    void evaluate(const ProcessMetrics* const* metrics, AlertState* const* states, int count, qint64 nowMs,
+                  QVector<AlertTransition>& transitions);
+
+private:
+    AlertRule m_rules[ALERT_KIND_COUNT];
+    QVector<double> m_values;
+    QVector<quint8> m_enter;
+    QVector<quint8> m_hold;
+    QVector<quint8> m_critical;
+};
+
+} // namespace Runtime
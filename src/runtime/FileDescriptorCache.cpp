@@ -0,0 +1,200 @@
+#include "FileDescriptorCache.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace Runtime {
+
+namespace {
+const char* procFileName(FileDescriptorCache::ProcFile file)
+{
+    switch (file) {
+    case FileDescriptorCache::ProcFile::Stat:
+        return "stat";
+    case FileDescriptorCache::ProcFile::Statm:
+        return "statm";
+    case FileDescriptorCache::ProcFile::SmapsRollup:
+        return "smaps_rollup";
+    case FileDescriptorCache::ProcFile::Count:
+        break;
+    }
+    return "";
+}
+} // namespace
+
+FileDescriptorCache::FileDescriptorCache(QByteArray procRoot)
+    : m_procRoot(std::move(procRoot))
+{
+}
+
+FileDescriptorCache::~FileDescriptorCache()
+{
+    clear();
+}
+
+qint64 FileDescriptorCache::readProcFile(qint64 pid, ProcFile file, char* buffer, qint64 size)
+{
+    const int fd = procDescriptor(pid, file);
+    if (fd < 0) {
+        releaseProcFile(pid, file);
+        return -1;
+    }
+
+    const qint64 bytes = readFromStart(fd, buffer, size);
+    if (bytes < 0) {
+        // ESRCH once the process is gone. Its other files fail on their own
+        // reads, or go with releasePid() once the PID is no longer tracked.
+        releaseProcFile(pid, file);
+    }
+    return bytes;
+}
+
+qint64 FileDescriptorCache::readPath(const QByteArray& path, char* buffer, qint64 size)
+{
+    const int fd = pathDescriptor(path);
+    if (fd < 0) {
+        return -1;
+    }
+
+    const qint64 bytes = readFromStart(fd, buffer, size);
+    if (bytes < 0) {
+        releasePath(path);
+    }
+    return bytes;
+}
+
+void FileDescriptorCache::releasePid(qint64 pid)
+{
+    auto it = m_pidDescriptors.find(pid);
+    if (it == m_pidDescriptors.end()) {
+        return;
+    }
+
+    for (int fd : it.value()) {
+        closeDescriptor(fd);
+    }
+    m_pidDescriptors.erase(it);
+}
+
+// Drops the PID's entry along with its last descriptor.
+void FileDescriptorCache::releaseProcFile(qint64 pid, ProcFile file)
+{
+    auto it = m_pidDescriptors.find(pid);
+    if (it == m_pidDescriptors.end()) {
+        return;
+    }
+
+    int& fd = it.value()[static_cast<int>(file)];
+    closeDescriptor(fd);
+    fd = -1;
+    const PidDescriptors& descriptors = it.value();
+    if (std::all_of(descriptors.cbegin(), descriptors.cend(), [](int open) { return open < 0; })) {
+        m_pidDescriptors.erase(it);
+    }
+}
+
+void FileDescriptorCache::releasePath(const QByteArray& path)
+{
+    auto it = m_pathDescriptors.find(path);
+    if (it == m_pathDescriptors.end()) {
+        return;
+    }
+
+    closeDescriptor(it.value());
+    m_pathDescriptors.erase(it);
+}
+
+void FileDescriptorCache::clear()
+{
+    for (const auto& descriptors : std::as_const(m_pidDescriptors)) {
+        for (int fd : descriptors) {
+            closeDescriptor(fd);
+        }
+    }
+    m_pidDescriptors.clear();
+
+    for (int fd : std::as_const(m_pathDescriptors)) {
+        closeDescriptor(fd);
+    }
+    m_pathDescriptors.clear();
+}
+
+int FileDescriptorCache::openDescriptorCount() const
+{
+    int count = m_pathDescriptors.size();
+    for (const auto& descriptors : m_pidDescriptors) {
+        for (int fd : descriptors) {
+            if (fd >= 0) {
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+int FileDescriptorCache::procDescriptor(qint64 pid, ProcFile file)
+{
+    auto it = m_pidDescriptors.find(pid);
+    if (it == m_pidDescriptors.end()) {
+        PidDescriptors descriptors;
+        descriptors.fill(-1);
+        it = m_pidDescriptors.insert(pid, descriptors);
+    }
+
+    int& fd = it.value()[static_cast<int>(file)];
+    if (fd >= 0) {
+        return fd;
+    }
+
+    char path[256];
+    std::snprintf(path, sizeof(path), "%s/%lld/%s", m_procRoot.constData(),
+                  static_cast<long long>(pid), procFileName(file));
+    fd = openReadOnly(path);
+    return fd;
+}
+
+int FileDescriptorCache::pathDescriptor(const QByteArray& path)
+{
+    auto it = m_pathDescriptors.constFind(path);
+    if (it != m_pathDescriptors.constEnd()) {
+        return it.value();
+    }
+
+    const int fd = openReadOnly(path.constData());
+    if (fd >= 0) {
+        m_pathDescriptors.insert(path, fd);
+    }
+    return fd;
+}
+
+int FileDescriptorCache::openReadOnly(const char* path)
+{
+    int fd = -1;
+    do {
+        fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    } while (fd < 0 && errno == EINTR);
+    return fd;
+}
+
+qint64 FileDescriptorCache::readFromStart(int fd, char* buffer, qint64 size)
+{
+    ssize_t bytes = -1;
+    do {
+        bytes = ::pread(fd, buffer, static_cast<size_t>(size), 0);
+    } while (bytes < 0 && errno == EINTR);
+    return bytes;
+}
+
+void FileDescriptorCache::closeDescriptor(int fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+    }
+}
+
+} // namespace Runtime
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QtGlobal>
+#include <array>
+
+namespace Runtime {
+
+// Keeps /proc/<pid>/* and sysfs files open across ticks and re-reads them with
+// pread() at offset 0, so a steady-state sample costs one syscall per file
+// instead of open/read/close. Not thread-safe; owned by a single provider.
+class FileDescriptorCache {
+public:
+    enum class ProcFile {
+        Stat,
+        Statm,
+        SmapsRollup,
+        Count
+    };
+
+    explicit FileDescriptorCache(QByteArray procRoot = QByteArrayLiteral("/proc"));
+    ~FileDescriptorCache();
+
+    FileDescriptorCache(const FileDescriptorCache&) = delete;
+    FileDescriptorCache& operator=(const FileDescriptorCache&) = delete;
+
+    // Both readers return the number of bytes read, or -1 if the file cannot
+    // be opened or read. A failed read evicts only that file's descriptor, so
+    // that the next call reopens it and the other files of the PID stay open.
+    qint64 readProcFile(qint64 pid, ProcFile file, char* buffer, qint64 size);
+    qint64 readPath(const QByteArray& path, char* buffer, qint64 size);
+
+    void releasePid(qint64 pid);
+    void releasePath(const QByteArray& path);
+    void clear();
+
+    int openDescriptorCount() const;
+
+private:
+    using PidDescriptors = std::array<int, static_cast<int>(ProcFile::Count)>;
+
+    int procDescriptor(qint64 pid, ProcFile file);
+    void releaseProcFile(qint64 pid, ProcFile file);
+    int pathDescriptor(const QByteArray& path);
+
+    static int openReadOnly(const char* path);
+    static qint64 readFromStart(int fd, char* buffer, qint64 size);
+    static void closeDescriptor(int fd);
+
+    QByteArray m_procRoot;
+    QHash<qint64, PidDescriptors> m_pidDescriptors;
+    QHash<QByteArray, int> m_pathDescriptors;
+};
+
+} // namespace Runtime
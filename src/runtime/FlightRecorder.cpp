@@ -0,0 +1,500 @@
+#include "FlightRecorder.hpp"
+
+#include <QDateTime>
+#include <QFile>
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Runtime {
+
+namespace {
+constexpr size_t PAGE_SIZE = 4096;
+constexpr quint32 FNV_OFFSET = 2166136261u;
+constexpr quint32 FNV_PRIME = 16777619u;
+constexpr quint8 FLAG_VALID = 0x1;
+
+// Byte offsets of the columns inside a block.
+struct BlockLayout {
+    size_t timeOffsets = 0;
+    size_t games = 0;
+    size_t flags = 0;
+    size_t deltas = 0;
+    size_t events = 0;
+    size_t size = 0;
+};
+
+size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+BlockLayout blockLayout(size_t rows, size_t events, size_t fields)
+{
+    BlockLayout layout;
+    size_t offset = alignUp(sizeof(FlightBlockHeader), alignof(quint64));
+    layout.timeOffsets = offset;
+    offset += rows * sizeof(quint32);
+    layout.games = offset;
+    offset += rows;
+    layout.flags = offset;
+    offset += rows;
+    offset = alignUp(offset, alignof(qint16));
+    layout.deltas = offset;
+    offset += rows * fields * sizeof(qint16);
+    offset = alignUp(offset, alignof(FlightEventRecord));
+    layout.events = offset;
+    offset += events * sizeof(FlightEventRecord);
+    layout.size = alignUp(offset, PAGE_SIZE);
+    return layout;
+}
+
+const BlockLayout& writerLayout()
+{
+    static const BlockLayout layout = blockLayout(FLIGHT_ROWS_PER_BLOCK, FLIGHT_EVENTS_PER_BLOCK, METRIC_FIELD_COUNT);
+    return layout;
+}
+
+size_t headerSize()
+{
+    return alignUp(sizeof(FlightRecorderHeader), PAGE_SIZE);
+}
+
+template<typename T>
+quint32 fnv1a(quint32 hash, const T& value)
+{
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+    for (size_t i = 0; i < sizeof(T); ++i) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+quint32 rowChecksum(quint32 hash, quint32 timeOffset, quint8 game, quint8 flags, const qint16* deltas, size_t rows,
+                    size_t row, size_t fields)
+{
+    hash = fnv1a(hash, timeOffset);
+    hash = fnv1a(hash, game);
+    hash = fnv1a(hash, flags);
+    for (size_t field = 0; field < fields; ++field) {
+        hash = fnv1a(hash, deltas[field * rows + row]);
+    }
+    return hash;
+}
+
+// Folded into the checksum ahead of a game slot's first row in a block.
+quint32 baseChecksum(quint32 hash, const qint32* base, size_t fields)
+{
+    for (size_t field = 0; field < fields; ++field) {
+        hash = fnv1a(hash, base[field]);
+    }
+    return hash;
+}
+
+quint32 eventChecksum(quint32 hash, const FlightEventRecord& event)
+{
+    hash = fnv1a(hash, event.timeOffsetMs);
+    hash = fnv1a(hash, event.game);
+    hash = fnv1a(hash, event.type);
+    hash = fnv1a(hash, event.kind);
+    hash = fnv1a(hash, event.critical);
+    return fnv1a(hash, event.value);
+}
+
+qint32 quantize(double value)
+{
+    if (!std::isfinite(value)) {
+        return 0;
+    }
+    const double scaled = std::round(value * FLIGHT_VALUE_SCALE);
+    return static_cast<qint32>(std::clamp(scaled, double(std::numeric_limits<qint32>::min()),
+                                          double(std::numeric_limits<qint32>::max())));
+}
+
+constexpr quint64 packCount(quint32 count, quint32 checksum)
+{
+    return (static_cast<quint64>(count) << 32) | checksum;
+}
+
+int ftruncateRetrying(int fd, off_t size)
+{
+    int result;
+    do {
+        result = ::ftruncate(fd, size);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+} // namespace
+
+FlightRecorder::~FlightRecorder()
+{
+    close();
+}
+
+bool FlightRecorder::open(const QString& path, quint32 blockCount)
+{
+    close();
+    if (blockCount == 0) {
+        return false;
+    }
+
+    const BlockLayout& layout = writerLayout();
+    const size_t size = headerSize() + static_cast<size_t>(blockCount) * layout.size;
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return false;
+    }
+    void* mapping = MAP_FAILED;
+    if (ftruncateRetrying(fd, static_cast<off_t>(size)) == 0) {
+        mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    m_mapping = static_cast<char*>(mapping);
+    m_size = size;
+    m_blockSize = static_cast<quint32>(layout.size);
+    m_blockCount = blockCount;
+    m_nextGameSlot = 0;
+    m_block = nullptr;
+    m_sequence = 0;
+
+    // ftruncate() zero-fills the file; construct the atomics in place and
+    // publish the magic last so a reader never accepts a half-built header.
+    for (quint32 i = 0; i < blockCount; ++i) {
+        auto* block = new (m_mapping + headerSize() + static_cast<size_t>(i) * m_blockSize) FlightBlockHeader;
+        block->sequence.store(0, std::memory_order_relaxed);
+        block->rows.store(0, std::memory_order_relaxed);
+        block->events.store(0, std::memory_order_relaxed);
+    }
+    auto* header = reinterpret_cast<FlightRecorderHeader*>(m_mapping);
+    header->version = FLIGHT_RECORDER_VERSION;
+    header->fieldCount = METRIC_FIELD_COUNT;
+    header->blockSize = m_blockSize;
+    header->blockCount = blockCount;
+    header->rowsPerBlock = FLIGHT_ROWS_PER_BLOCK;
+    header->eventsPerBlock = FLIGHT_EVENTS_PER_BLOCK;
+    header->valueScale = FLIGHT_VALUE_SCALE;
+    header->gameSlots = FLIGHT_GAME_SLOTS;
+    header->createdAtMs = QDateTime::currentMSecsSinceEpoch();
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = FLIGHT_RECORDER_MAGIC;
+    return true;
+}
+
+bool FlightRecorder::isOpen() const
+{
+    return m_mapping != nullptr;
+}
+
+void FlightRecorder::close()
+{
+    if (!m_mapping) {
+        return;
+    }
+    ::msync(m_mapping, m_size, MS_SYNC);
+    ::munmap(m_mapping, m_size);
+    m_mapping = nullptr;
+    m_size = 0;
+    m_block = nullptr;
+}
+
+int FlightRecorder::registerGame(qint64 pid, const QString& titleId, qint64 nowMs)
+{
+    if (!m_mapping) {
+        return -1;
+    }
+
+    const int slot = m_nextGameSlot;
+    m_nextGameSlot = (m_nextGameSlot + 1) % FLIGHT_GAME_SLOTS;
+
+    FlightRecorderGame& game = reinterpret_cast<FlightRecorderHeader*>(m_mapping)->games[slot];
+    const QByteArray name = titleId.toUtf8().left(FLIGHT_TITLE_ID_SIZE - 1);
+    std::memset(game.titleId, 0, sizeof(game.titleId));
+    std::memcpy(game.titleId, name.constData(), static_cast<size_t>(name.size()));
+    game.pid = pid;
+    game.registeredAtMs = nowMs;
+    return slot;
+}
+
+void FlightRecorder::recordSample(int slot, const ProcessMetrics& metrics, qint64 timeMs)
+{
+    if (!m_mapping || slot < 0 || slot >= FLIGHT_GAME_SLOTS) {
+        return;
+    }
+
+    qint32 values[METRIC_FIELD_COUNT];
+    for (int i = 0; i < METRIC_FIELD_COUNT; ++i) {
+        values[i] = quantize(metricValue(metrics, static_cast<MetricField>(i)));
+    }
+    if (!fitsBlock(slot, timeMs, values)) {
+        startBlock(timeMs);
+    }
+    const quint64 slotBit = quint64(1) << slot;
+    if (!(m_baseSlots & slotBit)) {
+        // The game's first row in this block; published by the rows store below.
+        std::copy(values, values + METRIC_FIELD_COUNT, m_block->base[slot]);
+        m_baseSlots |= slotBit;
+        m_rowChecksum = baseChecksum(m_rowChecksum, values, METRIC_FIELD_COUNT);
+    }
+
+    const BlockLayout& layout = writerLayout();
+    char* data = reinterpret_cast<char*>(m_block);
+    const quint32 row = m_rowCount;
+    const auto timeOffset = static_cast<quint32>(timeMs - m_block->baseTimeMs);
+    const auto game = static_cast<quint8>(slot);
+    const quint8 flags = metrics.valid ? FLAG_VALID : 0;
+    auto* deltas = reinterpret_cast<qint16*>(data + layout.deltas);
+    const qint32* base = m_block->base[slot];
+
+    reinterpret_cast<quint32*>(data + layout.timeOffsets)[row] = timeOffset;
+    reinterpret_cast<quint8*>(data + layout.games)[row] = game;
+    reinterpret_cast<quint8*>(data + layout.flags)[row] = flags;
+    for (int i = 0; i < METRIC_FIELD_COUNT; ++i) {
+        deltas[i * FLIGHT_ROWS_PER_BLOCK + row] = static_cast<qint16>(values[i] - base[i]);
+    }
+
+    m_rowChecksum = rowChecksum(m_rowChecksum, timeOffset, game, flags, deltas, FLIGHT_ROWS_PER_BLOCK, row,
+                                METRIC_FIELD_COUNT);
+    ++m_rowCount;
+    m_block->rows.store(packCount(m_rowCount, m_rowChecksum), std::memory_order_release);
+}
+
+void FlightRecorder::recordAlert(int slot, const AlertTransition& transition, qint64 timeMs)
+{
+    if (!m_mapping || slot < 0 || slot >= FLIGHT_GAME_SLOTS) {
+        return;
+    }
+
+    if (!m_block || m_eventCount >= FLIGHT_EVENTS_PER_BLOCK || !timeFitsBlock(timeMs)) {
+        startBlock(timeMs);
+    }
+
+    FlightEventRecord event;
+    event.timeOffsetMs = static_cast<quint32>(timeMs - m_block->baseTimeMs);
+    event.game = static_cast<quint8>(slot);
+    event.type = static_cast<quint8>(transition.type);
+    event.kind = static_cast<quint8>(transition.kind);
+    event.critical = transition.critical ? 1 : 0;
+    event.value = quantize(transition.value);
+
+    auto* events = reinterpret_cast<FlightEventRecord*>(reinterpret_cast<char*>(m_block) + writerLayout().events);
+    events[m_eventCount] = event;
+    m_eventChecksum = eventChecksum(m_eventChecksum, event);
+    ++m_eventCount;
+    m_block->events.store(packCount(m_eventCount, m_eventChecksum), std::memory_order_release);
+}
+
+quint64 FlightRecorder::blocksWritten() const
+{
+    return m_sequence;
+}
+
+FlightBlockHeader* FlightRecorder::blockAt(quint32 index) const
+{
+    return reinterpret_cast<FlightBlockHeader*>(m_mapping + headerSize() + static_cast<size_t>(index) * m_blockSize);
+}
+
+bool FlightRecorder::timeFitsBlock(qint64 timeMs) const
+{
+    return timeMs >= m_block->baseTimeMs && timeMs - m_block->baseTimeMs <= std::numeric_limits<quint32>::max();
+}
+
+bool FlightRecorder::fitsBlock(int slot, qint64 timeMs, const qint32* values) const
+{
+    if (!m_block || m_rowCount >= FLIGHT_ROWS_PER_BLOCK || !timeFitsBlock(timeMs)) {
+        return false;
+    }
+    if (!(m_baseSlots & (quint64(1) << slot))) {
+        return true;
+    }
+    const qint32* base = m_block->base[slot];
+    for (int i = 0; i < METRIC_FIELD_COUNT; ++i) {
+        const qint64 delta = qint64(values[i]) - base[i];
+        if (delta < std::numeric_limits<qint16>::min() || delta > std::numeric_limits<qint16>::max()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FlightRecorder::startBlock(qint64 timeMs)
+{
+    if (m_block) {
+        // Start writing back the finished block; the only syscall per block.
+        ::msync(m_block, m_blockSize, MS_ASYNC);
+    }
+
+    FlightBlockHeader* block = blockAt(static_cast<quint32>(m_sequence % m_blockCount));
+    // Retire the old contents before touching them, so that a crash midway
+    // leaves an unused block rather than a mix of two.
+    block->sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    block->rows.store(packCount(0, FNV_OFFSET), std::memory_order_relaxed);
+    block->events.store(packCount(0, FNV_OFFSET), std::memory_order_relaxed);
+    block->baseTimeMs = timeMs;
+    block->sequence.store(++m_sequence, std::memory_order_release);
+
+    m_block = block;
+    m_rowCount = 0;
+    m_rowChecksum = FNV_OFFSET;
+    m_eventCount = 0;
+    m_eventChecksum = FNV_OFFSET;
+    m_baseSlots = 0;
+}
+
+bool readFlightRecording(const QString& path, FlightRecording* recording)
+{
+    *recording = FlightRecording();
+
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    size_t size = 0;
+    if (::fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(headerSize())) {
+        size = static_cast<size_t>(info.st_size);
+        mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const char* data = static_cast<const char*>(mapping);
+    const auto* header = reinterpret_cast<const FlightRecorderHeader*>(data);
+    const bool published = header->magic == FLIGHT_RECORDER_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const BlockLayout layout = blockLayout(header->rowsPerBlock, header->eventsPerBlock, header->fieldCount);
+    const bool valid = published
+        && header->version == FLIGHT_RECORDER_VERSION
+        && header->fieldCount == METRIC_FIELD_COUNT
+        && header->rowsPerBlock > 0
+        && header->valueScale > 0
+        && header->gameSlots == FLIGHT_GAME_SLOTS
+        && header->blockSize == layout.size
+        && size >= headerSize() + static_cast<size_t>(header->blockCount) * layout.size;
+    if (!valid) {
+        ::munmap(mapping, size);
+        return false;
+    }
+
+    recording->createdAtMs = header->createdAtMs;
+    const double scale = header->valueScale;
+    const size_t rows = header->rowsPerBlock;
+
+    QVector<std::pair<quint64, const FlightBlockHeader*>> blocks;
+    for (quint32 i = 0; i < header->blockCount; ++i) {
+        const auto* block = reinterpret_cast<const FlightBlockHeader*>(data + headerSize() + i * layout.size);
+        const quint64 sequence = block->sequence.load(std::memory_order_acquire);
+        if (sequence != 0) {
+            blocks.append({sequence, block});
+        }
+    }
+    std::sort(blocks.begin(), blocks.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+
+    auto attribute = [header](int slot, qint64 timeMs, qint64* pid, QString* titleId) {
+        if (slot >= FLIGHT_GAME_SLOTS) {
+            return;
+        }
+        const FlightRecorderGame& game = header->games[slot];
+        if (timeMs >= game.registeredAtMs) {
+            *pid = game.pid;
+            *titleId = QString::fromUtf8(game.titleId, int(strnlen(game.titleId, sizeof(game.titleId))));
+        }
+    };
+
+    for (const auto& entry : std::as_const(blocks)) {
+        const FlightBlockHeader* block = entry.second;
+        const char* blockData = reinterpret_cast<const char*>(block);
+        const quint64 rowWord = block->rows.load(std::memory_order_acquire);
+        const quint64 eventWord = block->events.load(std::memory_order_acquire);
+        const quint32 rowCount = quint32(rowWord >> 32);
+        const quint32 eventCount = quint32(eventWord >> 32);
+        if (rowCount > rows || eventCount > header->eventsPerBlock) {
+            ++recording->skippedBlocks;
+            continue;
+        }
+
+        const auto* timeOffsets = reinterpret_cast<const quint32*>(blockData + layout.timeOffsets);
+        const auto* games = reinterpret_cast<const quint8*>(blockData + layout.games);
+        const auto* flags = reinterpret_cast<const quint8*>(blockData + layout.flags);
+        const auto* deltas = reinterpret_cast<const qint16*>(blockData + layout.deltas);
+        const auto* events = reinterpret_cast<const FlightEventRecord*>(blockData + layout.events);
+
+        quint32 rowHash = FNV_OFFSET;
+        quint64 baseSlots = 0;
+        for (quint32 row = 0; row < rowCount; ++row) {
+            const quint64 slotBit = games[row] < FLIGHT_GAME_SLOTS ? quint64(1) << games[row] : 0;
+            if (slotBit && !(baseSlots & slotBit)) {
+                rowHash = baseChecksum(rowHash, block->base[games[row]], METRIC_FIELD_COUNT);
+                baseSlots |= slotBit;
+            }
+            rowHash = rowChecksum(rowHash, timeOffsets[row], games[row], flags[row], deltas, rows, row,
+                                  METRIC_FIELD_COUNT);
+        }
+        quint32 eventHash = FNV_OFFSET;
+        for (quint32 i = 0; i < eventCount; ++i) {
+            eventHash = eventChecksum(eventHash, events[i]);
+        }
+        if (rowHash != quint32(rowWord) || eventHash != quint32(eventWord)) {
+            ++recording->skippedBlocks;
+            continue;
+        }
+
+        for (quint32 row = 0; row < rowCount; ++row) {
+            if (games[row] >= FLIGHT_GAME_SLOTS) {
+                continue;
+            }
+            FlightSample sample;
+            sample.timeMs = block->baseTimeMs + timeOffsets[row];
+            sample.slot = games[row];
+            attribute(sample.slot, sample.timeMs, &sample.pid, &sample.titleId);
+            sample.metrics.pid = sample.pid;
+            sample.metrics.valid = flags[row] & FLAG_VALID;
+            sample.metrics.sampledAtMs = sample.timeMs;
+            for (int field = 0; field < METRIC_FIELD_COUNT; ++field) {
+                const qint64 quantized = qint64(block->base[sample.slot][field]) + deltas[field * rows + row];
+                setMetricValue(sample.metrics, static_cast<MetricField>(field), quantized / scale);
+            }
+            recording->samples.append(sample);
+        }
+        for (quint32 i = 0; i < eventCount; ++i) {
+            const FlightEventRecord& record = events[i];
+            if (record.kind >= ALERT_KIND_COUNT || record.type > quint8(AlertTransition::Type::Cleared)) {
+                continue;
+            }
+            FlightEvent event;
+            event.timeMs = block->baseTimeMs + record.timeOffsetMs;
+            event.slot = record.game;
+            attribute(event.slot, event.timeMs, &event.pid, &event.titleId);
+            event.kind = static_cast<AlertKind>(record.kind);
+            event.type = static_cast<AlertTransition::Type>(record.type);
+            event.critical = record.critical != 0;
+            event.value = record.value / scale;
+            recording->events.append(event);
+        }
+    }
+
+    ::munmap(mapping, size);
+    return true;
+}
+
+} // namespace Runtime
@@ -0,0 +1,159 @@
+#pragma once
+
+#include "AlertRules.hpp"
+#include "ProcessMetricsProvider.hpp"
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <atomic>
+#include <cstddef>
+
+namespace Runtime {
+
+// Session flight recorder: a fixed-size file, mapped MAP_SHARED, holding a
+// ring of blocks. Each block stores up to FLIGHT_ROWS_PER_BLOCK metric rows
+// column by column: one column of time offsets, one of game slots, one of
+// flags, and one per MetricField holding int16 deltas from the base values of
+// the row's game slot (its first row in the block, quantized to
+// 1/FLIGHT_VALUE_SCALE). Games far apart from each other share a block; a row
+// too far from its own game's base starts a new one. Alert transitions go into
+// a small event array in the same block.
+//
+// Rows and events are committed by one atomic store of "count << 32 |
+// checksum" after their bytes are written, so the file is consistent at every
+// instant: after a crash the kernel still writes the mapped pages back, and a
+// block torn by power loss fails its checksum and is skipped by the reader.
+// The common path is plain stores into the mapping; the only syscall after
+// open() is an asynchronous msync() of each block once it is full.
+constexpr quint32 FLIGHT_RECORDER_MAGIC = 0x43455246; // "FREC"
+constexpr quint16 FLIGHT_RECORDER_VERSION = 2;
+constexpr int FLIGHT_ROWS_PER_BLOCK = 256;
+constexpr int FLIGHT_EVENTS_PER_BLOCK = 64;
+constexpr int FLIGHT_GAME_SLOTS = 48;
+constexpr int FLIGHT_TITLE_ID_SIZE = 48;
+constexpr int FLIGHT_VALUE_SCALE = 10;
+constexpr quint32 FLIGHT_DEFAULT_BLOCK_COUNT = 512;
+
+struct FlightRecorderGame {
+    qint64 pid;
+    qint64 registeredAtMs;
+    char titleId[FLIGHT_TITLE_ID_SIZE]; // NUL-terminated, truncated if longer.
+};
+
+// Occupies the first page of the file.
+struct FlightRecorderHeader {
+    quint32 magic;
+    quint16 version;
+    quint16 fieldCount; // METRIC_FIELD_COUNT of the writer.
+    quint32 blockSize;
+    quint32 blockCount;
+    quint32 rowsPerBlock;
+    quint32 eventsPerBlock;
+    quint32 valueScale;
+    quint32 gameSlots;
+    qint64 createdAtMs;
+    FlightRecorderGame games[FLIGHT_GAME_SLOTS];
+};
+
+struct FlightBlockHeader {
+    // 0 while the block is unused or being reset; otherwise increases by one
+    // per block written, so readers can order the ring.
+    std::atomic<quint64> sequence;
+    std::atomic<quint64> rows;   // count << 32 | checksum
+    std::atomic<quint64> events; // count << 32 | checksum
+    qint64 baseTimeMs;
+    // Set for a game slot by its first row in the block; unused until then.
+    qint32 base[FLIGHT_GAME_SLOTS][METRIC_FIELD_COUNT];
+};
+
+struct FlightEventRecord {
+    quint32 timeOffsetMs;
+    quint8 game;
+    quint8 type; // AlertTransition::Type
+    quint8 kind; // AlertKind
+    quint8 critical;
+    qint32 value; // Quantized like the metric columns.
+};
+
+static_assert(FLIGHT_GAME_SLOTS <= 64, "the writer tracks the game slots with a base in a 64-bit mask");
+static_assert(std::atomic<quint64>::is_always_lock_free, "flight recorder requires lock-free 64-bit atomics");
+
+class FlightRecorder {
+public:
+    FlightRecorder() = default;
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder&) = delete;
+    FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+    // Creates or replaces the file at path. Use one file per session: opening
+    // the previous session's file again discards it.
+    bool open(const QString& path, quint32 blockCount = FLIGHT_DEFAULT_BLOCK_COUNT);
+    bool isOpen() const;
+
+    // Flushes synchronously and unmaps.
+    void close();
+
+    // Assigns a game slot (round robin) and returns it, or -1 when closed.
+    int registerGame(qint64 pid, const QString& titleId, qint64 nowMs);
+
+    void recordSample(int slot, const ProcessMetrics& metrics, qint64 timeMs);
+    void recordAlert(int slot, const AlertTransition& transition, qint64 timeMs);
+
+    quint64 blocksWritten() const;
+
+private:
+    FlightBlockHeader* blockAt(quint32 index) const;
+    void startBlock(qint64 timeMs);
+    bool timeFitsBlock(qint64 timeMs) const;
+    bool fitsBlock(int slot, qint64 timeMs, const qint32* values) const;
+
+    char* m_mapping = nullptr;
+    size_t m_size = 0;
+    quint32 m_blockSize = 0;
+    quint32 m_blockCount = 0;
+    int m_nextGameSlot = 0;
+
+    // Writer-side copy of the current block's state.
+    FlightBlockHeader* m_block = nullptr;
+    quint64 m_sequence = 0;
+    quint32 m_rowCount = 0;
+    quint32 m_rowChecksum = 0;
+    quint32 m_eventCount = 0;
+    quint32 m_eventChecksum = 0;
+    quint64 m_baseSlots = 0; // Bit n is set once slot n has its base row.
+};
+
+struct FlightSample {
+    qint64 timeMs = 0;
+    int slot = -1;
+    qint64 pid = 0;
+    QString titleId;
+    ProcessMetrics metrics;
+};
+
+struct FlightEvent {
+    qint64 timeMs = 0;
+    int slot = -1;
+    qint64 pid = 0;
+    QString titleId;
+    AlertKind kind = AlertKind::Temperature;
+    AlertTransition::Type type = AlertTransition::Type::Raised;
+    bool critical = false;
+    double value = 0.0;
+};
+
+struct FlightRecording {
+    qint64 createdAtMs = 0;
+    QVector<FlightSample> samples; // Oldest first.
+    QVector<FlightEvent> events;   // Oldest first.
+    int skippedBlocks = 0;         // Blocks that failed their checksum.
+};
+
+// Reads a recording, e.g. after the recording process crashed. Returns false
+// if the file is missing or its header is not a compatible recording. Rows of
+// a game slot that was reused later keep pid 0 and an empty titleId.
+bool readFlightRecording(const QString& path, FlightRecording* recording);
+
+} // namespace Runtime
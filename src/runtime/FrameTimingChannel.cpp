@@ -0,0 +1,278 @@
+#include "FrameTimingChannel.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Runtime {
+
+namespace {
+constexpr uint32_t MAX_CAPACITY = 1u << 20;
+
+uint32_t roundUpToPowerOfTwo(uint32_t value)
+{
+    uint32_t result = 1;
+    while (result < value && result < MAX_CAPACITY) {
+        result <<= 1;
+    }
+    return result;
+}
+
+bool copyName(const char* name, char* buffer, size_t size)
+{
+    const size_t length = std::strlen(name);
+    if (length == 0 || length >= size) {
+        return false;
+    }
+    std::memcpy(buffer, name, length + 1);
+    return true;
+}
+
+uint64_t* slotsOf(FrameTimingHeader* header)
+{
+    return reinterpret_cast<uint64_t*>(reinterpret_cast<char*>(header) + sizeof(FrameTimingHeader));
+}
+
+int ftruncateRetrying(int fd, off_t size)
+{
+    int result;
+    do {
+        result = ::ftruncate(fd, size);
+    } while (result < 0 && errno == EINTR);
+    return result;
+}
+} // namespace
+
+bool frameTimingChannelName(const char* prefix, int64_t pid, char* buffer, size_t size)
+{
+    const int written = std::snprintf(buffer, size, "%s-%lld", prefix, static_cast<long long>(pid));
+    return written > 0 && static_cast<size_t>(written) < size;
+}
+
+size_t frameTimingSegmentSize(uint32_t capacity)
+{
+    return sizeof(FrameTimingHeader) + static_cast<size_t>(capacity) * sizeof(uint64_t);
+}
+
+FrameTimingWriter::~FrameTimingWriter()
+{
+    close();
+}
+
+bool FrameTimingWriter::create(const char* name, uint32_t capacity)
+{
+    close();
+    if (!copyName(name, m_name, sizeof(m_name))) {
+        return false;
+    }
+
+    // Replace any segment left behind by a previous instance of this PID.
+    ::shm_unlink(m_name);
+    const int fd = ::shm_open(m_name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        m_name[0] = '\0';
+        return false;
+    }
+
+    const uint32_t slots = roundUpToPowerOfTwo(capacity > 0 ? capacity : 1);
+    const size_t size = frameTimingSegmentSize(slots);
+    void* mapping = MAP_FAILED;
+    if (ftruncateRetrying(fd, static_cast<off_t>(size)) == 0) {
+        mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        ::shm_unlink(m_name);
+        m_name[0] = '\0';
+        return false;
+    }
+
+    // ftruncate() zero-fills the segment; construct the atomics in place and
+    // publish the magic last so a reader never accepts a half-built header.
+    auto* header = new (mapping) FrameTimingHeader;
+    header->version = FRAME_TIMING_VERSION;
+    header->capacity = slots;
+    header->reserved = 0;
+    header->writeIndex.store(0, std::memory_order_relaxed);
+    header->droppedFrames.store(0, std::memory_order_relaxed);
+    header->readIndex.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    header->magic = FRAME_TIMING_MAGIC;
+
+    m_header = header;
+    m_slots = slotsOf(header);
+    m_size = size;
+    return true;
+}
+
+bool FrameTimingWriter::isOpen() const
+{
+    return m_header != nullptr;
+}
+
+bool FrameTimingWriter::push(uint64_t presentNs)
+{
+    if (!m_header) {
+        return false;
+    }
+
+    const uint64_t write = m_header->writeIndex.load(std::memory_order_relaxed);
+    const uint64_t read = m_header->readIndex.load(std::memory_order_acquire);
+    if (write - read >= m_header->capacity) {
+        m_header->droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    m_slots[write & (m_header->capacity - 1)] = presentNs;
+    m_header->writeIndex.store(write + 1, std::memory_order_release);
+    return true;
+}
+
+void FrameTimingWriter::close()
+{
+    if (m_header) {
+        ::munmap(m_header, m_size);
+        m_header = nullptr;
+        m_slots = nullptr;
+        m_size = 0;
+    }
+    if (m_name[0] != '\0') {
+        ::shm_unlink(m_name);
+        m_name[0] = '\0';
+    }
+}
+
+FrameTimingReader::~FrameTimingReader()
+{
+    close();
+}
+
+bool FrameTimingReader::open(const char* name)
+{
+    close();
+    if (!copyName(name, m_name, sizeof(m_name))) {
+        return false;
+    }
+
+    const int fd = ::shm_open(m_name, O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat info;
+    void* mapping = MAP_FAILED;
+    size_t size = 0;
+    if (::fstat(fd, &info) == 0 && info.st_size >= static_cast<off_t>(sizeof(FrameTimingHeader))) {
+        size = static_cast<size_t>(info.st_size);
+        mapping = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    auto* header = static_cast<FrameTimingHeader*>(mapping);
+    const bool published = header->magic == FRAME_TIMING_MAGIC;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    // Read once: the value validated is the value kept.
+    const uint32_t capacity = header->capacity;
+    const bool valid = published
+        && header->version == FRAME_TIMING_VERSION
+        && capacity > 0
+        && capacity <= MAX_CAPACITY
+        && (capacity & (capacity - 1)) == 0
+        && size >= frameTimingSegmentSize(capacity);
+    if (!valid) {
+        ::munmap(mapping, size);
+        return false;
+    }
+
+    m_header = header;
+    m_slots = slotsOf(header);
+    m_size = size;
+    m_capacity = capacity;
+    m_device = static_cast<uint64_t>(info.st_dev);
+    m_inode = static_cast<uint64_t>(info.st_ino);
+    return true;
+}
+
+bool FrameTimingReader::isOpen() const
+{
+    return m_header != nullptr;
+}
+
+bool FrameTimingReader::segmentReplaced() const
+{
+    if (!m_header) {
+        return false;
+    }
+
+    const int fd = ::shm_open(m_name, O_RDONLY | O_CLOEXEC, 0);
+    if (fd < 0) {
+        return errno == ENOENT;
+    }
+    struct stat info;
+    const bool same = ::fstat(fd, &info) != 0
+        || (static_cast<uint64_t>(info.st_dev) == m_device && static_cast<uint64_t>(info.st_ino) == m_inode);
+    ::close(fd);
+    return !same;
+}
+
+int FrameTimingReader::drain(uint64_t* out, int maxCount)
+{
+    if (!m_header || maxCount <= 0) {
+        return 0;
+    }
+
+    const uint64_t capacity = m_capacity;
+    const uint64_t write = m_header->writeIndex.load(std::memory_order_acquire);
+    uint64_t read = m_header->readIndex.load(std::memory_order_relaxed);
+    if (write - read > capacity) {
+        // Only a misbehaving producer can get here; resynchronise on the
+        // newest full ring instead of reading slots twice.
+        read = write - capacity;
+    }
+
+    uint64_t pending = write - read;
+    if (pending > static_cast<uint64_t>(maxCount)) {
+        pending = static_cast<uint64_t>(maxCount);
+    }
+    for (uint64_t i = 0; i < pending; ++i) {
+        out[i] = m_slots[(read + i) & (capacity - 1)];
+    }
+    m_header->readIndex.store(read + pending, std::memory_order_release);
+    return static_cast<int>(pending);
+}
+
+uint64_t FrameTimingReader::droppedFrames() const
+{
+    return m_header ? m_header->droppedFrames.load(std::memory_order_relaxed) : 0;
+}
+
+void FrameTimingReader::close()
+{
+    if (m_header) {
+        ::munmap(m_header, m_size);
+        m_header = nullptr;
+        m_slots = nullptr;
+        m_size = 0;
+        m_capacity = 0;
+    }
+}
+
+void FrameTimingReader::unlinkSegment()
+{
+    if (m_name[0] != '\0') {
+        ::shm_unlink(m_name);
+    }
+    close();
+    m_name[0] = '\0';
+}
+
+} // namespace Runtime
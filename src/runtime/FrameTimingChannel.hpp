@@ -0,0 +1,113 @@
+#pragma once
+
+// Deliberately free of Qt: the writer side is compiled into in-game layers
+// and launcher hooks that only have the C++ standard library.
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace Runtime {
+
+// Per-PID POSIX shared-memory ring of present timestamps. One producer (the
+// game) pushes CLOCK_MONOTONIC nanoseconds; one consumer (the metrics
+// provider) drains them once per tick. Both indices grow monotonically and are
+// masked into the slot array, so the producer never makes a syscall and never
+// waits: when the ring is full the frame is counted as dropped instead.
+constexpr uint32_t FRAME_TIMING_MAGIC = 0x544d5246; // "FRMT"
+constexpr uint32_t FRAME_TIMING_VERSION = 1;
+constexpr uint32_t FRAME_TIMING_DEFAULT_CAPACITY = 1024;
+constexpr const char* FRAME_TIMING_DEFAULT_PREFIX = "/runtime-frames";
+
+struct FrameTimingHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity; // Power of two.
+    uint32_t reserved;
+
+    // Producer and consumer indices live on separate cache lines so that the
+    // two sides do not invalidate each other's line on every frame.
+    alignas(64) std::atomic<uint64_t> writeIndex;
+    std::atomic<uint64_t> droppedFrames;
+    alignas(64) std::atomic<uint64_t> readIndex;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "frame timing ring requires lock-free 64-bit atomics");
+
+// Writes "<prefix>-<pid>" into buffer without allocating. Returns false if
+// the name does not fit.
+bool frameTimingChannelName(const char* prefix, int64_t pid, char* buffer, size_t size);
+
+size_t frameTimingSegmentSize(uint32_t capacity);
+
+// Producer side. create() is the only call that touches the kernel; push() is
+// two atomic loads, one store into the slot and one atomic store.
+class FrameTimingWriter {
+public:
+    FrameTimingWriter() = default;
+    ~FrameTimingWriter();
+
+    FrameTimingWriter(const FrameTimingWriter&) = delete;
+    FrameTimingWriter& operator=(const FrameTimingWriter&) = delete;
+
+    // Creates (or replaces) the named segment. capacity is rounded up to a
+    // power of two.
+    bool create(const char* name, uint32_t capacity = FRAME_TIMING_DEFAULT_CAPACITY);
+    bool isOpen() const;
+
+    // Returns false when the ring is full; the frame is counted as dropped.
+    bool push(uint64_t presentNs);
+
+    // Unmaps and unlinks the segment.
+    void close();
+
+private:
+    FrameTimingHeader* m_header = nullptr;
+    uint64_t* m_slots = nullptr;
+    size_t m_size = 0;
+    char m_name[64] = {};
+};
+
+// Consumer side, owned by the metrics provider.
+class FrameTimingReader {
+public:
+    FrameTimingReader() = default;
+    ~FrameTimingReader();
+
+    FrameTimingReader(const FrameTimingReader&) = delete;
+    FrameTimingReader& operator=(const FrameTimingReader&) = delete;
+
+    // Maps an existing segment. Fails if it does not exist or its header is
+    // not a compatible ring.
+    bool open(const char* name);
+    bool isOpen() const;
+
+    // True when the name no longer refers to the mapped segment: the producer
+    // unlinked it, or a restarted producer created a new one in its place.
+    // Costs an shm_open() and an fstat(), so call it only once frames stop.
+    bool segmentReplaced() const;
+
+    // Copies up to maxCount pending timestamps, oldest first, into out and
+    // releases their slots to the producer. Returns the number copied.
+    int drain(uint64_t* out, int maxCount);
+
+    uint64_t droppedFrames() const;
+
+    // Unmaps the segment. unlinkSegment() additionally removes the name, for
+    // producers that exited without cleaning up.
+    void close();
+    void unlinkSegment();
+
+private:
+    FrameTimingHeader* m_header = nullptr;
+    const uint64_t* m_slots = nullptr;
+    size_t m_size = 0;
+    // Validated by open(). The producer can still write the header, so the
+    // slot array is never indexed with the shared value.
+    uint64_t m_capacity = 0;
+    uint64_t m_device = 0;
+    uint64_t m_inode = 0;
+    char m_name[64] = {};
+};
+
+} // namespace Runtime
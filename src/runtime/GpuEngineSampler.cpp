@@ -0,0 +1,270 @@
+#include "GpuEngineSampler.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <dirent.h>
+#include <unistd.h>
+
+namespace Runtime {
+
+namespace {
+constexpr int FDINFO_BUFFER_SIZE = 4096;
+constexpr int LINK_BUFFER_SIZE = 64;
+constexpr int PATH_BUFFER_SIZE = 256;
+// Processes without a DRM client are probed more often than ones with a
+// client, which rarely open a second device.
+constexpr quint64 PROBE_INTERVAL_NS = 5'000'000'000;
+constexpr quint64 RESCAN_INTERVAL_NS = 30'000'000'000;
+constexpr char DRM_DEVICE_PREFIX[] = "/dev/dri/";
+
+bool parseFd(const char* name, int* fd)
+{
+    if (*name == '\0') {
+        return false;
+    }
+    int value = 0;
+    for (; *name != '\0'; ++name) {
+        if (*name < '0' || *name > '9' || value > 100'000'000) {
+            return false;
+        }
+        value = value * 10 + (*name - '0');
+    }
+    *fd = value;
+    return true;
+}
+
+// One engine class of one device, summed over a process's clients.
+struct EngineSlot {
+    char device[Procfs::DRM_PDEV_SIZE];
+    char name[Procfs::DRM_ENGINE_NAME_SIZE];
+    double busy;
+};
+
+// Two devices' worth of engine classes: a process renders on one GPU and at
+// most decodes video on another.
+constexpr int MAX_ENGINE_SLOTS = 2 * Procfs::DRM_MAX_ENGINES;
+
+bool sameClient(const Procfs::DrmFdinfo& a, const Procfs::DrmFdinfo& b)
+{
+    return a.clientId == b.clientId && std::strcmp(a.pdev, b.pdev) == 0;
+}
+
+const Procfs::DrmEngineCounters* findEngine(const Procfs::DrmFdinfo& info, const char* name)
+{
+    for (int i = 0; i < info.engineCount; ++i) {
+        if (std::strcmp(info.engines[i].name, name) == 0) {
+            return &info.engines[i];
+        }
+    }
+    return nullptr;
+}
+
+// Share of the engine class that was busy between two reads, 0 to 1 per
+// engine in the class.
+double engineUtilization(const Procfs::DrmEngineCounters& previous, const Procfs::DrmEngineCounters& current,
+                         quint64 elapsedNs)
+{
+    const double capacity = static_cast<double>(qMax<qint64>(current.capacity, 1));
+    if (current.hasBusyNs && previous.hasBusyNs) {
+        if (current.busyNs < previous.busyNs || elapsedNs == 0) {
+            return 0.0;
+        }
+        return (current.busyNs - previous.busyNs) / (elapsedNs * capacity);
+    }
+    if (current.totalCycles > previous.totalCycles && current.cycles >= previous.cycles) {
+        return (current.cycles - previous.cycles) / ((current.totalCycles - previous.totalCycles) * capacity);
+    }
+    return 0.0;
+}
+} // namespace
+
+GpuEngineSampler::GpuEngineSampler(qint64 pid, QByteArray procRoot)
+    : m_pid(pid)
+    , m_processDir(procRoot + '/' + QByteArray::number(pid))
+{
+}
+
+qint64 GpuEngineSampler::pid() const
+{
+    return m_pid;
+}
+
+int GpuEngineSampler::clientCount() const
+{
+    return m_clients.size();
+}
+
+int GpuEngineSampler::clientFdAt(int index) const
+{
+    return m_clients.at(index).fd;
+}
+
+bool GpuEngineSampler::sample(quint64 nowNs, FileDescriptorCache& files, GpuEngineUsage* usage)
+{
+    if (m_rescan || nowNs >= m_nextRescanNs) {
+        rescan(nowNs, files);
+    }
+    const quint64 elapsedNs = m_lastSampleNs > 0 && nowNs > m_lastSampleNs ? nowNs - m_lastSampleNs : 0;
+    m_lastSampleNs = nowNs;
+    if (m_clients.isEmpty()) {
+        return false;
+    }
+
+    EngineSlot slots[MAX_ENGINE_SLOTS];
+    int slotCount = 0;
+    qint64 vramKb = 0;
+    qint64 gttKb = 0;
+
+    char buffer[FDINFO_BUFFER_SIZE];
+    for (Client& client : m_clients) {
+        const qint64 bytes = files.readPath(client.fdinfoPath, buffer, sizeof(buffer));
+        Procfs::DrmFdinfo current;
+        if (bytes <= 0 || !Procfs::drmFdinfo(buffer, bytes, &current)
+            || !sameClient(current, client.counters)) {
+            // Closed, or the number was reused; list the descriptors again.
+            client.hasBaseline = false;
+            m_rescan = true;
+            continue;
+        }
+
+        vramKb += current.vramKb;
+        gttKb += current.gttKb;
+        if (client.hasBaseline) {
+            for (int i = 0; i < current.engineCount; ++i) {
+                const Procfs::DrmEngineCounters& engine = current.engines[i];
+                const Procfs::DrmEngineCounters* previous = findEngine(client.counters, engine.name);
+                if (!previous) {
+                    continue;
+                }
+                int slot = 0;
+                while (slot < slotCount
+                       && (std::strcmp(slots[slot].name, engine.name) != 0
+                           || std::strcmp(slots[slot].device, current.pdev) != 0)) {
+                    ++slot;
+                }
+                if (slot == slotCount) {
+                    if (slotCount == MAX_ENGINE_SLOTS) {
+                        continue;
+                    }
+                    std::memcpy(slots[slot].device, current.pdev, sizeof(slots[slot].device));
+                    std::memcpy(slots[slot].name, engine.name, sizeof(slots[slot].name));
+                    slots[slot].busy = 0.0;
+                    ++slotCount;
+                }
+                slots[slot].busy += engineUtilization(*previous, engine, elapsedNs);
+            }
+        }
+        client.counters = current;
+        client.hasBaseline = true;
+    }
+
+    const EngineSlot* busiest = nullptr;
+    for (int i = 0; i < slotCount; ++i) {
+        if (slots[i].busy > 0.0 && (!busiest || slots[i].busy > busiest->busy)) {
+            busiest = &slots[i];
+        }
+    }
+    if (busiest) {
+        std::memcpy(m_device, busiest->device, sizeof(m_device));
+    } else if (std::none_of(m_clients.cbegin(), m_clients.cend(), [this](const Client& client) {
+                   return std::strcmp(client.counters.pdev, m_device) == 0;
+               })) {
+        std::memcpy(m_device, m_clients.first().counters.pdev, sizeof(m_device));
+    }
+
+    // Counter updates and tick jitter can push a saturated engine past 100%.
+    usage->percent = busiest ? qMin(busiest->busy * 100.0, 100.0) : 0.0;
+    std::memcpy(usage->device, m_device, sizeof(usage->device));
+    usage->vramMb = vramKb / 1024.0;
+    usage->gttMb = gttKb / 1024.0;
+    return true;
+}
+
+void GpuEngineSampler::release(FileDescriptorCache& files)
+{
+    for (const Client& client : std::as_const(m_clients)) {
+        files.releasePath(client.fdinfoPath);
+    }
+    m_clients.clear();
+    m_device[0] = '\0';
+    m_rescan = true;
+    m_nextRescanNs = 0;
+    m_lastSampleNs = 0;
+}
+
+void GpuEngineSampler::rescan(quint64 nowNs, FileDescriptorCache& files)
+{
+    m_rescan = false;
+
+    QVector<int> fds;
+    const QByteArray fdDir = m_processDir + "/fd";
+    if (DIR* dir = ::opendir(fdDir.constData())) {
+        while (const dirent* entry = ::readdir(dir)) {
+            int fd = 0;
+            if (parseFd(entry->d_name, &fd) && isDrmDescriptor(fd)) {
+                fds.append(fd);
+            }
+        }
+        ::closedir(dir);
+    }
+    std::sort(fds.begin(), fds.end());
+
+    QVector<Client> clients;
+    clients.reserve(fds.size());
+    char buffer[FDINFO_BUFFER_SIZE];
+    for (int fd : std::as_const(fds)) {
+        const auto kept = std::find_if(m_clients.begin(), m_clients.end(), [fd](const Client& client) {
+            return client.fd == fd;
+        });
+        Client client;
+        if (kept != m_clients.end()) {
+            client = *kept;
+            kept->fdinfoPath.clear();
+        } else {
+            client.fd = fd;
+            client.fdinfoPath = m_processDir + "/fdinfo/" + QByteArray::number(fd);
+        }
+
+        // Duplicated and inherited descriptors share a client; count it once.
+        // Client IDs are only unique per device on older kernels.
+        const qint64 bytes = files.readPath(client.fdinfoPath, buffer, sizeof(buffer));
+        Procfs::DrmFdinfo info;
+        const bool valid = bytes > 0 && Procfs::drmFdinfo(buffer, bytes, &info)
+            && std::none_of(clients.cbegin(), clients.cend(), [&info](const Client& other) {
+                   return sameClient(other.counters, info);
+               });
+        if (!valid) {
+            files.releasePath(client.fdinfoPath);
+            continue;
+        }
+        if (!sameClient(info, client.counters)) {
+            client.counters = info;
+            client.hasBaseline = false;
+        }
+        clients.append(client);
+    }
+    for (const Client& client : std::as_const(m_clients)) {
+        if (!client.fdinfoPath.isEmpty()) {
+            files.releasePath(client.fdinfoPath);
+        }
+    }
+    m_clients = clients;
+    m_nextRescanNs = nowNs + (m_clients.isEmpty() ? PROBE_INTERVAL_NS : RESCAN_INTERVAL_NS);
+}
+
+bool GpuEngineSampler::isDrmDescriptor(int fd) const
+{
+    char path[PATH_BUFFER_SIZE];
+    const int pathLength = std::snprintf(path, sizeof(path), "%s/fd/%d", m_processDir.constData(), fd);
+    if (pathLength <= 0 || pathLength >= static_cast<int>(sizeof(path))) {
+        return false;
+    }
+    char target[LINK_BUFFER_SIZE];
+    const ssize_t length = ::readlink(path, target, sizeof(target));
+    return length >= static_cast<ssize_t>(sizeof(DRM_DEVICE_PREFIX) - 1)
+        && std::memcmp(target, DRM_DEVICE_PREFIX, sizeof(DRM_DEVICE_PREFIX) - 1) == 0;
+}
+
+} // namespace Runtime
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "FileDescriptorCache.hpp"
+#include "ProcfsParsers.hpp"
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+
+namespace Runtime {
+
+// The GPU use of one process over a tick.
+struct GpuEngineUsage {
+    // Busiest engine class on the device, summed over the process's clients.
+    double percent = 0.0;
+    // drm-pdev of that device, e.g. "0000:03:00.0". Vulkan and GL open every
+    // GPU, so this is the device with the most busy engine, and it sticks
+    // while the process is idle. NUL-terminated; empty if the driver does not
+    // report it.
+    char device[Procfs::DRM_PDEV_SIZE] = {};
+    // Buffer objects resident in VRAM and in GTT-mapped system memory,
+    // summed over the process's clients on all devices.
+    double vramMb = 0.0;
+    double gttMb = 0.0;
+};
+
+// GPU usage of one process from the drm-engine-* and drm-cycles-* counters
+// in /proc/<pid>/fdinfo/<fd>. The process's DRM descriptors are found by
+// listing /proc/<pid>/fd and are kept between ticks, so in steady state a
+// tick costs one pread() per DRM client instead of a walk over every
+// descriptor. The directory is listed again when a client stops reading or
+// changes identity, and periodically to pick up devices opened later.
+class GpuEngineSampler {
+public:
+    GpuEngineSampler(qint64 pid, QByteArray procRoot);
+
+    qint64 pid() const;
+    int clientCount() const;
+    int clientFdAt(int index) const;
+
+    // Samples every DRM client of the process. Returns false when the
+    // process has no client that reports usage, so that the caller can fall
+    // back to a device-wide figure. nowNs is a monotonic timestamp. A
+    // client's first sample only establishes its engine baseline; its memory
+    // is counted right away.
+    bool sample(quint64 nowNs, FileDescriptorCache& files, GpuEngineUsage* usage);
+
+    void release(FileDescriptorCache& files);
+
+private:
+    struct Client {
+        int fd = -1;
+        QByteArray fdinfoPath;
+        Procfs::DrmFdinfo counters;
+        bool hasBaseline = false;
+    };
+
+    void rescan(quint64 nowNs, FileDescriptorCache& files);
+    bool isDrmDescriptor(int fd) const;
+
+    qint64 m_pid = 0;
+    QByteArray m_processDir;
+    QVector<Client> m_clients;
+    char m_device[Procfs::DRM_PDEV_SIZE] = {};
+    bool m_rescan = true;
+    quint64 m_nextRescanNs = 0;
+    quint64 m_lastSampleNs = 0;
+};
+
+} // namespace Runtime
@@ -0,0 +1,213 @@
+#include "MetricDistribution.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace Runtime {
+
+namespace {
+// Bucket i >= 1 holds [MIN_VALUE * GAMMA^(i-1), MIN_VALUE * GAMMA^i); bucket 0
+// holds everything below MIN_VALUE. GAMMA = (1 + e) / (1 - e) bounds the
+// relative error of a bucket's representative value by e.
+constexpr double RELATIVE_ERROR = 0.02;
+constexpr double GAMMA = (1.0 + RELATIVE_ERROR) / (1.0 - RELATIVE_ERROR);
+constexpr double MIN_VALUE = 0.01;
+// ceil(log(1e6 / MIN_VALUE) / log(GAMMA)) + 1: covers every metric up to 1e6
+// (RAM in MB being the largest); larger values land in the last bucket.
+constexpr int BUCKET_COUNT = 462;
+
+const double LOG_GAMMA = std::log(GAMMA);
+
+int bucketFor(double value)
+{
+    if (!(value >= MIN_VALUE)) {
+        return 0;
+    }
+    const int index = 1 + static_cast<int>(std::log(value / MIN_VALUE) / LOG_GAMMA);
+    return index < BUCKET_COUNT ? index : BUCKET_COUNT - 1;
+}
+
+double representativeValue(int bucket)
+{
+    if (bucket == 0) {
+        return 0.0;
+    }
+    return MIN_VALUE * std::pow(GAMMA, bucket - 1) * (2.0 * GAMMA / (1.0 + GAMMA));
+}
+
+bool isFramePacingField(int field)
+{
+    const auto metric = static_cast<MetricField>(field);
+    return metric == MetricField::Fps || metric == MetricField::FrameTimeMs || metric == MetricField::FrameTimeMaxMs;
+}
+
+size_t sliceOffset(int slice, int field)
+{
+    return (static_cast<size_t>(slice) * METRIC_FIELD_COUNT + field) * BUCKET_COUNT;
+}
+} // namespace
+
+MetricDistribution::MetricDistribution()
+    : m_sessionCounts(new quint32[static_cast<size_t>(METRIC_FIELD_COUNT) * BUCKET_COUNT]())
+    , m_sliceCounts(new quint16[static_cast<size_t>(WINDOW_SLICES) * METRIC_FIELD_COUNT * BUCKET_COUNT]())
+{
+    clear();
+}
+
+void MetricDistribution::append(const ProcessMetrics& metrics, qint64 timestampMs, MetricFieldMask fields)
+{
+    const qint64 sliceId = timestampMs / SLICE_MS;
+    const int slice = static_cast<int>(sliceId % WINDOW_SLICES);
+    if (m_sliceIds[slice] != sliceId) {
+        // Reuse the slot of the oldest slice. Slots skipped over during a gap
+        // keep stale ids and are excluded from queries by id.
+        std::memset(m_sliceCounts.get() + sliceOffset(slice, 0), 0,
+                    sizeof(quint16) * METRIC_FIELD_COUNT * BUCKET_COUNT);
+        for (Moments& moments : m_sliceMoments[slice]) {
+            moments = Moments();
+        }
+        m_sliceIds[slice] = sliceId;
+    }
+    m_latestSlice = qMax(m_latestSlice, sliceId);
+
+    const bool hasFrameTiming = metrics.fps > 0.0;
+    for (int field = 0; field < METRIC_FIELD_COUNT; ++field) {
+        if (!(fields & metricFieldBit(static_cast<MetricField>(field)))
+            || (!hasFrameTiming && isFramePacingField(field))) {
+            continue;
+        }
+
+        const double value = metricValue(metrics, static_cast<MetricField>(field));
+        const int bucket = bucketFor(value);
+
+        quint32& sessionCount = m_sessionCounts[static_cast<size_t>(field) * BUCKET_COUNT + bucket];
+        if (sessionCount < std::numeric_limits<quint32>::max()) {
+            ++sessionCount;
+        }
+        quint16& sliceCount = m_sliceCounts[sliceOffset(slice, field) + bucket];
+        if (sliceCount < std::numeric_limits<quint16>::max()) {
+            ++sliceCount;
+        }
+        addSample(m_sessionMoments[field], value);
+        addSample(m_sliceMoments[slice][field], value);
+    }
+}
+
+void MetricDistribution::clear()
+{
+    std::memset(m_sessionCounts.get(), 0, sizeof(quint32) * METRIC_FIELD_COUNT * BUCKET_COUNT);
+    std::memset(m_sliceCounts.get(), 0, sizeof(quint16) * WINDOW_SLICES * METRIC_FIELD_COUNT * BUCKET_COUNT);
+    for (Moments& moments : m_sessionMoments) {
+        moments = Moments();
+    }
+    for (auto& slice : m_sliceMoments) {
+        for (Moments& moments : slice) {
+            moments = Moments();
+        }
+    }
+    for (qint64& id : m_sliceIds) {
+        id = -1;
+    }
+    m_latestSlice = -1;
+}
+
+double MetricDistribution::quantile(MetricField field, double q, qint64 windowMs) const
+{
+    quint32 counts[BUCKET_COUNT];
+    const Moments moments = collect(field, windowMs, counts);
+    if (moments.count == 0) {
+        return 0.0;
+    }
+
+    q = qBound(0.0, q, 1.0);
+    const quint64 target = static_cast<quint64>(q * (moments.count - 1));
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+        seen += counts[bucket];
+        if (seen > target) {
+            // Exact extremes are tracked; never report past them.
+            return qBound(moments.min, representativeValue(bucket), moments.max);
+        }
+    }
+    return moments.max;
+}
+
+MetricDistribution::Summary MetricDistribution::summary(MetricField field, qint64 windowMs) const
+{
+    Summary result;
+    quint32 counts[BUCKET_COUNT];
+    const Moments moments = collect(field, windowMs, counts);
+    if (moments.count == 0) {
+        return result;
+    }
+
+    result.count = static_cast<int>(moments.count);
+    result.min = moments.min;
+    result.max = moments.max;
+    result.mean = moments.sum / moments.count;
+
+    // One cumulative pass resolves all four quantiles, which are in order.
+    const double quantiles[] = {0.01, 0.50, 0.95, 0.99};
+    double* outputs[] = {&result.p1, &result.p50, &result.p95, &result.p99};
+    int next = 0;
+    quint64 seen = 0;
+    for (int bucket = 0; bucket < BUCKET_COUNT && next < 4; ++bucket) {
+        seen += counts[bucket];
+        while (next < 4 && seen > static_cast<quint64>(quantiles[next] * (moments.count - 1))) {
+            *outputs[next] = qBound(moments.min, representativeValue(bucket), moments.max);
+            ++next;
+        }
+    }
+    return result;
+}
+
+MetricDistribution::Moments MetricDistribution::collect(MetricField field, qint64 windowMs, quint32* counts) const
+{
+    const int index = static_cast<int>(field);
+    if (windowMs <= 0) {
+        std::memcpy(counts, m_sessionCounts.get() + static_cast<size_t>(index) * BUCKET_COUNT,
+                    sizeof(quint32) * BUCKET_COUNT);
+        return m_sessionMoments[index];
+    }
+
+    std::memset(counts, 0, sizeof(quint32) * BUCKET_COUNT);
+    Moments merged;
+    const qint64 windowSlices = qMin<qint64>((windowMs + SLICE_MS - 1) / SLICE_MS, WINDOW_SLICES);
+    for (int slice = 0; slice < WINDOW_SLICES; ++slice) {
+        const qint64 id = m_sliceIds[slice];
+        const Moments& moments = m_sliceMoments[slice][index];
+        if (id < 0 || id <= m_latestSlice - windowSlices || moments.count == 0) {
+            continue;
+        }
+
+        const quint16* sliceCounts = m_sliceCounts.get() + sliceOffset(slice, index);
+        for (int bucket = 0; bucket < BUCKET_COUNT; ++bucket) {
+            counts[bucket] += sliceCounts[bucket];
+        }
+        if (merged.count == 0) {
+            merged = moments;
+        } else {
+            merged.count += moments.count;
+            merged.min = qMin(merged.min, moments.min);
+            merged.max = qMax(merged.max, moments.max);
+            merged.sum += moments.sum;
+        }
+    }
+    return merged;
+}
+
+void MetricDistribution::addSample(Moments& moments, double value)
+{
+    if (moments.count == 0) {
+        moments.min = value;
+        moments.max = value;
+    } else {
+        moments.min = qMin(moments.min, value);
+        moments.max = qMax(moments.max, value);
+    }
+    ++moments.count;
+    moments.sum += value;
+}
+
+} // namespace Runtime
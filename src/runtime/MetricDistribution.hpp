@@ -0,0 +1,75 @@
+#pragma once
+
+#include "ProcessMetricsProvider.hpp"
+
+#include <QtGlobal>
+#include <memory>
+
+namespace Runtime {
+
+// Streaming distribution of every MetricField for one game, kept as
+// fixed-bucket logarithmic histograms. Each bucket is RELATIVE_ERROR wide
+// relative to its value, so quantiles are accurate to about ±2% whatever the
+// metric's scale. append() is O(1) and memory is fixed at construction: one
+// histogram covering the whole session, plus WINDOW_SLICES rotating
+// histograms of SLICE_MS each for recent-window queries.
+class MetricDistribution {
+public:
+    static constexpr qint64 SLICE_MS = 10000;
+    static constexpr int WINDOW_SLICES = 6;
+    static constexpr qint64 MAX_WINDOW_MS = SLICE_MS * WINDOW_SLICES;
+
+    struct Summary {
+        int count = 0;
+        double min = 0.0;
+        double max = 0.0;
+        double mean = 0.0;
+        double p1 = 0.0;
+        double p50 = 0.0;
+        double p95 = 0.0;
+        double p99 = 0.0;
+    };
+
+    MetricDistribution();
+
+    MetricDistribution(const MetricDistribution&) = delete;
+    MetricDistribution& operator=(const MetricDistribution&) = delete;
+
+    // Adds the fields in the mask only, so that a value carried over from an
+    // earlier sample is not counted again. Frame pacing fields are skipped
+    // while fps is 0, i.e. while the game publishes no frame timing, so that
+    // "unknown" does not read as 0 FPS.
+    void append(const ProcessMetrics& metrics, qint64 timestampMs, MetricFieldMask fields = ALL_METRIC_FIELDS);
+    void clear();
+
+    // windowMs <= 0 covers the whole session. Otherwise the window ends at
+    // the newest sample, is rounded up to whole slices and capped at
+    // MAX_WINDOW_MS. q is in [0, 1]; an empty window yields 0.
+    double quantile(MetricField field, double q, qint64 windowMs = 0) const;
+    Summary summary(MetricField field, qint64 windowMs = 0) const;
+
+private:
+    struct Moments {
+        quint32 count = 0;
+        double min = 0.0;
+        double max = 0.0;
+        double sum = 0.0;
+    };
+
+    // Merges the session histogram or the slices inside the window into
+    // counts (BUCKET_COUNT entries). Returns the merged moments.
+    Moments collect(MetricField field, qint64 windowMs, quint32* counts) const;
+    static void addSample(Moments& moments, double value);
+
+    // Counts are laid out field-major: [field][bucket] for the session and
+    // [slice][field][bucket] for the window. A slice holds at most
+    // SLICE_MS worth of samples, so 16-bit counters suffice there.
+    std::unique_ptr<quint32[]> m_sessionCounts;
+    std::unique_ptr<quint16[]> m_sliceCounts;
+    Moments m_sessionMoments[METRIC_FIELD_COUNT];
+    Moments m_sliceMoments[WINDOW_SLICES][METRIC_FIELD_COUNT];
+    qint64 m_sliceIds[WINDOW_SLICES];
+    qint64 m_latestSlice = -1;
+};
+
+} // namespace Runtime
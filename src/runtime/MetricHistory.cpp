@@ -0,0 +1,167 @@
+#include "MetricHistory.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Runtime {
+
+namespace {
+// Four independent accumulators keep the loops free of a serial dependency
+// on one register, so the compiler can vectorize them without -ffast-math.
+constexpr int LANES = 4;
+
+struct Partial {
+    double min[LANES];
+    double max[LANES];
+    double sum[LANES];
+};
+
+void initPartial(Partial& partial, double seed)
+{
+    for (int lane = 0; lane < LANES; ++lane) {
+        partial.min[lane] = seed;
+        partial.max[lane] = seed;
+        partial.sum[lane] = 0.0;
+    }
+}
+
+void accumulate(Partial& partial, const double* values, int count)
+{
+    int i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            const double v = values[i + lane];
+            partial.min[lane] = v < partial.min[lane] ? v : partial.min[lane];
+            partial.max[lane] = v > partial.max[lane] ? v : partial.max[lane];
+            partial.sum[lane] += v;
+        }
+    }
+    for (; i < count; ++i) {
+        const double v = values[i];
+        partial.min[0] = v < partial.min[0] ? v : partial.min[0];
+        partial.max[0] = v > partial.max[0] ? v : partial.max[0];
+        partial.sum[0] += v;
+    }
+}
+
+double squaredDeviation(const double* values, int count, double mean)
+{
+    double sums[LANES] = {};
+    int i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        for (int lane = 0; lane < LANES; ++lane) {
+            const double d = values[i + lane] - mean;
+            sums[lane] += d * d;
+        }
+    }
+    for (; i < count; ++i) {
+        const double d = values[i] - mean;
+        sums[0] += d * d;
+    }
+    return (sums[0] + sums[1]) + (sums[2] + sums[3]);
+}
+} // namespace
+
+MetricHistory::MetricHistory(int capacity)
+    : m_capacity(qMax(1, capacity))
+    , m_columns(new double[static_cast<size_t>(m_capacity) * METRIC_FIELD_COUNT]())
+    , m_timestamps(new qint64[static_cast<size_t>(m_capacity)]())
+{
+}
+
+int MetricHistory::capacity() const
+{
+    return m_capacity;
+}
+
+int MetricHistory::size() const
+{
+    return m_size;
+}
+
+void MetricHistory::append(const ProcessMetrics& metrics, qint64 timestampMs)
+{
+    for (int field = 0; field < METRIC_FIELD_COUNT; ++field) {
+        m_columns[static_cast<size_t>(field) * m_capacity + m_head] =
+            metricValue(metrics, static_cast<MetricField>(field));
+    }
+    m_timestamps[m_head] = timestampMs;
+
+    m_head = (m_head + 1) % m_capacity;
+    if (m_size < m_capacity) {
+        ++m_size;
+    }
+}
+
+void MetricHistory::clear()
+{
+    m_head = 0;
+    m_size = 0;
+}
+
+double MetricHistory::valueAt(MetricField field, int age) const
+{
+    if (age < 0 || age >= m_size) {
+        return 0.0;
+    }
+    return column(field)[physicalIndex(age)];
+}
+
+qint64 MetricHistory::timestampAt(int age) const
+{
+    if (age < 0 || age >= m_size) {
+        return 0;
+    }
+    return m_timestamps[physicalIndex(age)];
+}
+
+MetricHistory::Stats MetricHistory::stats(MetricField field, int window) const
+{
+    Stats result;
+    const int count = (window <= 0 || window > m_size) ? m_size : window;
+    if (count == 0) {
+        return result;
+    }
+
+    // The window ends just before m_head and may wrap around the array end,
+    // giving at most two contiguous spans.
+    const double* data = column(field);
+    const int start = (m_head - count + m_capacity) % m_capacity;
+    const int firstLength = qMin(count, m_capacity - start);
+    const int secondLength = count - firstLength;
+
+    Partial partial;
+    initPartial(partial, data[start]);
+    accumulate(partial, data + start, firstLength);
+    accumulate(partial, data, secondLength);
+
+    double min = partial.min[0];
+    double max = partial.max[0];
+    for (int lane = 1; lane < LANES; ++lane) {
+        min = std::min(min, partial.min[lane]);
+        max = std::max(max, partial.max[lane]);
+    }
+    const double sum = (partial.sum[0] + partial.sum[1]) + (partial.sum[2] + partial.sum[3]);
+    const double mean = sum / count;
+    const double squares = squaredDeviation(data + start, firstLength, mean)
+        + squaredDeviation(data, secondLength, mean);
+
+    result.count = count;
+    result.min = min;
+    result.max = max;
+    result.mean = mean;
+    result.stddev = std::sqrt(squares / count);
+    return result;
+}
+
+const double* MetricHistory::column(MetricField field) const
+{
+    return m_columns.get() + static_cast<size_t>(field) * m_capacity;
+}
+
+int MetricHistory::physicalIndex(int age) const
+{
+    return (m_head - 1 - age + 2 * m_capacity) % m_capacity;
+}
+
+} // namespace Runtime
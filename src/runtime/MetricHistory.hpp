@@ -0,0 +1,53 @@
+#pragma once
+
+#include "ProcessMetricsProvider.hpp"
+
+#include <QtGlobal>
+#include <memory>
+
+namespace Runtime {
+
+// Fixed-capacity ring buffer of ProcessMetrics samples for one game, stored as
+// struct-of-arrays: one contiguous column of doubles per MetricField plus a
+// timestamp column. All storage is allocated up front; append() never
+// allocates. Aggregates run over at most two contiguous spans per column.
+class MetricHistory {
+public:
+    struct Stats {
+        int count = 0;
+        double min = 0.0;
+        double max = 0.0;
+        double mean = 0.0;
+        double stddev = 0.0;
+    };
+
+    explicit MetricHistory(int capacity);
+
+    MetricHistory(const MetricHistory&) = delete;
+    MetricHistory& operator=(const MetricHistory&) = delete;
+
+    int capacity() const;
+    int size() const;
+
+    void append(const ProcessMetrics& metrics, qint64 timestampMs);
+    void clear();
+
+    // age 0 is the newest sample. Out-of-range ages return 0.
+    double valueAt(MetricField field, int age) const;
+    qint64 timestampAt(int age) const;
+
+    // Aggregates over the newest `window` samples; window <= 0 means all.
+    Stats stats(MetricField field, int window = 0) const;
+
+private:
+    const double* column(MetricField field) const;
+    int physicalIndex(int age) const;
+
+    int m_capacity = 0;
+    int m_head = 0;
+    int m_size = 0;
+    std::unique_ptr<double[]> m_columns;
+    std::unique_ptr<qint64[]> m_timestamps;
+};
+
+} // namespace Runtime
@@ -0,0 +1,365 @@
+#include "MetricsExporter.hpp"
+
+#include <QMutexLocker>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <cmath>
+#include <cstdio>
+#include <string_view>
+
+namespace Runtime {
+
+namespace {
+constexpr qint64 MAX_REQUEST_SIZE = 8192;
+constexpr char EMPTY_DOCUMENT[] = "# EOF\n";
+constexpr char OPENMETRICS_CONTENT_TYPE[] = "application/openmetrics-text; version=1.0.0; charset=utf-8";
+constexpr char TEXT_CONTENT_TYPE[] = "text/plain; charset=utf-8";
+constexpr double VALUE_SCALE = 1000.0;
+constexpr double MAX_EXPORTED_VALUE = 1e15;
+
+struct MetricFamily {
+    const char* name;
+    const char* help;
+};
+
+// Indexed by MetricField.
+constexpr MetricFamily FIELD_FAMILIES[] = {
+    {"runtime_cpu_percent", "CPU usage of the game in percent."},
+    {"runtime_gpu_percent", "GPU usage in percent."},
+    {"runtime_ram_megabytes", "Resident memory of the game in megabytes."},
+    {"runtime_ram_percent", "Resident memory of the game in percent of system memory."},
+    {"runtime_temperature_celsius", "CPU temperature in degrees Celsius."},
+    {"runtime_gpu_temperature_celsius", "GPU temperature in degrees Celsius."},
+    {"runtime_power_watts", "Power consumption in watts."},
+    {"runtime_fps", "Frames presented per second."},
+    {"runtime_frame_time_milliseconds", "Mean frame time in milliseconds."},
+    {"runtime_frame_time_max_milliseconds", "Longest frame time in milliseconds."},
+    {"runtime_thread_cpu_max_percent", "CPU usage of the game's busiest thread in percent of one core."},
+    {"runtime_gpu_device_busy_percent", "Load of the game's GPU from all processes in percent."},
+    {"runtime_gpu_power_watts", "Power draw of the game's GPU in watts."},
+    {"runtime_pss_megabytes", "Proportional set size of the game in megabytes."},
+    {"runtime_pss_percent", "Proportional set size of the game in percent of system memory."},
+    {"runtime_uss_megabytes", "Memory private to the game in megabytes."},
+    {"runtime_swap_megabytes", "Swapped-out memory of the game in megabytes."},
+    {"runtime_vram_megabytes", "GPU buffers of the game resident in VRAM in megabytes."},
+    {"runtime_gtt_megabytes", "GPU buffers of the game in GTT-mapped system memory in megabytes."},
+    {"runtime_cpu_pressure_percent", "Share of time some of the game's tasks waited for CPU, 10 s average."},
+    {"runtime_memory_pressure_percent", "Share of time some of the game's tasks stalled on memory, 10 s average."},
+    {"runtime_io_pressure_percent", "Share of time some of the game's tasks stalled on IO, 10 s average."},
+    {"runtime_cpu_stall_percent", "Share of time some of the game's tasks waited for CPU since the last sample."},
+    {"runtime_memory_stall_percent", "Share of time some of the game's tasks stalled on memory since the last sample."},
+    {"runtime_io_stall_percent", "Share of time some of the game's tasks stalled on IO since the last sample."},
+};
+
+static_assert(sizeof(FIELD_FAMILIES) / sizeof(FIELD_FAMILIES[0]) == METRIC_FIELD_COUNT,
+              "every metric field needs an exported family");
+
+const QVector<QByteArray>& alertTypeLabels()
+{
+    static const QVector<QByteArray> labels = [] {
+        QVector<QByteArray> result;
+        for (int i = 0; i < ALERT_KIND_COUNT; ++i) {
+            result.append(openMetricsLabelValue(alertKindName(static_cast<AlertKind>(i))));
+        }
+        return result;
+    }();
+    return labels;
+}
+
+void appendFamilyHeader(QByteArray& out, const char* name, const char* help)
+{
+    out.append("# TYPE ").append(name).append(" gauge\n");
+    out.append("# HELP ").append(name).append(' ').append(help).append('\n');
+}
+
+void appendUnsigned(QByteArray& out, quint64 value)
+{
+    char digits[20];
+    int length = 0;
+    do {
+        digits[sizeof(digits) - 1 - length++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    out.append(digits + sizeof(digits) - length, length);
+}
+
+// Written by hand because printf() follows the process locale, which may
+// use a decimal comma, and QByteArray::number() allocates.
+void appendValue(QByteArray& out, double value)
+{
+    if (std::isnan(value)) {
+        out.append("NaN");
+        return;
+    }
+    if (std::isinf(value)) {
+        out.append(value > 0 ? "+Inf" : "-Inf");
+        return;
+    }
+
+    // Three decimals are below the precision of every sensor we read.
+    const auto scaled = static_cast<quint64>(std::llround(qMin(std::abs(value), MAX_EXPORTED_VALUE) * VALUE_SCALE));
+    const auto scale = static_cast<quint64>(VALUE_SCALE);
+    if (value < 0 && scaled != 0) {
+        out.append('-');
+    }
+    appendUnsigned(out, scaled / scale);
+    quint64 fraction = scaled % scale;
+    if (fraction == 0) {
+        return;
+    }
+    out.append('.');
+    for (quint64 digit = scale / 10; digit > 0 && fraction > 0; digit /= 10) {
+        out.append(static_cast<char>('0' + fraction / digit));
+        fraction %= digit;
+    }
+}
+
+void appendSampleStart(QByteArray& out, const char* name, const QByteArray& titleLabel)
+{
+    out.append(name).append("{titleId=\"").append(titleLabel).append('"');
+}
+
+} // namespace
+
+QByteArray openMetricsLabelValue(const QString& value)
+{
+    const QByteArray utf8 = value.toUtf8();
+    QByteArray escaped;
+    escaped.reserve(utf8.size());
+    for (char c : utf8) {
+        switch (c) {
+        case '\\':
+            escaped.append("\\\\");
+            break;
+        case '"':
+            escaped.append("\\\"");
+            break;
+        case '\n':
+            escaped.append("\\n");
+            break;
+        default:
+            escaped.append(c);
+            break;
+        }
+    }
+    return escaped;
+}
+
+void renderOpenMetrics(QByteArray& out, const QVector<ExportedGame>& games)
+{
+    appendFamilyHeader(out, "runtime_games", "Number of tracked games.");
+    out.append("runtime_games ");
+    appendUnsigned(out, static_cast<quint64>(games.size()));
+    out.append('\n');
+
+    // OpenMetrics requires the samples of a family to be contiguous.
+    for (int field = 0; field < METRIC_FIELD_COUNT; ++field) {
+        const MetricFamily& family = FIELD_FAMILIES[field];
+        appendFamilyHeader(out, family.name, family.help);
+        for (const ExportedGame& game : games) {
+            // Games that have not been sampled yet have no values to report.
+            if (!game.metrics->valid) {
+                continue;
+            }
+            appendSampleStart(out, family.name, *game.titleLabel);
+            out.append("} ");
+            appendValue(out, metricValue(*game.metrics, static_cast<MetricField>(field)));
+            out.append('\n');
+        }
+    }
+
+    const QVector<QByteArray>& typeLabels = alertTypeLabels();
+    appendFamilyHeader(out, "runtime_alert_severity", "Alert state: 0 inactive, 1 warning, 2 critical.");
+    for (const ExportedGame& game : games) {
+        for (int kind = 0; kind < ALERT_KIND_COUNT; ++kind) {
+            const AlertMask bit = alertKindBit(static_cast<AlertKind>(kind));
+            const int severity = (game.activeAlerts & bit) ? ((game.criticalAlerts & bit) ? 2 : 1) : 0;
+            appendSampleStart(out, "runtime_alert_severity", *game.titleLabel);
+            out.append(",type=\"").append(typeLabels[kind]).append("\"} ");
+            out.append(static_cast<char>('0' + severity));
+            out.append('\n');
+        }
+    }
+
+    out.append(EMPTY_DOCUMENT);
+}
+
+MetricsExporterServer::MetricsExporterServer(std::shared_ptr<ExportedDocument> document, QObject* parent)
+    : QObject(parent)
+    , m_document(std::move(document))
+{
+}
+
+bool MetricsExporterServer::listen(const QHostAddress& address, quint16 port)
+{
+    close();
+
+    m_server = new QTcpServer(this);
+    connect(m_server, &QTcpServer::newConnection, this, &MetricsExporterServer::acceptConnections);
+    if (!m_server->listen(address, port)) {
+        delete m_server;
+        m_server = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void MetricsExporterServer::close()
+{
+    // Open connections are children of the server and go with it.
+    delete m_server;
+    m_server = nullptr;
+}
+
+quint16 MetricsExporterServer::serverPort() const
+{
+    return m_server ? m_server->serverPort() : 0;
+}
+
+void MetricsExporterServer::acceptConnections()
+{
+    while (QTcpSocket* socket = m_server->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            handleRequest(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void MetricsExporterServer::handleRequest(QTcpSocket* socket)
+{
+    char buffer[MAX_REQUEST_SIZE];
+    const qint64 size = socket->peek(buffer, sizeof(buffer));
+    const std::string_view request(buffer, size > 0 ? static_cast<size_t>(size) : 0);
+    if (request.find("\r\n\r\n") == std::string_view::npos) {
+        if (size >= MAX_REQUEST_SIZE) {
+            socket->abort();
+        }
+        return;
+    }
+
+    // One request per connection; anything after it is ignored.
+    disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+    const std::string_view requestLine = request.substr(0, request.find("\r\n"));
+    const size_t methodEnd = requestLine.find(' ');
+    const std::string_view method = requestLine.substr(0, methodEnd);
+    std::string_view target = methodEnd == std::string_view::npos ? std::string_view() : requestLine.substr(methodEnd + 1);
+    target = target.substr(0, target.find(' '));
+    target = target.substr(0, target.find('?'));
+
+    if (method != "GET") {
+        reply(socket, "405 Method Not Allowed", TEXT_CONTENT_TYPE, QByteArrayLiteral("Only GET is supported.\n"));
+        return;
+    }
+    if (target != "/metrics") {
+        reply(socket, "404 Not Found", TEXT_CONTENT_TYPE, QByteArrayLiteral("Metrics are served at /metrics.\n"));
+        return;
+    }
+
+    QByteArray body;
+    {
+        // Shares the rendered document; the owner renders into its other buffer.
+        QMutexLocker locker(&m_document->mutex);
+        body = m_document->body;
+    }
+    reply(socket, "200 OK", OPENMETRICS_CONTENT_TYPE, body);
+}
+
+void MetricsExporterServer::reply(QTcpSocket* socket, const char* status, const char* contentType,
+                                  const QByteArray& body)
+{
+    char header[256];
+    const int length = std::snprintf(header,
+                                     sizeof(header),
+                                     "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %lld\r\nConnection: close\r\n\r\n",
+                                     status,
+                                     contentType,
+                                     static_cast<long long>(body.size()));
+    socket->write(header, qMin<qint64>(length, sizeof(header) - 1));
+    socket->write(body);
+    socket->disconnectFromHost();
+}
+
+MetricsExporter::MetricsExporter()
+    : m_document(std::make_shared<ExportedDocument>())
+{
+    m_document->body = QByteArray(EMPTY_DOCUMENT);
+    m_thread.setObjectName(QStringLiteral("MetricsExporter"));
+}
+
+MetricsExporter::~MetricsExporter()
+{
+    close();
+}
+
+bool MetricsExporter::listen(const QHostAddress& address, quint16 port)
+{
+    if (!m_server) {
+        m_server = new MetricsExporterServer(m_document);
+        m_server->moveToThread(&m_thread);
+        QObject::connect(&m_thread, &QThread::finished, m_server, &QObject::deleteLater);
+        m_thread.start();
+    }
+
+    bool listening = false;
+    quint16 boundPort = 0;
+    MetricsExporterServer* server = m_server;
+    QMetaObject::invokeMethod(
+        server,
+        [server, address, port, &listening, &boundPort]() {
+            listening = server->listen(address, port);
+            boundPort = server->serverPort();
+        },
+        Qt::BlockingQueuedConnection);
+
+    if (!listening) {
+        close();
+        return false;
+    }
+    m_port = boundPort;
+    return true;
+}
+
+void MetricsExporter::close()
+{
+    if (!m_server) {
+        return;
+    }
+
+    MetricsExporterServer* server = m_server;
+    QMetaObject::invokeMethod(
+        server,
+        [server]() {
+            server->close();
+        },
+        Qt::BlockingQueuedConnection);
+    m_thread.quit();
+    m_thread.wait();
+    m_server = nullptr;
+    m_port = 0;
+}
+
+bool MetricsExporter::isListening() const
+{
+    return m_port != 0;
+}
+
+quint16 MetricsExporter::serverPort() const
+{
+    return m_port;
+}
+
+void MetricsExporter::publish(const QVector<ExportedGame>& games)
+{
+    // resize() keeps the capacity, so this only allocates while the document
+    // is still growing or when a scrape still holds the previous buffer.
+    m_backBuffer.resize(0);
+    renderOpenMetrics(m_backBuffer, games);
+
+    QMutexLocker locker(&m_document->mutex);
+    m_document->body.swap(m_backBuffer);
+}
+
+} // namespace Runtime
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "AlertRules.hpp"
+#include "ProcessMetricsProvider.hpp"
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThread>
+#include <QVector>
+#include <QtGlobal>
+#include <memory>
+
+class QTcpServer;
+class QTcpSocket;
+
+namespace Runtime {
+
+// One game as rendered into the exposition. The pointers only need to stay
+// valid for the duration of MetricsExporter::publish().
+struct ExportedGame {
+    const QByteArray* titleLabel = nullptr; // From openMetricsLabelValue().
+    const ProcessMetrics* metrics = nullptr;
+    AlertMask activeAlerts = 0;
+    AlertMask criticalAlerts = 0;
+};
+
+// Escapes a label value for the OpenMetrics text format. Done once per game
+// rather than on every render.
+QByteArray openMetricsLabelValue(const QString& value);
+
+// Appends an OpenMetrics text exposition of games to out, ending in "# EOF".
+// Only appends to out, so a buffer that is reset with resize(0) and reused
+// does not allocate once it has grown to its working size.
+void renderOpenMetrics(QByteArray& out, const QVector<ExportedGame>& games);
+
+// The response shared between the owner thread, which replaces it once per
+// tick, and the server thread, which writes it to every scrape.
+struct ExportedDocument {
+    QMutex mutex;
+    QByteArray body;
+};
+
+// Lives on the exporter thread and answers "GET /metrics" with the current
+// document. Requests never reach the thread that renders the document.
+class MetricsExporterServer : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MetricsExporterServer(std::shared_ptr<ExportedDocument> document, QObject* parent = nullptr);
+
+    bool listen(const QHostAddress& address, quint16 port);
+    void close();
+    quint16 serverPort() const;
+
+private:
+    void acceptConnections();
+    void handleRequest(QTcpSocket* socket);
+    void reply(QTcpSocket* socket, const char* status, const char* contentType, const QByteArray& body);
+
+    std::shared_ptr<ExportedDocument> m_document;
+    QTcpServer* m_server = nullptr;
+};
+
+// Serves the per-game metrics at http://<address>:<port>/metrics for
+// Prometheus and other OpenMetrics scrapers. The owner calls publish() once
+// per sampling tick; publish() renders into a reused buffer and swaps it
+// with the served one, so a scrape only copies prebuilt bytes into the
+// socket on the exporter thread.
+class MetricsExporter {
+public:
+    MetricsExporter();
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    // Port 0 picks a free port; serverPort() returns it. Listening again
+    // moves the server to the new address.
+    bool listen(const QHostAddress& address, quint16 port);
+    void close();
+    bool isListening() const;
+    quint16 serverPort() const;
+
+    void publish(const QVector<ExportedGame>& games);
+
+private:
+    std::shared_ptr<ExportedDocument> m_document;
+    QByteArray m_backBuffer;
+    QThread m_thread;
+    MetricsExporterServer* m_server = nullptr;
+    quint16 m_port = 0;
+};
+
+} // namespace Runtime
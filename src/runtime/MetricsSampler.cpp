@@ -0,0 +1,92 @@
+#include "MetricsSampler.hpp"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+namespace Runtime {
+
+MetricsSampler::MetricsSampler(std::shared_ptr<ProcessMetricsProvider> provider)
+    : m_provider(std::move(provider))
+{
+}
+
+void MetricsSampler::setMetricsProvider(std::shared_ptr<ProcessMetricsProvider> provider)
+{
+    QMutexLocker locker(&m_mutex);
+    m_provider = std::move(provider);
+}
+
+bool MetricsSampler::hasProvider() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_provider != nullptr;
+}
+
+MetricsSnapshot MetricsSampler::sample(quint64 tick, const QVector<QString>& titleIds, const QVector<qint64>& pids,
+                                       const QVector<MetricFieldMask>& fields)
+{
+    MetricsSnapshot snapshot;
+    snapshot.tick = tick;
+    snapshot.titleIds = titleIds;
+    snapshot.pids = pids;
+    snapshot.fields = fields;
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_provider) {
+        return snapshot;
+    }
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+    snapshot.metrics = m_provider->metricsForFields(pids, fields);
+    snapshot.sampleDurationNs = elapsed.nsecsElapsed();
+    snapshot.onBattery = m_provider->onBattery();
+    snapshot.sampledAtMs = QDateTime::currentMSecsSinceEpoch();
+    for (ProcessMetrics& metrics : snapshot.metrics) {
+        metrics.sampledAtMs = snapshot.sampledAtMs;
+    }
+
+    return snapshot;
+}
+
+void MetricsSampler::releasePid(qint64 pid)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_provider) {
+        m_provider->releasePid(pid);
+    }
+}
+
+void MetricsSampler::setProcessTreeAggregation(bool enabled)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_provider) {
+        m_provider->setProcessTreeAggregation(enabled);
+    }
+}
+
+MetricsSamplerWorker::MetricsSamplerWorker(std::shared_ptr<MetricsSampler> sampler, QObject* parent)
+    : QObject(parent)
+    , m_sampler(std::move(sampler))
+{
+}
+
+void MetricsSamplerWorker::requestSample(quint64 tick, const QVector<QString>& titleIds, const QVector<qint64>& pids,
+                                         const QVector<MetricFieldMask>& fields)
+{
+    emit snapshotReady(m_sampler->sample(tick, titleIds, pids, fields));
+}
+
+void MetricsSamplerWorker::releasePid(qint64 pid)
+{
+    m_sampler->releasePid(pid);
+}
+
+void MetricsSamplerWorker::configure(std::shared_ptr<ProcessMetricsProvider> provider, bool aggregateProcessTree)
+{
+    m_sampler->setMetricsProvider(std::move(provider));
+    m_sampler->setProcessTreeAggregation(aggregateProcessTree);
+}
+
+} // namespace Runtime
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "ProcessMetricsProvider.hpp"
+
+#include <QMetaType>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <memory>
+
+namespace Runtime {
+
+// Result of one sampling tick. Entries in titleIds, pids, fields and metrics are
+// aligned with the request that produced them; only the metrics in fields[i]
+// were sampled for pids[i]. The snapshot is never mutated once emitted.
+struct MetricsSnapshot {
+    quint64 tick = 0;
+    qint64 sampledAtMs = 0;
+    qint64 sampleDurationNs = 0;
+    QVector<QString> titleIds;
+    QVector<qint64> pids;
+    QVector<MetricFieldMask> fields;
+    QVector<ProcessMetrics> metrics;
+    bool onBattery = false;
+};
+
+// Serializes access to a ProcessMetricsProvider so that it can be driven either
+// synchronously from the GUI thread or from a dedicated sampler thread.
+class MetricsSampler {
+public:
+    explicit MetricsSampler(std::shared_ptr<ProcessMetricsProvider> provider);
+
+    void setMetricsProvider(std::shared_ptr<ProcessMetricsProvider> provider);
+    bool hasProvider() const;
+
+    MetricsSnapshot sample(quint64 tick, const QVector<QString>& titleIds, const QVector<qint64>& pids,
+                           const QVector<MetricFieldMask>& fields);
+    void releasePid(qint64 pid);
+    void setProcessTreeAggregation(bool enabled);
+
+private:
+    mutable QMutex m_mutex;
+    std::shared_ptr<ProcessMetricsProvider> m_provider;
+};
+
+// Lives on the sampler thread and turns sample requests into snapshots that
+// are delivered back to the requesting thread through snapshotReady().
+class MetricsSamplerWorker : public QObject {
+    Q_OBJECT
+
+public:
+    explicit MetricsSamplerWorker(std::shared_ptr<MetricsSampler> sampler, QObject* parent = nullptr);
+
+    void requestSample(quint64 tick, const QVector<QString>& titleIds, const QVector<qint64>& pids,
+                       const QVector<MetricFieldMask>& fields);
+    void releasePid(qint64 pid);
+    void configure(std::shared_ptr<ProcessMetricsProvider> provider, bool aggregateProcessTree);
+
+signals:
+    void snapshotReady(const Runtime::MetricsSnapshot& snapshot);
+
+private:
+    std::shared_ptr<MetricsSampler> m_sampler;
+};
+
+} // namespace Runtime
+
+Q_DECLARE_METATYPE(Runtime::MetricsSnapshot)
@@ -0,0 +1,191 @@
+#include "PressureMonitor.hpp"
+
+#include "ProcfsParsers.hpp"
+
+#include <QFile>
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+namespace Runtime {
+
+namespace {
+// Stalls of 150 ms within any 1 s window, in microseconds. The kernel
+// expects the terminating NUL to be written as well.
+constexpr char TRIGGER[] = "some 150000 1000000";
+// Since Linux 6.5 unprivileged users may only use windows that are a
+// multiple of 2 s.
+constexpr char UNPRIVILEGED_TRIGGER[] = "some 300000 2000000";
+
+constexpr const char* PRESSURE_FILE_NAMES[PRESSURE_RESOURCE_COUNT] = {"cpu", "memory", "io"};
+// CPU is close to saturated in most games and is left to the sampling rate.
+constexpr PressureResource TRIGGERED_RESOURCES[] = {PressureResource::Memory, PressureResource::Io};
+
+int openTrigger(const QByteArray& path)
+{
+    const int fd = ::open(path.constData(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::write(fd, TRIGGER, sizeof(TRIGGER)) >= 0) {
+        return fd;
+    }
+    if ((errno == EINVAL || errno == EPERM)
+        && ::write(fd, UNPRIVILEGED_TRIGGER, sizeof(UNPRIVILEGED_TRIGGER)) >= 0) {
+        return fd;
+    }
+    ::close(fd);
+    return -1;
+}
+} // namespace
+
+bool pressureFilesForPid(qint64 pid, const SystemPaths& paths, PressureFiles* files)
+{
+    QFile cgroupFile(paths.procRoot + QStringLiteral("/%1/cgroup").arg(pid));
+    if (!cgroupFile.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray content = cgroupFile.readAll();
+
+    PressureFiles result;
+    qint64 offset = 0;
+    qint64 length = 0;
+    if (Procfs::unifiedCgroupPath(content.constData(), content.size(), &offset, &length) && length > 1) {
+        const QByteArray directory = QFile::encodeName(paths.sysRoot) + "/fs/cgroup" + content.mid(offset, length);
+        if (QFile::exists(QFile::decodeName(directory + "/memory.pressure"))) {
+            for (int i = 0; i < PRESSURE_RESOURCE_COUNT; ++i) {
+                result.paths[i] = directory + '/' + PRESSURE_FILE_NAMES[i] + ".pressure";
+            }
+            result.cgroup = true;
+        }
+    }
+    if (!result.cgroup) {
+        const QByteArray directory = QFile::encodeName(paths.procRoot) + "/pressure/";
+        if (!QFile::exists(QFile::decodeName(directory + "memory"))) {
+            return false;
+        }
+        for (int i = 0; i < PRESSURE_RESOURCE_COUNT; ++i) {
+            result.paths[i] = directory + PRESSURE_FILE_NAMES[i];
+        }
+    }
+
+    *files = result;
+    return true;
+}
+
+PressureMonitor::PressureMonitor(const SystemPaths& paths, QObject* parent)
+    : QObject(parent)
+    , m_paths(paths)
+{
+}
+
+PressureMonitor::~PressureMonitor()
+{
+    for (const QVector<Trigger>& triggers : std::as_const(m_watches)) {
+        for (const Trigger& trigger : triggers) {
+            closeTrigger(trigger);
+        }
+    }
+}
+
+bool PressureMonitor::watch(qint64 pid)
+{
+    if (pid <= 0) {
+        return false;
+    }
+    if (m_watches.contains(pid)) {
+        return true;
+    }
+
+    PressureFiles files;
+    if (!pressureFilesForPid(pid, m_paths, &files)) {
+        return false;
+    }
+
+    QVector<Trigger> triggers;
+    for (PressureResource resource : TRIGGERED_RESOURCES) {
+        const int fd = openTrigger(files.paths[static_cast<int>(resource)]);
+        if (fd < 0) {
+            continue;
+        }
+
+        Trigger trigger;
+        trigger.resource = resource;
+        trigger.fd = fd;
+        // Triggers signal POLLPRI, which QSocketNotifier reports as an exception.
+        trigger.notifier = new QSocketNotifier(fd, QSocketNotifier::Exception, this);
+        connect(trigger.notifier, &QSocketNotifier::activated, this, [this, pid, fd]() {
+            onActivated(pid, fd);
+        });
+        triggers.append(trigger);
+    }
+    if (triggers.isEmpty()) {
+        return false;
+    }
+    m_watches.insert(pid, triggers);
+    return true;
+}
+
+void PressureMonitor::unwatch(qint64 pid)
+{
+    const auto it = m_watches.constFind(pid);
+    if (it == m_watches.constEnd()) {
+        return;
+    }
+
+    const QVector<Trigger> triggers = it.value();
+    m_watches.erase(it);
+    for (const Trigger& trigger : triggers) {
+        closeTrigger(trigger);
+    }
+}
+
+bool PressureMonitor::isWatching(qint64 pid) const
+{
+    return m_watches.contains(pid);
+}
+
+void PressureMonitor::onActivated(qint64 pid, int fd)
+{
+    const auto it = m_watches.find(pid);
+    if (it == m_watches.end()) {
+        return;
+    }
+    QVector<Trigger>& triggers = it.value();
+    int index = 0;
+    while (index < triggers.size() && triggers[index].fd != fd) {
+        ++index;
+    }
+    if (index == triggers.size()) {
+        return;
+    }
+
+    // A trigger on a removed cgroup reports POLLERR on every poll from then on.
+    pollfd descriptor = {fd, POLLPRI, 0};
+    if (::poll(&descriptor, 1, 0) > 0 && (descriptor.revents & (POLLERR | POLLNVAL))) {
+        const Trigger trigger = triggers.takeAt(index);
+        closeTrigger(trigger);
+        if (triggers.isEmpty()) {
+            m_watches.erase(it);
+        }
+        return;
+    }
+
+    const PressureResource resource = triggers[index].resource;
+    emit stallDetected(pid, resource);
+}
+
+void PressureMonitor::closeTrigger(const Trigger& trigger)
+{
+    // The notifier may be the sender of the signal being handled.
+    trigger.notifier->setEnabled(false);
+    trigger.notifier->deleteLater();
+    ::close(trigger.fd);
+}
+
+} // namespace Runtime
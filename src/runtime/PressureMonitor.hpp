@@ -0,0 +1,79 @@
+#pragma once
+
+#include "ProcessMetricsProvider.hpp"
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QVector>
+#include <QtGlobal>
+
+class QSocketNotifier;
+
+namespace Runtime {
+
+// The resources the kernel reports pressure stall information (PSI) for.
+enum class PressureResource {
+    Cpu,
+    Memory,
+    Io,
+    Count
+};
+
+constexpr int PRESSURE_RESOURCE_COUNT = static_cast<int>(PressureResource::Count);
+
+// Metric fields read from PSI files.
+constexpr MetricFieldMask PRESSURE_FIELDS = metricFieldBit(MetricField::CpuPressure)
+    | metricFieldBit(MetricField::MemoryPressure) | metricFieldBit(MetricField::IoPressure)
+    | metricFieldBit(MetricField::CpuStallPercent) | metricFieldBit(MetricField::MemoryStallPercent)
+    | metricFieldBit(MetricField::IoStallPercent);
+
+// The PSI files describing a process, indexed by PressureResource: the
+// *.pressure files of its cgroup on cgroup v2, or the system-wide
+// /proc/pressure files for processes in the root cgroup and on hosts
+// without cgroup PSI.
+struct PressureFiles {
+    QByteArray paths[PRESSURE_RESOURCE_COUNT];
+    bool cgroup = false;
+};
+
+// Returns false if /proc/<pid>/cgroup cannot be read, i.e. the process is
+// gone, or if the kernel has no PSI at all.
+bool pressureFilesForPid(qint64 pid, const SystemPaths& paths, PressureFiles* files);
+
+// Reports memory and IO stalls of a process the moment the kernel detects
+// them. A PSI trigger is registered on each pressure file and its descriptor
+// is watched with a QSocketNotifier; the kernel raises POLLPRI once stalls
+// exceed the threshold within the window, and nothing runs in between.
+class PressureMonitor : public QObject {
+    Q_OBJECT
+
+public:
+    explicit PressureMonitor(const SystemPaths& paths = SystemPaths(), QObject* parent = nullptr);
+    ~PressureMonitor() override;
+
+    // Returns false if no trigger could be registered: the process is gone,
+    // the kernel lacks PSI triggers (Linux < 5.2), or the pressure files are
+    // not writable. Callers then see stalls at the sampling rate only.
+    bool watch(qint64 pid);
+    void unwatch(qint64 pid);
+    bool isWatching(qint64 pid) const;
+
+signals:
+    void stallDetected(qint64 pid, Runtime::PressureResource resource);
+
+private:
+    struct Trigger {
+        PressureResource resource = PressureResource::Memory;
+        int fd = -1;
+        QSocketNotifier* notifier = nullptr;
+    };
+
+    void onActivated(qint64 pid, int fd);
+    static void closeTrigger(const Trigger& trigger);
+
+    SystemPaths m_paths;
+    QHash<qint64, QVector<Trigger>> m_watches;
+};
+
+} // namespace Runtime
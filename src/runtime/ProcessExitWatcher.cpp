@@ -0,0 +1,100 @@
+#include "ProcessExitWatcher.hpp"
+
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <utility>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace Runtime {
+
+namespace {
+int openPidfd(qint64 pid)
+{
+#ifdef SYS_pidfd_open
+    // pidfd_open() has no glibc wrapper before 2.36. Its descriptors are
+    // always close-on-exec.
+    return static_cast<int>(::syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+#else
+    Q_UNUSED(pid);
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+} // namespace
+
+ProcessExitWatcher::ProcessExitWatcher(QObject* parent)
+    : QObject(parent)
+{
+}
+
+ProcessExitWatcher::~ProcessExitWatcher()
+{
+    for (const Watch& watch : std::as_const(m_watches)) {
+        closeWatch(watch);
+    }
+}
+
+bool ProcessExitWatcher::watch(qint64 pid)
+{
+    if (pid <= 0) {
+        return false;
+    }
+    if (m_watches.contains(pid)) {
+        return true;
+    }
+
+    const int fd = openPidfd(pid);
+    if (fd < 0) {
+        return false;
+    }
+
+    Watch watch;
+    watch.fd = fd;
+    watch.notifier = new QSocketNotifier(fd, QSocketNotifier::Read, this);
+    connect(watch.notifier, &QSocketNotifier::activated, this, [this, pid]() {
+        onActivated(pid);
+    });
+    m_watches.insert(pid, watch);
+    return true;
+}
+
+void ProcessExitWatcher::unwatch(qint64 pid)
+{
+    const auto it = m_watches.constFind(pid);
+    if (it == m_watches.constEnd()) {
+        return;
+    }
+
+    const Watch watch = it.value();
+    m_watches.erase(it);
+    closeWatch(watch);
+}
+
+bool ProcessExitWatcher::isWatching(qint64 pid) const
+{
+    return m_watches.contains(pid);
+}
+
+void ProcessExitWatcher::onActivated(qint64 pid)
+{
+    if (!m_watches.contains(pid)) {
+        return;
+    }
+
+    // A pidfd only ever becomes readable once, on exit.
+    unwatch(pid);
+    emit processExited(pid);
+}
+
+void ProcessExitWatcher::closeWatch(const Watch& watch)
+{
+    // The notifier may be the sender of the signal being handled.
+    watch.notifier->setEnabled(false);
+    watch.notifier->deleteLater();
+    ::close(watch.fd);
+}
+
+} // namespace Runtime
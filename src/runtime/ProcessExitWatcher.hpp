@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QtGlobal>
+
+class QSocketNotifier;
+
+namespace Runtime {
+
+// Reports process exit the moment it happens by watching a pidfd per PID with
+// a QSocketNotifier; the descriptor becomes readable when the process
+// terminates. A pidfd refers to one specific process, so a recycled PID can
+// never be mistaken for the original game.
+class ProcessExitWatcher : public QObject {
+    Q_OBJECT
+
+public:
+    explicit ProcessExitWatcher(QObject* parent = nullptr);
+    ~ProcessExitWatcher() override;
+
+    // Returns false if the PID cannot be watched, either because the kernel
+    // lacks pidfd_open() (Linux < 5.3) or because the process is already
+    // gone. Callers then rely on sampling to notice the exit.
+    bool watch(qint64 pid);
+    void unwatch(qint64 pid);
+    bool isWatching(qint64 pid) const;
+
+signals:
+    void processExited(qint64 pid);
+
+private:
+    struct Watch {
+        int fd = -1;
+        QSocketNotifier* notifier = nullptr;
+    };
+
+    void onActivated(qint64 pid);
+    static void closeWatch(const Watch& watch);
+
+    QHash<qint64, Watch> m_watches;
+};
+
+} // namespace Runtime
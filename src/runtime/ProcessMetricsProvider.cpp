@@ -1,34 +1,376 @@
 #include "ProcessMetricsProvider.hpp"
 
+#include "FileDescriptorCache.hpp"
+#include "GpuEngineSampler.hpp"
+#include "PressureMonitor.hpp"
+#include "ProcessTree.hpp"
+#include "ProcfsParsers.hpp"
+#include "SensorDiscovery.hpp"
+#include "ThreadCpuSampler.hpp"
+
+#include <QByteArray>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QHash>
-#include <QRegularExpression>
-#include <QTextStream>
 
+#include <algorithm>
+#include <cerrno>
+#include <ctime>
+
+#include <signal.h>
 #include <unistd.h>
 
 namespace Runtime {
 
 namespace {
-constexpr double DEFAULT_FPS_FALLBACK = 60.0;
+constexpr int STAT_BUFFER_SIZE = 1024;
+constexpr int STATM_BUFFER_SIZE = 128;
+constexpr int SMAPS_ROLLUP_BUFFER_SIZE = 2048;
+constexpr int SYSFS_BUFFER_SIZE = 64;
+constexpr int PRESSURE_BUFFER_SIZE = 256;
+constexpr qint64 SENSOR_RETRY_INTERVAL_MS = 10000;
+constexpr quint64 FRAME_CHANNEL_PROBE_INTERVAL_NS = 2'000'000'000;
+constexpr int FRAME_DRAIN_BATCH = 256;
+constexpr int FRAME_CHANNEL_NAME_SIZE = 64;
+
+// Fields served by sysfs sensors shared across all processes, and the
+// per-process fields that share one read.
+constexpr MetricFieldMask SYSTEM_FIELDS = metricFieldBit(MetricField::GpuPercent)
+    | metricFieldBit(MetricField::GpuBusyPercent) | metricFieldBit(MetricField::TemperatureC)
+    | metricFieldBit(MetricField::GpuTemperatureC) | metricFieldBit(MetricField::PowerWatts)
+    | metricFieldBit(MetricField::GpuPowerWatts);
+// Fields read from the GPU a game renders on.
+constexpr MetricFieldMask GPU_DEVICE_FIELDS = metricFieldBit(MetricField::GpuPercent)
+    | metricFieldBit(MetricField::GpuBusyPercent) | metricFieldBit(MetricField::GpuTemperatureC)
+    | metricFieldBit(MetricField::GpuPowerWatts);
+constexpr MetricFieldMask GPU_BUSY_FIELDS = metricFieldBit(MetricField::GpuPercent)
+    | metricFieldBit(MetricField::GpuBusyPercent);
+// Fields read from a game's DRM clients.
+constexpr MetricFieldMask GPU_CLIENT_FIELDS = metricFieldBit(MetricField::GpuPercent)
+    | metricFieldBit(MetricField::VramMb) | metricFieldBit(MetricField::GttMb);
+constexpr MetricFieldMask RAM_FIELDS = metricFieldBit(MetricField::RamMb) | metricFieldBit(MetricField::RamPercent);
+constexpr MetricFieldMask SMAPS_FIELDS = metricFieldBit(MetricField::PssMb) | metricFieldBit(MetricField::PssPercent)
+    | metricFieldBit(MetricField::UssMb) | metricFieldBit(MetricField::SwapMb);
+constexpr MetricFieldMask FRAME_FIELDS = metricFieldBit(MetricField::Fps) | metricFieldBit(MetricField::FrameTimeMs)
+    | metricFieldBit(MetricField::FrameTimeMaxMs);
+constexpr MetricFieldMask THREAD_FIELDS = metricFieldBit(MetricField::ThreadCpuPercent);
+// The 10 s average and the stall share of each PressureResource.
+constexpr MetricField PRESSURE_AVERAGE_FIELDS[PRESSURE_RESOURCE_COUNT] = {
+    MetricField::CpuPressure, MetricField::MemoryPressure, MetricField::IoPressure};
+constexpr MetricField PRESSURE_STALL_FIELDS[PRESSURE_RESOURCE_COUNT] = {
+    MetricField::CpuStallPercent, MetricField::MemoryStallPercent, MetricField::IoStallPercent};
+
+static_assert(GPU_DEVICE_ID_SIZE == Procfs::DRM_PDEV_SIZE, "GPU devices are identified by drm-pdev");
+
+// The ProcessMetrics member of each MetricField, indexed by the field.
+constexpr double ProcessMetrics::*METRIC_MEMBERS[] = {
+    &ProcessMetrics::cpuPercent,
+    &ProcessMetrics::gpuPercent,
+    &ProcessMetrics::ramMb,
+    &ProcessMetrics::ramPercent,
+    &ProcessMetrics::temperatureC,
+    &ProcessMetrics::gpuTemperatureC,
+    &ProcessMetrics::powerWatts,
+    &ProcessMetrics::fps,
+    &ProcessMetrics::frameTimeMs,
+    &ProcessMetrics::frameTimeMaxMs,
+    &ProcessMetrics::threadCpuPercent,
+    &ProcessMetrics::gpuBusyPercent,
+    &ProcessMetrics::gpuPowerWatts,
+    &ProcessMetrics::pssMb,
+    &ProcessMetrics::pssPercent,
+    &ProcessMetrics::ussMb,
+    &ProcessMetrics::swapMb,
+    &ProcessMetrics::vramMb,
+    &ProcessMetrics::gttMb,
+    &ProcessMetrics::cpuPressure,
+    &ProcessMetrics::memoryPressure,
+    &ProcessMetrics::ioPressure,
+    &ProcessMetrics::cpuStallPercent,
+    &ProcessMetrics::memoryStallPercent,
+    &ProcessMetrics::ioStallPercent,
+};
+static_assert(sizeof(METRIC_MEMBERS) / sizeof(METRIC_MEMBERS[0]) == METRIC_FIELD_COUNT,
+              "every MetricField needs a ProcessMetrics member");
+
+quint64 monotonicNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<quint64>(now.tv_sec) * 1'000'000'000ull + static_cast<quint64>(now.tv_nsec);
+}
+}
+
+MetricGroup metricGroupOf(MetricField field)
+{
+    switch (field) {
+    case MetricField::CpuPercent:
+    case MetricField::Fps:
+    case MetricField::FrameTimeMs:
+    case MetricField::FrameTimeMaxMs:
+    case MetricField::ThreadCpuPercent:
+        return MetricGroup::Fast;
+    case MetricField::GpuPercent:
+    case MetricField::GpuBusyPercent:
+    case MetricField::RamMb:
+    case MetricField::RamPercent:
+    case MetricField::VramMb:
+    case MetricField::GttMb:
+    case MetricField::CpuPressure:
+    case MetricField::MemoryPressure:
+    case MetricField::IoPressure:
+    case MetricField::CpuStallPercent:
+    case MetricField::MemoryStallPercent:
+    case MetricField::IoStallPercent:
+        return MetricGroup::Medium;
+    case MetricField::TemperatureC:
+    case MetricField::GpuTemperatureC:
+    case MetricField::PowerWatts:
+    case MetricField::GpuPowerWatts:
+    case MetricField::PssMb:
+    case MetricField::PssPercent:
+    case MetricField::UssMb:
+    case MetricField::SwapMb:
+    case MetricField::Count:
+        break;
+    }
+    return MetricGroup::Slow;
+}
+
+MetricFieldMask metricGroupFields(MetricGroupMask groups)
+{
+    MetricFieldMask fields = 0;
+    for (int i = 0; i < METRIC_FIELD_COUNT; ++i) {
+        const auto field = static_cast<MetricField>(i);
+        if (groups & metricGroupBit(metricGroupOf(field))) {
+            fields |= metricFieldBit(field);
+        }
+    }
+    return fields;
+}
+
+QString metricGroupName(MetricGroup group)
+{
+    switch (group) {
+    case MetricGroup::Fast:
+        return QStringLiteral("fast");
+    case MetricGroup::Medium:
+        return QStringLiteral("medium");
+    case MetricGroup::Slow:
+        return QStringLiteral("slow");
+    case MetricGroup::Count:
+        break;
+    }
+    return {};
+}
+
+double metricValue(const ProcessMetrics& metrics, MetricField field)
+{
+    double ProcessMetrics::*member = metricMember(field);
+    return member ? metrics.*member : 0.0;
+}
+
+void setMetricValue(ProcessMetrics& metrics, MetricField field, double value)
+{
+    if (double ProcessMetrics::*member = metricMember(field)) {
+        metrics.*member = value;
+    }
+}
+
+double ProcessMetrics::*metricMember(MetricField field)
+{
+    const int index = static_cast<int>(field);
+    return index >= 0 && index < METRIC_FIELD_COUNT ? METRIC_MEMBERS[index] : nullptr;
+}
+
+void mergeMetricFields(ProcessMetrics& target, const ProcessMetrics& sample, MetricFieldMask fields)
+{
+    target.pid = sample.pid;
+    target.valid = sample.valid;
+    target.sampledAtMs = sample.sampledAtMs;
+    for (int i = 0; i < METRIC_FIELD_COUNT; ++i) {
+        const auto field = static_cast<MetricField>(i);
+        if (fields & metricFieldBit(field)) {
+            setMetricValue(target, field, metricValue(sample, field));
+        }
+    }
+    if (fields & metricFieldBit(MetricField::ThreadCpuPercent)) {
+        std::copy(std::begin(sample.hotThreads), std::end(sample.hotThreads), std::begin(target.hotThreads));
+        target.hotThreadCount = sample.hotThreadCount;
+    }
+    if (fields & GPU_DEVICE_FIELDS) {
+        std::copy(std::begin(sample.gpuDevice), std::end(sample.gpuDevice), std::begin(target.gpuDevice));
+    }
+}
+
+QString metricFieldName(MetricField field)
+{
+    switch (field) {
+    case MetricField::CpuPercent:
+        return QStringLiteral("cpuPercent");
+    case MetricField::GpuPercent:
+        return QStringLiteral("gpuPercent");
+    case MetricField::RamMb:
+        return QStringLiteral("ramMb");
+    case MetricField::RamPercent:
+        return QStringLiteral("ramPercent");
+    case MetricField::TemperatureC:
+        return QStringLiteral("temperatureC");
+    case MetricField::GpuTemperatureC:
+        return QStringLiteral("gpuTemperatureC");
+    case MetricField::PowerWatts:
+        return QStringLiteral("powerWatts");
+    case MetricField::Fps:
+        return QStringLiteral("fps");
+    case MetricField::FrameTimeMs:
+        return QStringLiteral("frameTimeMs");
+    case MetricField::FrameTimeMaxMs:
+        return QStringLiteral("frameTimeMaxMs");
+    case MetricField::ThreadCpuPercent:
+        return QStringLiteral("threadCpuPercent");
+    case MetricField::GpuBusyPercent:
+        return QStringLiteral("gpuBusyPercent");
+    case MetricField::GpuPowerWatts:
+        return QStringLiteral("gpuPowerWatts");
+    case MetricField::PssMb:
+        return QStringLiteral("pssMb");
+    case MetricField::PssPercent:
+        return QStringLiteral("pssPercent");
+    case MetricField::UssMb:
+        return QStringLiteral("ussMb");
+    case MetricField::SwapMb:
+        return QStringLiteral("swapMb");
+    case MetricField::VramMb:
+        return QStringLiteral("vramMb");
+    case MetricField::GttMb:
+        return QStringLiteral("gttMb");
+    case MetricField::CpuPressure:
+        return QStringLiteral("cpuPressure");
+    case MetricField::MemoryPressure:
+        return QStringLiteral("memoryPressure");
+    case MetricField::IoPressure:
+        return QStringLiteral("ioPressure");
+    case MetricField::CpuStallPercent:
+        return QStringLiteral("cpuStallPercent");
+    case MetricField::MemoryStallPercent:
+        return QStringLiteral("memoryStallPercent");
+    case MetricField::IoStallPercent:
+        return QStringLiteral("ioStallPercent");
+    case MetricField::Count:
+        break;
+    }
+    return {};
+}
+
+bool metricFieldFromName(const QString& name, MetricField* field)
+{
+    for (int i = 0; i < METRIC_FIELD_COUNT; ++i) {
+        const auto candidate = static_cast<MetricField>(i);
+        if (metricFieldName(candidate) == name) {
+            *field = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+QVector<ProcessMetrics> ProcessMetricsProvider::metricsForPids(const QVector<qint64>& pids)
+{
+    QVector<ProcessMetrics> result;
+    result.reserve(pids.size());
+    for (qint64 pid : pids) {
+        result.append(metricsForPid(pid));
+    }
+    return result;
+}
+
+QVector<ProcessMetrics> ProcessMetricsProvider::metricsForFields(const QVector<qint64>& pids,
+                                                                 const QVector<MetricFieldMask>& fields)
+{
+    Q_UNUSED(fields);
+    return metricsForPids(pids);
+}
+
+QVector<ProcessMetrics> ProcessMetricsProvider::metricsForFields(const QVector<qint64>& pids, MetricFieldMask fields)
+{
+    return metricsForFields(pids, QVector<MetricFieldMask>(pids.size(), fields));
 }
 
 class LinuxMetricsProvider : public ProcessMetricsProvider {
 public:
-    LinuxMetricsProvider();
+    explicit LinuxMetricsProvider(const SystemPaths& paths);
     ~LinuxMetricsProvider() override = default;
 
     ProcessMetrics metricsForPid(qint64 pid) override;
+    QVector<ProcessMetrics> metricsForPids(const QVector<qint64>& pids) override;
+    QVector<ProcessMetrics> metricsForFields(const QVector<qint64>& pids,
+                                             const QVector<MetricFieldMask>& fields) override;
+    using ProcessMetricsProvider::metricsForFields;
+    void releasePid(qint64 pid) override;
+    void setProcessTreeAggregation(bool enabled) override;
+    bool onBattery() const override;
 
 private:
-    double readCpuUsagePercent(qint64 pid);
-    double readGpuUsagePercent();
-    double readRamUsageMb(qint64 pid) const;
-    double readTemperatureC() const;
-    double readGpuTemperatureC() const;
-    double readPowerWatts() const;
-    double readFps(qint64 pid) const;
+    struct GpuReadings {
+        double busyPercent = 0.0;
+        double temperatureC = 0.0;
+        double powerWatts = 0.0;
+    };
+
+    struct SystemMetrics {
+        double temperatureC = 0.0;
+        double powerWatts = 0.0;
+        // Aligned with m_sensors.gpus.
+        GpuReadings gpus[MAX_GPU_DEVICES];
+        // Stands in on machines without a GPU.
+        GpuReadings noGpu;
+    };
+
+    // A game's GPU use gathered over its process tree.
+    struct GpuAttribution {
+        bool attributed = false;
+        double percent = 0.0;
+        // The device of the busiest process, and that process's usage.
+        char device[GPU_DEVICE_ID_SIZE] = {};
+        double devicePercent = -1.0;
+        double vramMb = 0.0;
+        double gttMb = 0.0;
+    };
+
+    // The device a game was last seen rendering on, kept for the ticks that
+    // read GPU sensors without sampling usage.
+    struct GpuDeviceId {
+        char id[GPU_DEVICE_ID_SIZE] = {};
+    };
+
+    SystemMetrics readSystemMetrics(MetricFieldMask fields);
+    ProcessMetrics sampleProcess(qint64 pid, const SystemMetrics& system, MetricFieldMask fields);
+    void refreshSensorsIfNeeded();
+    void rediscoverSensors();
+
+    double cpuUsagePercent(qint64 pid, const char* statData, qint64 statSize);
+    double readGpuUsagePercent(const GpuSensors& gpu);
+    double readRamUsageMb(qint64 pid);
+    void addSmapsRollup(qint64 pid, ProcessMetrics& metrics);
+    double readTemperatureC();
+    bool readGpuTemperatureC(const GpuSensors& gpu, double* value);
+    double readGpuPowerWatts(const GpuSensors& gpu);
+    double readPowerWatts();
+    void readFrameTiming(qint64 pid, ProcessMetrics& metrics);
+    void readPressure(qint64 pid, MetricFieldMask fields, ProcessMetrics& metrics);
+    void releasePressure(qint64 pid);
+    void addDescendants(qint64 pid, const char* statData, qint64 statSize, MetricFieldMask fields,
+                        ProcessMetrics& metrics, GpuAttribution& gpu);
+    void sampleThreads(qint64 pid, const char* statData, qint64 statSize, ProcessMetrics& metrics);
+    void sampleGpu(qint64 pid, GpuAttribution& gpu);
+    void applyGpuDevice(qint64 pid, const SystemMetrics& system, MetricFieldMask fields, const GpuAttribution& gpu,
+                        ProcessMetrics& metrics);
+    int gpuIndex(const char* device) const;
+    void releaseSamplers(qint64 pid);
+    void releaseTree(qint64 pid);
+    bool readSensor(const QByteArray& path, qint64* value);
+    bool readSysfsInteger(const QByteArray& path, qint64* value);
 
     double totalMemoryMb() const;
 
@@ -37,77 +379,315 @@ private:
         qint64 timestampMs = 0;
     };
 
-    mutable QHash<qint64, CpuSample> m_cpuSamples;
+    // Consumer end of one game's frame timing channel. Games without a
+    // channel, or whose frames stopped, are re-probed every
+    // FRAME_CHANNEL_PROBE_INTERVAL_NS.
+    struct FrameSource {
+        FrameTimingReader reader;
+        quint64 lastPresentNs = 0;
+        quint64 nextProbeNs = 0;
+        double fps = 0.0;
+        double frameTimeMs = 0.0;
+        double frameTimeMaxMs = 0.0;
+    };
+
+    FrameSource* frameSourceFor(qint64 pid);
+
+    // The PSI files of one game, resolved from its cgroup when it is first
+    // sampled, and the stall totals of the previous read.
+    struct PressureSource {
+        PressureFiles files;
+        bool resolved = false;
+        quint64 totalUs[PRESSURE_RESOURCE_COUNT] = {};
+        quint64 sampledNs[PRESSURE_RESOURCE_COUNT] = {};
+    };
+
+    SystemPaths m_paths;
+    FileDescriptorCache m_files;
+    SensorMap m_sensors;
+    SensorHotplugMonitor m_hotplug;
+    // Sensor paths whose last read failed, and when they may be read again.
+    QHash<QByteArray, qint64> m_sensorRetryAtMs;
+    QElapsedTimer m_sensorClock;
+    bool m_onBattery = false;
+    QHash<qint64, CpuSample> m_cpuSamples;
+    bool m_aggregateProcessTree = false;
+    QHash<qint64, std::shared_ptr<ProcessTree>> m_processTrees;
+    QHash<qint64, std::shared_ptr<ThreadCpuSampler>> m_threadSamplers;
+    QHash<qint64, std::shared_ptr<GpuEngineSampler>> m_gpuSamplers;
+    QHash<qint64, GpuDeviceId> m_gameGpus;
+    QByteArray m_frameChannelPrefix;
+    QHash<qint64, std::shared_ptr<FrameSource>> m_frameSources;
+    QHash<qint64, std::shared_ptr<PressureSource>> m_pressureSources;
     double m_totalMemoryMb = 0.0;
 };
 
-LinuxMetricsProvider::LinuxMetricsProvider()
-{
-    QFile memInfo("/proc/meminfo");
-    if (memInfo.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QTextStream in(&memInfo);
-        while (!in.atEnd()) {
-            const QString line = in.readLine();
-            if (line.startsWith("MemTotal:")) {
-                const QStringList parts = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-                if (parts.size() >= 2) {
-                    bool ok = false;
-                    double kb = parts[1].toDouble(&ok);
-                    if (ok) {
-                        m_totalMemoryMb = kb / 1024.0;
-                    }
-                }
-                break;
-            }
+LinuxMetricsProvider::LinuxMetricsProvider(const SystemPaths& paths)
+    : m_paths(paths)
+    , m_files(QFile::encodeName(paths.procRoot))
+    , m_frameChannelPrefix(QFile::encodeName(paths.frameChannelPrefix))
+{
+    m_sensorClock.start();
+    rediscoverSensors();
+    if (m_paths.sysRoot == QLatin1String("/sys")) {
+        m_hotplug.open();
+    }
+
+    QFile memInfo(m_paths.procRoot + QStringLiteral("/meminfo"));
+    if (memInfo.open(QIODevice::ReadOnly)) {
+        const QByteArray content = memInfo.readAll();
+        qint64 kb = 0;
+        if (Procfs::keyValueKb(content.constData(), content.size(), "MemTotal:", &kb)) {
+            m_totalMemoryMb = kb / 1024.0;
         }
     }
 }
 
 ProcessMetrics LinuxMetricsProvider::metricsForPid(qint64 pid)
+{
+    return sampleProcess(pid, readSystemMetrics(ALL_METRIC_FIELDS), ALL_METRIC_FIELDS);
+}
+
+QVector<ProcessMetrics> LinuxMetricsProvider::metricsForPids(const QVector<qint64>& pids)
+{
+    QVector<ProcessMetrics> result;
+    result.reserve(pids.size());
+    if (pids.isEmpty()) {
+        return result;
+    }
+
+    const SystemMetrics system = readSystemMetrics(ALL_METRIC_FIELDS);
+    for (qint64 pid : pids) {
+        result.append(sampleProcess(pid, system, ALL_METRIC_FIELDS));
+    }
+    return result;
+}
+
+QVector<ProcessMetrics> LinuxMetricsProvider::metricsForFields(const QVector<qint64>& pids,
+                                                               const QVector<MetricFieldMask>& fields)
+{
+    QVector<ProcessMetrics> result;
+    result.reserve(pids.size());
+    if (pids.isEmpty()) {
+        return result;
+    }
+
+    // System-wide sensors are read once for every game that wants them.
+    MetricFieldMask systemFields = 0;
+    for (MetricFieldMask mask : fields) {
+        systemFields |= mask;
+    }
+    const SystemMetrics system = readSystemMetrics(systemFields);
+    for (int i = 0; i < pids.size(); ++i) {
+        result.append(sampleProcess(pids[i], system, fields[i]));
+    }
+    return result;
+}
+
+void LinuxMetricsProvider::releasePid(qint64 pid)
+{
+    releaseTree(pid);
+    releaseSamplers(pid);
+    m_files.releasePid(pid);
+    m_cpuSamples.remove(pid);
+    m_gameGpus.remove(pid);
+    releasePressure(pid);
+
+    const auto source = m_frameSources.take(pid);
+    if (source) {
+        // A game that crashed never unlinked its segment. Leave it alone if
+        // the process is still alive and only stopped being tracked.
+        if (::kill(static_cast<pid_t>(pid), 0) < 0 && errno == ESRCH) {
+            source->reader.unlinkSegment();
+        }
+    }
+}
+
+void LinuxMetricsProvider::setProcessTreeAggregation(bool enabled)
+{
+    if (m_aggregateProcessTree == enabled) {
+        return;
+    }
+
+    m_aggregateProcessTree = enabled;
+    if (!enabled) {
+        for (qint64 root : m_processTrees.keys()) {
+            releaseTree(root);
+        }
+    }
+}
+
+bool LinuxMetricsProvider::onBattery() const
+{
+    return m_onBattery;
+}
+
+void LinuxMetricsProvider::releaseTree(qint64 pid)
+{
+    const auto tree = m_processTrees.take(pid);
+    if (!tree) {
+        return;
+    }
+    for (int i = 1; i < tree->memberCount(); ++i) {
+        m_cpuSamples.remove(tree->memberAt(i));
+        releaseSamplers(tree->memberAt(i));
+    }
+    tree->release(m_files);
+}
+
+void LinuxMetricsProvider::releaseSamplers(qint64 pid)
+{
+    const auto threads = m_threadSamplers.take(pid);
+    if (threads) {
+        threads->release(m_files);
+    }
+    const auto gpu = m_gpuSamplers.take(pid);
+    if (gpu) {
+        gpu->release(m_files);
+    }
+}
+
+LinuxMetricsProvider::SystemMetrics LinuxMetricsProvider::readSystemMetrics(MetricFieldMask fields)
+{
+    // Also keeps the power source current on ticks that read no sensor.
+    refreshSensorsIfNeeded();
+    SystemMetrics system;
+    if (!(fields & SYSTEM_FIELDS)) {
+        return system;
+    }
+
+    const bool cpuTemperature = fields & metricFieldBit(MetricField::TemperatureC);
+    const bool gpuTemperature = fields & metricFieldBit(MetricField::GpuTemperatureC);
+    if (cpuTemperature) {
+        system.temperatureC = readTemperatureC();
+    }
+    // Without a GPU sensor the CPU package temperature stands in.
+    double fallbackTemperatureC = -1.0;
+    auto cpuFallback = [&]() {
+        if (fallbackTemperatureC < 0.0) {
+            fallbackTemperatureC = cpuTemperature ? system.temperatureC : readTemperatureC();
+        }
+        return fallbackTemperatureC;
+    };
+    for (int i = 0; i < m_sensors.gpus.size(); ++i) {
+        const GpuSensors& sensors = m_sensors.gpus[i];
+        GpuReadings& readings = system.gpus[i];
+        if (fields & GPU_BUSY_FIELDS) {
+            readings.busyPercent = readGpuUsagePercent(sensors);
+        }
+        if (gpuTemperature && !readGpuTemperatureC(sensors, &readings.temperatureC)) {
+            readings.temperatureC = cpuFallback();
+        }
+        if (fields & metricFieldBit(MetricField::GpuPowerWatts)) {
+            readings.powerWatts = readGpuPowerWatts(sensors);
+        }
+    }
+    if (gpuTemperature && m_sensors.gpus.isEmpty()) {
+        system.noGpu.temperatureC = cpuFallback();
+    }
+    if (fields & metricFieldBit(MetricField::PowerWatts)) {
+        system.powerWatts = readPowerWatts();
+    }
+    return system;
+}
+
+void LinuxMetricsProvider::refreshSensorsIfNeeded()
+{
+    const SensorChanges changes = m_hotplug.takePendingChanges();
+    if (changes.devices) {
+        rediscoverSensors();
+    } else if (changes.powerSource) {
+        m_onBattery = readOnBattery(m_paths.sysRoot);
+    }
+}
+
+void LinuxMetricsProvider::rediscoverSensors()
+{
+    m_files.releasePath(m_sensors.cpuTemperature);
+    m_files.releasePath(m_sensors.power);
+    for (const GpuSensors& gpu : std::as_const(m_sensors.gpus)) {
+        for (const QByteArray* path : {&gpu.busy, &gpu.edgeTemperature, &gpu.junctionTemperature, &gpu.power}) {
+            m_files.releasePath(*path);
+        }
+    }
+
+    m_sensors = discoverSensors(m_paths.sysRoot);
+    m_onBattery = readOnBattery(m_paths.sysRoot);
+    m_sensorRetryAtMs.clear();
+}
+
+ProcessMetrics LinuxMetricsProvider::sampleProcess(qint64 pid, const SystemMetrics& system, MetricFieldMask fields)
 {
     ProcessMetrics metrics;
     metrics.pid = pid;
 
-    QFile statFile(QStringLiteral("/proc/%1/stat").arg(pid));
-    if (!statFile.exists() || !statFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    // The stat read doubles as the liveness check: it fails once the process
+    // is gone, and the cached descriptor is evicted with it.
+    char statBuffer[STAT_BUFFER_SIZE];
+    const qint64 statBytes = m_files.readProcFile(pid, FileDescriptorCache::ProcFile::Stat,
+                                                  statBuffer, sizeof(statBuffer));
+    if (statBytes <= 0) {
+        m_cpuSamples.remove(pid);
+        releaseTree(pid);
+        releaseSamplers(pid);
         return metrics;
     }
-    statFile.close();
 
-    metrics.cpuPercent = readCpuUsagePercent(pid);
-    metrics.gpuPercent = readGpuUsagePercent();
-    metrics.ramMb = readRamUsageMb(pid);
-    metrics.temperatureC = readTemperatureC();
-    metrics.gpuTemperatureC = readGpuTemperatureC();
-    metrics.powerWatts = readPowerWatts();
-    metrics.fps = readFps(pid);
-    if (m_totalMemoryMb > 0.0) {
+    const bool cpu = fields & metricFieldBit(MetricField::CpuPercent);
+    const bool ram = fields & RAM_FIELDS;
+    const bool threads = fields & THREAD_FIELDS;
+    const bool smaps = fields & SMAPS_FIELDS;
+    const bool gpuClients = fields & GPU_CLIENT_FIELDS;
+    if (cpu) {
+        metrics.cpuPercent = cpuUsagePercent(pid, statBuffer, statBytes);
+    }
+    if (threads) {
+        sampleThreads(pid, statBuffer, statBytes, metrics);
+    }
+    if (fields & FRAME_FIELDS) {
+        readFrameTiming(pid, metrics);
+    }
+    if (fields & PRESSURE_FIELDS) {
+        readPressure(pid, fields, metrics);
+    }
+    if (ram) {
+        metrics.ramMb = readRamUsageMb(pid);
+    }
+    if (smaps) {
+        addSmapsRollup(pid, metrics);
+    }
+    GpuAttribution gpu;
+    if (gpuClients) {
+        sampleGpu(pid, gpu);
+    }
+    metrics.temperatureC = system.temperatureC;
+    metrics.powerWatts = system.powerWatts;
+    if (m_aggregateProcessTree && (cpu || ram || smaps || threads || gpuClients)) {
+        addDescendants(pid, statBuffer, statBytes, fields, metrics, gpu);
+    }
+    if (fields & GPU_DEVICE_FIELDS) {
+        applyGpuDevice(pid, system, fields, gpu, metrics);
+    }
+    metrics.vramMb = gpu.vramMb;
+    metrics.gttMb = gpu.gttMb;
+    if (ram && m_totalMemoryMb > 0.0) {
         metrics.ramPercent = (metrics.ramMb / m_totalMemoryMb) * 100.0;
     }
+    if (smaps && m_totalMemoryMb > 0.0) {
+        metrics.pssPercent = (metrics.pssMb / m_totalMemoryMb) * 100.0;
+    }
     metrics.valid = true;
 
     return metrics;
 }
 
-double LinuxMetricsProvider::readCpuUsagePercent(qint64 pid)
+double LinuxMetricsProvider::cpuUsagePercent(qint64 pid, const char* statData, qint64 statSize)
 {
-    QFile statFile(QStringLiteral("/proc/%1/stat").arg(pid));
-    if (!statFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return 0.0;
-    }
-
-    const QString statLine = QTextStream(&statFile).readLine();
-    statFile.close();
-
-    const QStringList fields = statLine.split(' ');
-    if (fields.size() < 15) {
+    qint64 totalTicks = 0;
+    if (!Procfs::statCpuTicks(statData, statSize, &totalTicks)) {
         return 0.0;
     }
 
-    const qint64 utime = fields[13].toLongLong();
-    const qint64 stime = fields[14].toLongLong();
-    const qint64 totalTicks = utime + stime;
-
     const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
     const auto previous = m_cpuSamples.value(pid);
 
@@ -132,133 +712,396 @@ double LinuxMetricsProvider::readCpuUsagePercent(qint64 pid)
     return percent;
 }
 
-double LinuxMetricsProvider::readGpuUsagePercent()
+void LinuxMetricsProvider::addDescendants(qint64 pid, const char* statData, qint64 statSize, MetricFieldMask fields,
+                                          ProcessMetrics& metrics, GpuAttribution& gpu)
 {
-    QFile gpuBusy(QStringLiteral("/sys/class/drm/card0/device/gpu_busy_percent"));
-    if (!gpuBusy.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        return 0.0;
+    const bool cpu = fields & metricFieldBit(MetricField::CpuPercent);
+    const bool ram = fields & RAM_FIELDS;
+    const bool smaps = fields & SMAPS_FIELDS;
+    const bool threads = fields & THREAD_FIELDS;
+    const bool gpuClients = fields & GPU_CLIENT_FIELDS;
+
+    std::shared_ptr<ProcessTree>& tree = m_processTrees[pid];
+    if (!tree) {
+        tree = std::make_shared<ProcessTree>(pid, QFile::encodeName(m_paths.procRoot));
+    }
+    tree->memberSampled(0, statData, statSize, m_files);
+
+    // Members found during this pass are appended and sampled in the same
+    // loop. Their first CPU sample only establishes a baseline.
+    double cpuPercent = metrics.cpuPercent;
+    double ramMb = metrics.ramMb;
+    char statBuffer[STAT_BUFFER_SIZE];
+    for (int i = 1; i < tree->memberCount(); ++i) {
+        const qint64 member = tree->memberAt(i);
+        const qint64 bytes = m_files.readProcFile(member, FileDescriptorCache::ProcFile::Stat,
+                                                  statBuffer, sizeof(statBuffer));
+        if (bytes <= 0) {
+            m_cpuSamples.remove(member);
+            releaseSamplers(member);
+            tree->removeMember(i--, m_files);
+            continue;
+        }
+        if (cpu) {
+            cpuPercent += cpuUsagePercent(member, statBuffer, bytes);
+        }
+        if (threads) {
+            sampleThreads(member, statBuffer, bytes, metrics);
+        }
+        if (ram) {
+            ramMb += readRamUsageMb(member);
+        }
+        if (smaps) {
+            addSmapsRollup(member, metrics);
+        }
+        if (gpuClients) {
+            sampleGpu(member, gpu);
+        }
+        tree->memberSampled(i, statBuffer, bytes, m_files);
     }
 
-    const QString content = QTextStream(&gpuBusy).readAll().trimmed();
-    gpuBusy.close();
+    // Same 0-100 scale as a single process.
+    metrics.cpuPercent = qMin(cpuPercent, 100.0);
+    metrics.ramMb = ramMb;
+}
 
-    bool ok = false;
-    const double value = content.toDouble(&ok);
-    if (!ok) {
+void LinuxMetricsProvider::sampleThreads(qint64 pid, const char* statData, qint64 statSize, ProcessMetrics& metrics)
+{
+    std::shared_ptr<ThreadCpuSampler>& sampler = m_threadSamplers[pid];
+    if (!sampler) {
+        sampler = std::make_shared<ThreadCpuSampler>(pid, QFile::encodeName(m_paths.procRoot));
+    }
+    sampler->sample(statData, statSize, monotonicNs(), m_files);
+    sampler->collectHottest(metrics);
+}
+
+void LinuxMetricsProvider::sampleGpu(qint64 pid, GpuAttribution& gpu)
+{
+    std::shared_ptr<GpuEngineSampler>& sampler = m_gpuSamplers[pid];
+    if (!sampler) {
+        sampler = std::make_shared<GpuEngineSampler>(pid, QFile::encodeName(m_paths.procRoot));
+    }
+    GpuEngineUsage usage;
+    if (!sampler->sample(monotonicNs(), m_files, &usage)) {
+        return;
+    }
+    gpu.attributed = true;
+    gpu.percent += usage.percent;
+    gpu.vramMb += usage.vramMb;
+    gpu.gttMb += usage.gttMb;
+    if (usage.percent > gpu.devicePercent) {
+        gpu.devicePercent = usage.percent;
+        std::copy(std::begin(usage.device), std::end(usage.device), std::begin(gpu.device));
+    }
+}
+
+void LinuxMetricsProvider::applyGpuDevice(qint64 pid, const SystemMetrics& system, MetricFieldMask fields,
+                                          const GpuAttribution& gpu, ProcessMetrics& metrics)
+{
+    GpuDeviceId& known = m_gameGpus[pid];
+    if (fields & metricFieldBit(MetricField::GpuPercent)) {
+        std::copy(std::begin(gpu.device), std::end(gpu.device), std::begin(known.id));
+    }
+
+    const int index = gpuIndex(known.id);
+    if (index >= 0) {
+        const GpuSensors& sensors = m_sensors.gpus[index];
+        const QByteArray& id = sensors.pciAddress.isEmpty() ? sensors.card : sensors.pciAddress;
+        const qsizetype length = qMin<qsizetype>(id.size(), GPU_DEVICE_ID_SIZE - 1);
+        std::copy(id.constData(), id.constData() + length, metrics.gpuDevice);
+        metrics.gpuDevice[length] = '\0';
+    }
+
+    const GpuReadings& readings = index >= 0 ? system.gpus[index] : system.noGpu;
+    // Drivers without per-client usage only have the device-wide load.
+    metrics.gpuPercent = gpu.attributed ? qMin(gpu.percent, 100.0) : readings.busyPercent;
+    metrics.gpuBusyPercent = readings.busyPercent;
+    metrics.gpuTemperatureC = readings.temperatureC;
+    metrics.gpuPowerWatts = readings.powerWatts;
+}
+
+// Games whose device is unknown, or not among the enumerated ones, are
+// reported against the primary GPU.
+int LinuxMetricsProvider::gpuIndex(const char* device) const
+{
+    if (device[0] != '\0') {
+        for (int i = 0; i < m_sensors.gpus.size(); ++i) {
+            if (m_sensors.gpus[i].pciAddress == device) {
+                return i;
+            }
+        }
+    }
+    return m_sensors.primaryGpu;
+}
+
+double LinuxMetricsProvider::readGpuUsagePercent(const GpuSensors& gpu)
+{
+    qint64 value = 0;
+    if (!readSensor(gpu.busy, &value)) {
         return 0.0;
     }
-    if (value < 0.0) {
+    if (value < 0) {
         return 0.0;
     }
-    if (value > 100.0) {
+    if (value > 100) {
         return 100.0;
     }
-    return value;
+    return static_cast<double>(value);
 }
 
-double LinuxMetricsProvider::readRamUsageMb(qint64 pid) const
+double LinuxMetricsProvider::readRamUsageMb(qint64 pid)
 {
-    QFile statusFile(QStringLiteral("/proc/%1/status").arg(pid));
-    if (!statusFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+    // statm holds the same resident size as VmRSS in status, without the
+    // dozens of other lines the kernel formats for status.
+    char buffer[STATM_BUFFER_SIZE];
+    const qint64 bytes = m_files.readProcFile(pid, FileDescriptorCache::ProcFile::Statm,
+                                              buffer, sizeof(buffer));
+    qint64 pages = 0;
+    if (bytes <= 0 || !Procfs::statmResidentPages(buffer, bytes, &pages)) {
         return 0.0;
     }
+    const long pageSize = sysconf(_SC_PAGESIZE);
+    return pageSize > 0 ? pages * (pageSize / 1024.0) / 1024.0 : 0.0;
+}
 
-    QTextStream in(&statusFile);
-    while (!in.atEnd()) {
-        const QString line = in.readLine();
-        if (line.startsWith("VmRSS:")) {
-            const QStringList parts = line.split(QRegularExpression("\\s+"), Qt::SkipEmptyParts);
-            if (parts.size() >= 2) {
-                bool ok = false;
-                const double kb = parts[1].toDouble(&ok);
-                if (ok) {
-                    return kb / 1024.0;
-                }
-            }
-        }
+void LinuxMetricsProvider::addSmapsRollup(qint64 pid, ProcessMetrics& metrics)
+{
+    char buffer[SMAPS_ROLLUP_BUFFER_SIZE];
+    const qint64 bytes = m_files.readProcFile(pid, FileDescriptorCache::ProcFile::SmapsRollup,
+                                              buffer, sizeof(buffer));
+    Procfs::SmapsRollup rollup;
+    if (bytes <= 0 || !Procfs::smapsRollup(buffer, bytes, &rollup)) {
+        return;
     }
+    metrics.pssMb += rollup.pssKb / 1024.0;
+    metrics.ussMb += rollup.ussKb / 1024.0;
+    metrics.swapMb += rollup.swapKb / 1024.0;
+}
 
+double LinuxMetricsProvider::readTemperatureC()
+{
+    qint64 milli = 0;
+    if (readSensor(m_sensors.cpuTemperature, &milli)) {
+        return milli / 1000.0;
+    }
     return 0.0;
 }
 
-double LinuxMetricsProvider::readTemperatureC() const
+bool LinuxMetricsProvider::readGpuTemperatureC(const GpuSensors& gpu, double* value)
 {
-    const QStringList candidates = {
-        QStringLiteral("/sys/class/thermal/thermal_zone0/temp"),
-        QStringLiteral("/sys/class/hwmon/hwmon0/temp1_input"),
-        QStringLiteral("/sys/class/hwmon/hwmon1/temp1_input")
-    };
-
-    for (const QString& path : candidates) {
-        QFile file(path);
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            const QString content = QTextStream(&file).readAll().trimmed();
-            file.close();
+    qint64 milli = 0;
+    if (readSensor(gpu.edgeTemperature, &milli) || readSensor(gpu.junctionTemperature, &milli)) {
+        *value = milli / 1000.0;
+        return true;
+    }
+    return false;
+}
 
-            bool ok = false;
-            const double milli = content.toDouble(&ok);
-            if (ok) {
-                return milli / 1000.0;
-            }
-        }
+double LinuxMetricsProvider::readGpuPowerWatts(const GpuSensors& gpu)
+{
+    qint64 micro = 0;
+    if (readSensor(gpu.power, &micro)) {
+        return micro / 1'000'000.0;
     }
+    return 0.0;
+}
 
+double LinuxMetricsProvider::readPowerWatts()
+{
+    qint64 micro = 0;
+    if (readSensor(m_sensors.power, &micro)) {
+        return micro / 1'000'000.0;
+    }
     return 0.0;
 }
 
-double LinuxMetricsProvider::readGpuTemperatureC() const
+void LinuxMetricsProvider::readFrameTiming(qint64 pid, ProcessMetrics& metrics)
 {
-    const QStringList candidates = {
-        QStringLiteral("/sys/class/drm/card0/device/hwmon/hwmon0/temp1_input"),
-        QStringLiteral("/sys/class/drm/card0/device/hwmon/hwmon1/temp1_input"),
-        QStringLiteral("/sys/class/hwmon/hwmon2/temp1_input")
-    };
+    FrameSource* source = frameSourceFor(pid);
+    if (!source) {
+        return;
+    }
 
-    for (const QString& path : candidates) {
-        QFile file(path);
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            const QString content = QTextStream(&file).readAll().trimmed();
-            file.close();
+    // Count the frame intervals completed since the previous tick. The first
+    // present ever seen only anchors the span.
+    uint64_t presents[FRAME_DRAIN_BATCH];
+    quint64 previous = source->lastPresentNs;
+    quint64 spanStart = previous;
+    quint64 worstInterval = 0;
+    int intervals = 0;
+    int drained = 0;
+    while ((drained = source->reader.drain(presents, FRAME_DRAIN_BATCH)) > 0) {
+        for (int i = 0; i < drained; ++i) {
+            const quint64 present = presents[i];
+            if (previous == 0) {
+                spanStart = present;
+                previous = present;
+                continue;
+            }
+            if (present <= previous) {
+                continue;
+            }
+            worstInterval = qMax(worstInterval, present - previous);
+            ++intervals;
+            previous = present;
+        }
+    }
+    source->lastPresentNs = previous;
 
-            bool ok = false;
-            const double milli = content.toDouble(&ok);
-            if (ok) {
-                return milli / 1000.0;
+    if (intervals > 0) {
+        // The next stall checks for a replaced segment straight away.
+        source->nextProbeNs = 0;
+        const double spanNs = static_cast<double>(previous - spanStart);
+        source->fps = intervals * 1e9 / spanNs;
+        source->frameTimeMs = spanNs / 1e6 / intervals;
+        source->frameTimeMaxMs = worstInterval / 1e6;
+    } else if (previous != 0) {
+        const quint64 now = monotonicNs();
+        // A hook that restarts replaces the segment under the same name, and
+        // the old mapping never sees another frame: follow the new one.
+        if (now >= source->nextProbeNs) {
+            source->nextProbeNs = now + FRAME_CHANNEL_PROBE_INTERVAL_NS;
+            if (source->reader.segmentReplaced()) {
+                source->reader.close();
+                source->lastPresentNs = 0;
+                source->nextProbeNs = 0;
+                source->fps = 0.0;
+                source->frameTimeMs = 0.0;
+                source->frameTimeMaxMs = 0.0;
+                readFrameTiming(pid, metrics);
+                return;
             }
         }
+
+        // No present since the last tick. Once the gap exceeds the last frame
+        // time the game is stalled: report the rate implied by the time since
+        // its last frame so that the FPS alert fires.
+        const double stalledMs = now > previous ? (now - previous) / 1e6 : 0.0;
+        if (stalledMs > source->frameTimeMs) {
+            source->fps = 1000.0 / stalledMs;
+            source->frameTimeMs = stalledMs;
+            source->frameTimeMaxMs = stalledMs;
+        }
     }
 
-    return readTemperatureC();
+    metrics.fps = source->fps;
+    metrics.frameTimeMs = source->frameTimeMs;
+    metrics.frameTimeMaxMs = source->frameTimeMaxMs;
 }
 
-double LinuxMetricsProvider::readPowerWatts() const
+// Pressure is a property of the cgroup, which the whole process tree shares,
+// so it is read for the root PID only.
+void LinuxMetricsProvider::readPressure(qint64 pid, MetricFieldMask fields, ProcessMetrics& metrics)
 {
-    const QStringList candidates = {
-        QStringLiteral("/sys/class/power_supply/BAT0/power_now"),
-        QStringLiteral("/sys/class/hwmon/hwmon0/power1_input")
-    };
+    std::shared_ptr<PressureSource>& source = m_pressureSources[pid];
+    if (!source) {
+        source = std::make_shared<PressureSource>();
+        source->resolved = pressureFilesForPid(pid, m_paths, &source->files);
+    }
+    if (!source->resolved) {
+        return;
+    }
 
-    for (const QString& path : candidates) {
-        QFile file(path);
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            const QString content = QTextStream(&file).readAll().trimmed();
-            file.close();
+    char buffer[PRESSURE_BUFFER_SIZE];
+    for (int i = 0; i < PRESSURE_RESOURCE_COUNT; ++i) {
+        const MetricField average = PRESSURE_AVERAGE_FIELDS[i];
+        const MetricField stall = PRESSURE_STALL_FIELDS[i];
+        if (!(fields & (metricFieldBit(average) | metricFieldBit(stall)))) {
+            continue;
+        }
+        const qint64 bytes = m_files.readPath(source->files.paths[i], buffer, sizeof(buffer));
+        Procfs::PressureStats stats;
+        if (bytes <= 0 || !Procfs::pressureSome(buffer, bytes, &stats)) {
+            source->sampledNs[i] = 0;
+            continue;
+        }
 
-            bool ok = false;
-            const double micro = content.toDouble(&ok);
-            if (ok) {
-                return micro / 1'000'000.0;
-            }
+        const quint64 now = monotonicNs();
+        const quint64 previousNs = source->sampledNs[i];
+        setMetricValue(metrics, average, stats.avg10);
+        if (previousNs > 0 && now > previousNs && stats.totalUs >= source->totalUs[i]) {
+            const double stalledNs = (stats.totalUs - source->totalUs[i]) * 1000.0;
+            setMetricValue(metrics, stall, qMin(stalledNs / (now - previousNs) * 100.0, 100.0));
         }
+        source->totalUs[i] = stats.totalUs;
+        source->sampledNs[i] = now;
     }
+}
 
-    return 0.0;
+void LinuxMetricsProvider::releasePressure(qint64 pid)
+{
+    const auto source = m_pressureSources.take(pid);
+    if (!source) {
+        return;
+    }
+    // Games in the same cgroup, or all games when they fall back to the
+    // system-wide files, share the descriptors.
+    for (const QByteArray& path : source->files.paths) {
+        const bool shared = std::any_of(m_pressureSources.cbegin(), m_pressureSources.cend(),
+                                        [&path](const std::shared_ptr<PressureSource>& other) {
+                                            return std::find(std::begin(other->files.paths),
+                                                             std::end(other->files.paths), path)
+                                                != std::end(other->files.paths);
+                                        });
+        if (!shared && !path.isEmpty()) {
+            m_files.releasePath(path);
+        }
+    }
+}
+
+LinuxMetricsProvider::FrameSource* LinuxMetricsProvider::frameSourceFor(qint64 pid)
+{
+    std::shared_ptr<FrameSource>& source = m_frameSources[pid];
+    if (!source) {
+        source = std::make_shared<FrameSource>();
+    }
+    if (source->reader.isOpen()) {
+        return source.get();
+    }
+
+    const quint64 now = monotonicNs();
+    if (now < source->nextProbeNs) {
+        return nullptr;
+    }
+    source->nextProbeNs = now + FRAME_CHANNEL_PROBE_INTERVAL_NS;
+
+    char name[FRAME_CHANNEL_NAME_SIZE];
+    if (!frameTimingChannelName(m_frameChannelPrefix.constData(), pid, name, sizeof(name))
+        || !source->reader.open(name)) {
+        return nullptr;
+    }
+    return source.get();
 }
 
-double LinuxMetricsProvider::readFps(qint64 pid) const
+bool LinuxMetricsProvider::readSensor(const QByteArray& path, qint64* value)
 {
-    Q_UNUSED(pid);
-    return DEFAULT_FPS_FALLBACK;
+    if (path.isEmpty()) {
+        return false;
+    }
+    const auto retry = m_sensorRetryAtMs.constFind(path);
+    if (retry != m_sensorRetryAtMs.constEnd() && m_sensorClock.elapsed() < retry.value()) {
+        return false;
+    }
+    if (!readSysfsInteger(path, value)) {
+        // Back off from a failing sensor. A device that was unplugged or
+        // renumbered is picked up by the hotplug monitor instead.
+        m_sensorRetryAtMs.insert(path, m_sensorClock.elapsed() + SENSOR_RETRY_INTERVAL_MS);
+        return false;
+    }
+    if (retry != m_sensorRetryAtMs.constEnd()) {
+        m_sensorRetryAtMs.remove(path);
+    }
+    return true;
+}
+
+bool LinuxMetricsProvider::readSysfsInteger(const QByteArray& path, qint64* value)
+{
+    char buffer[SYSFS_BUFFER_SIZE];
+    const qint64 bytes = m_files.readPath(path, buffer, sizeof(buffer));
+    if (bytes <= 0) {
+        return false;
+    }
+    return Procfs::sysfsInteger(buffer, bytes, value);
 }
 
 double LinuxMetricsProvider::totalMemoryMb() const
@@ -266,9 +1109,9 @@ double LinuxMetricsProvider::totalMemoryMb() const
     return m_totalMemoryMb;
 }
 
-std::shared_ptr<ProcessMetricsProvider> createSystemMetricsProvider()
+std::shared_ptr<ProcessMetricsProvider> createSystemMetricsProvider(const SystemPaths& paths)
 {
-    return std::make_shared<LinuxMetricsProvider>();
+    return std::make_shared<LinuxMetricsProvider>(paths);
 }
 
 } // namespace Runtime
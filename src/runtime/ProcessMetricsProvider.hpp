@@ -1,29 +1,252 @@
 #pragma once
 
+#include "FrameTimingChannel.hpp"
+
+#include <QObject>
+#include <QString>
+#include <QVector>
 #include <QtGlobal>
 #include <memory>
 
 namespace Runtime {
 
+constexpr int HOT_THREAD_COUNT = 4;
+// TASK_COMM_LEN: the kernel truncates thread names to 15 bytes.
+constexpr int THREAD_NAME_SIZE = 16;
+// Fits the PCI address or platform device name of a GPU.
+constexpr int GPU_DEVICE_ID_SIZE = 32;
+
+// CPU usage of one thread over the last tick, in percent of one core.
+struct ThreadCpuUsage {
+    qint64 tid = 0;
+    double cpuPercent = 0.0;
+    char name[THREAD_NAME_SIZE] = {}; // NUL-terminated.
+};
+
+// A Q_GADGET so that QML reads fields through the property index instead of
+// string lookups in a QVariantMap.
 struct ProcessMetrics {
+    Q_GADGET
+    Q_PROPERTY(qint64 pid MEMBER pid)
+    Q_PROPERTY(double cpuPercent MEMBER cpuPercent)
+    Q_PROPERTY(double gpuPercent MEMBER gpuPercent)
+    Q_PROPERTY(double ramMb MEMBER ramMb)
+    Q_PROPERTY(double ramPercent MEMBER ramPercent)
+    Q_PROPERTY(double temperatureC MEMBER temperatureC)
+    Q_PROPERTY(double gpuTemperatureC MEMBER gpuTemperatureC)
+    Q_PROPERTY(double powerWatts MEMBER powerWatts)
+    Q_PROPERTY(double fps MEMBER fps)
+    Q_PROPERTY(double frameTimeMs MEMBER frameTimeMs)
+    Q_PROPERTY(double frameTimeMaxMs MEMBER frameTimeMaxMs)
+    Q_PROPERTY(double threadCpuPercent MEMBER threadCpuPercent)
+    Q_PROPERTY(double gpuBusyPercent MEMBER gpuBusyPercent)
+    Q_PROPERTY(double gpuPowerWatts MEMBER gpuPowerWatts)
+    Q_PROPERTY(double pssMb MEMBER pssMb)
+    Q_PROPERTY(double pssPercent MEMBER pssPercent)
+    Q_PROPERTY(double ussMb MEMBER ussMb)
+    Q_PROPERTY(double swapMb MEMBER swapMb)
+    Q_PROPERTY(double vramMb MEMBER vramMb)
+    Q_PROPERTY(double gttMb MEMBER gttMb)
+    Q_PROPERTY(double cpuPressure MEMBER cpuPressure)
+    Q_PROPERTY(double memoryPressure MEMBER memoryPressure)
+    Q_PROPERTY(double ioPressure MEMBER ioPressure)
+    Q_PROPERTY(double cpuStallPercent MEMBER cpuStallPercent)
+    Q_PROPERTY(double memoryStallPercent MEMBER memoryStallPercent)
+    Q_PROPERTY(double ioStallPercent MEMBER ioStallPercent)
+    Q_PROPERTY(bool valid MEMBER valid)
+    Q_PROPERTY(qint64 sampledAtMs MEMBER sampledAtMs)
+
+public:
     qint64 pid = 0;
     double cpuPercent = 0.0;
+    // The game's own share of its GPU, or the device-wide load when the
+    // driver does not report usage per process.
     double gpuPercent = 0.0;
     double ramMb = 0.0;
     double ramPercent = 0.0;
     double temperatureC = 0.0;
     double gpuTemperatureC = 0.0;
     double powerWatts = 0.0;
+    // Frame pacing from the game's frame timing channel. All three stay 0
+    // when the game publishes no present timestamps.
     double fps = 0.0;
+    double frameTimeMs = 0.0;
+    double frameTimeMaxMs = 0.0;
+    // The busiest thread in percent of one core. Unlike cpuPercent, which is
+    // capped at 100, it tells a saturated render thread apart from load
+    // spread over many cores.
+    double threadCpuPercent = 0.0;
+    // The busiest threads, hottest first. Sampled along with threadCpuPercent.
+    ThreadCpuUsage hotThreads[HOT_THREAD_COUNT];
+    int hotThreadCount = 0;
+    // The GPU the game renders on, by PCI address such as "0000:03:00.0",
+    // or the DRM card name when the device has no address. gpuTemperatureC,
+    // gpuBusyPercent and gpuPowerWatts are read from this device.
+    // NUL-terminated; empty without a GPU.
+    char gpuDevice[GPU_DEVICE_ID_SIZE] = {};
+    // Load of the whole device, including other processes.
+    double gpuBusyPercent = 0.0;
+    double gpuPowerWatts = 0.0;
+    // From /proc/<pid>/smaps_rollup. ramMb is RSS, which counts shared
+    // libraries once per process. PSS splits shared pages between the
+    // processes mapping them, so it can be summed over a process tree, and
+    // USS is the memory freed when the game exits. swapMb is the game's share
+    // of swapped-out pages, which RSS leaves out.
+    double pssMb = 0.0;
+    double pssPercent = 0.0;
+    double ussMb = 0.0;
+    double swapMb = 0.0;
+    // GPU buffers of the game from its DRM clients: resident in VRAM, and in
+    // system memory mapped through the GTT. On APUs most of it is GTT.
+    double vramMb = 0.0;
+    double gttMb = 0.0;
+    // Pressure stall information of the game's cgroup, or of the whole
+    // system when the game runs in the root cgroup: the share of time in
+    // which some of its tasks waited for CPU, memory or IO. The *Pressure
+    // fields are the kernel's 10 s averages; the *StallPercent fields cover
+    // the time since the previous sample and are 0 on the first one.
+    double cpuPressure = 0.0;
+    double memoryPressure = 0.0;
+    double ioPressure = 0.0;
+    double cpuStallPercent = 0.0;
+    double memoryStallPercent = 0.0;
+    double ioStallPercent = 0.0;
     bool valid = false;
+    // Wall-clock time of the sample the values come from, in ms since the epoch.
+    qint64 sampledAtMs = 0;
+};
+
+// Numeric ProcessMetrics fields addressable by index, for code that treats
+// metrics as columns (history, statistics, alert rules).
+enum class MetricField {
+    CpuPercent,
+    GpuPercent,
+    RamMb,
+    RamPercent,
+    TemperatureC,
+    GpuTemperatureC,
+    PowerWatts,
+    Fps,
+    FrameTimeMs,
+    FrameTimeMaxMs,
+    ThreadCpuPercent,
+    GpuBusyPercent,
+    GpuPowerWatts,
+    PssMb,
+    PssPercent,
+    UssMb,
+    SwapMb,
+    VramMb,
+    GttMb,
+    CpuPressure,
+    MemoryPressure,
+    IoPressure,
+    CpuStallPercent,
+    MemoryStallPercent,
+    IoStallPercent,
+    Count
+};
+
+constexpr int METRIC_FIELD_COUNT = static_cast<int>(MetricField::Count);
+
+// A set of MetricFields, one bit per field.
+using MetricFieldMask = quint32;
+
+constexpr MetricFieldMask ALL_METRIC_FIELDS = (1u << METRIC_FIELD_COUNT) - 1;
+
+constexpr MetricFieldMask metricFieldBit(MetricField field)
+{
+    return 1u << static_cast<int>(field);
+}
+
+// Metric fields grouped by how quickly they change, so that each group can be
+// sampled at its own rate. Fast holds process CPU and frame timing; Medium
+// holds memory, GPU load and pressure stalls; Slow holds temperatures, power
+// and the smaps_rollup memory breakdown, which makes the kernel walk every
+// mapping.
+enum class MetricGroup {
+    Fast,
+    Medium,
+    Slow,
+    Count
 };
 
+using MetricGroupMask = quint32;
+
+constexpr int METRIC_GROUP_COUNT = static_cast<int>(MetricGroup::Count);
+constexpr MetricGroupMask ALL_METRIC_GROUPS = (1u << METRIC_GROUP_COUNT) - 1;
+
+constexpr MetricGroupMask metricGroupBit(MetricGroup group)
+{
+    return 1u << static_cast<int>(group);
+}
+
+MetricGroup metricGroupOf(MetricField field);
+MetricFieldMask metricGroupFields(MetricGroupMask groups);
+QString metricGroupName(MetricGroup group);
+
+double metricValue(const ProcessMetrics& metrics, MetricField field);
+void setMetricValue(ProcessMetrics& metrics, MetricField field, double value);
+
+// The ProcessMetrics member behind a field, for loops that read one field
+// across many samples. nullptr for MetricField::Count.
+double ProcessMetrics::*metricMember(MetricField field);
+
+// Copies the given fields from sample into target, leaving the others at
+// their previous values. pid, valid and sampledAtMs are always copied, the
+// hot thread list with ThreadCpuPercent and gpuDevice with any GPU field.
+void mergeMetricFields(ProcessMetrics& target, const ProcessMetrics& sample, MetricFieldMask fields);
+// Names match the keys used in the serialized "metrics" map.
+QString metricFieldName(MetricField field);
+bool metricFieldFromName(const QString& name, MetricField* field);
+
 class ProcessMetricsProvider {
 public:
     virtual ~ProcessMetricsProvider() = default;
     virtual ProcessMetrics metricsForPid(qint64 pid) = 0;
+
+    // Samples every PID of one tick. The default implementation falls back to
+    // metricsForPid(); providers override it to read system-wide sensors once
+    // and share the values across all processes. Results are aligned with pids.
+    virtual QVector<ProcessMetrics> metricsForPids(const QVector<qint64>& pids);
+
+    // Like metricsForPids() but only the requested fields need to be filled
+    // in, fields[i] for pids[i]; the rest are left at 0 and ignored by the
+    // caller. pid and valid are always set, so an empty mask is a pure
+    // liveness check. The default implementation samples everything.
+    virtual QVector<ProcessMetrics> metricsForFields(const QVector<qint64>& pids,
+                                                     const QVector<MetricFieldMask>& fields);
+    // The same fields for every PID.
+    QVector<ProcessMetrics> metricsForFields(const QVector<qint64>& pids, MetricFieldMask fields);
+
+    // Called once a PID is no longer tracked so that per-process state such
+    // as cached file descriptors can be dropped.
+    virtual void releasePid(qint64 pid) { Q_UNUSED(pid); }
+
+    // When enabled, CPU and memory are summed over each PID and all of its
+    // descendants, for games that run as several processes (Proton, Wine,
+    // launchers). Providers without process trees ignore it.
+    virtual void setProcessTreeAggregation(bool enabled) { Q_UNUSED(enabled); }
+
+    // False when the PIDs sampled do not refer to processes on this machine,
+    // e.g. a replayed trace. The manager then neither watches them for exit
+    // or pressure stalls nor samples outside its own ticks.
+    virtual bool readsLiveProcesses() const { return true; }
+
+    // Whether the machine ran from its battery at the last sample. Providers
+    // without power supply information report false.
+    virtual bool onBattery() const { return false; }
+};
+
+// Filesystem roots read by the system provider. Tests and benchmarks point
+// them at a synthetic fixture tree. Frame timing channels are looked up as
+// "<frameChannelPrefix>-<pid>" in the POSIX shared-memory namespace.
+struct SystemPaths {
+    QString procRoot = QStringLiteral("/proc");
+    QString sysRoot = QStringLiteral("/sys");
+    QString frameChannelPrefix = QString::fromLatin1(FRAME_TIMING_DEFAULT_PREFIX);
 };
 
-std::shared_ptr<ProcessMetricsProvider> createSystemMetricsProvider();
+std::shared_ptr<ProcessMetricsProvider> createSystemMetricsProvider(const SystemPaths& paths = SystemPaths());
 
 } // namespace Runtime
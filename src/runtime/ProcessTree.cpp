@@ -0,0 +1,146 @@
+#include "ProcessTree.hpp"
+
+#include "ProcfsParsers.hpp"
+
+#include <dirent.h>
+
+namespace Runtime {
+
+namespace {
+constexpr int THREAD_COUNT_FIELD = 20;
+constexpr int CHILDREN_BUFFER_SIZE = 4096;
+constexpr int MAX_CHILDREN_PER_READ = 512;
+// Bounds the work per tick if something forks without end.
+constexpr int MAX_TREE_MEMBERS = 256;
+
+bool isNumeric(const char* name)
+{
+    if (*name == '\0') {
+        return false;
+    }
+    for (; *name != '\0'; ++name) {
+        if (*name < '0' || *name > '9') {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+ProcessTree::ProcessTree(qint64 rootPid, QByteArray procRoot)
+    : m_procRoot(std::move(procRoot))
+{
+    Member root;
+    root.pid = rootPid;
+    m_members.append(root);
+    m_memberPids.insert(rootPid);
+}
+
+qint64 ProcessTree::rootPid() const
+{
+    return m_members.first().pid;
+}
+
+int ProcessTree::memberCount() const
+{
+    return m_members.size();
+}
+
+qint64 ProcessTree::memberAt(int index) const
+{
+    return m_members.at(index).pid;
+}
+
+void ProcessTree::memberSampled(int index, const char* statData, qint64 statSize, FileDescriptorCache& files)
+{
+    if (index < 0 || index >= m_members.size()) {
+        return;
+    }
+
+    Member& member = m_members[index];
+    qint64 threadCount = 0;
+    if (Procfs::statField(statData, statSize, THREAD_COUNT_FIELD, &threadCount) && threadCount != member.threadCount) {
+        member.threadCount = threadCount;
+        member.rescanThreads = true;
+    }
+    if (member.rescanThreads) {
+        rescanThreads(member, files);
+    }
+
+    // Collect first: appending to m_members invalidates `member`.
+    qint64 children[MAX_CHILDREN_PER_READ];
+    int childCount = 0;
+    char buffer[CHILDREN_BUFFER_SIZE];
+    for (const QByteArray& path : member.childrenPaths) {
+        const qint64 bytes = files.readPath(path, buffer, sizeof(buffer));
+        if (bytes < 0) {
+            // The thread exited; pick up the new thread list next tick.
+            member.rescanThreads = true;
+            continue;
+        }
+        const int parsed = Procfs::pidList(buffer, bytes, children + childCount,
+                                           MAX_CHILDREN_PER_READ - childCount);
+        if (parsed > 0) {
+            childCount += parsed;
+        }
+    }
+
+    for (int i = 0; i < childCount && m_members.size() < MAX_TREE_MEMBERS; ++i) {
+        if (m_memberPids.contains(children[i])) {
+            continue;
+        }
+        Member child;
+        child.pid = children[i];
+        m_members.append(child);
+        m_memberPids.insert(child.pid);
+    }
+}
+
+void ProcessTree::removeMember(int index, FileDescriptorCache& files)
+{
+    if (index <= 0 || index >= m_members.size()) {
+        return;
+    }
+
+    Member& member = m_members[index];
+    releasePaths(member, files);
+    files.releasePid(member.pid);
+    m_memberPids.remove(member.pid);
+    m_members.removeAt(index);
+}
+
+void ProcessTree::release(FileDescriptorCache& files)
+{
+    releasePaths(m_members.first(), files);
+    while (m_members.size() > 1) {
+        removeMember(m_members.size() - 1, files);
+    }
+}
+
+void ProcessTree::rescanThreads(Member& member, FileDescriptorCache& files)
+{
+    releasePaths(member, files);
+    member.rescanThreads = false;
+
+    const QByteArray taskDir = m_procRoot + '/' + QByteArray::number(member.pid) + "/task";
+    DIR* dir = ::opendir(taskDir.constData());
+    if (!dir) {
+        return;
+    }
+    while (const dirent* entry = ::readdir(dir)) {
+        if (isNumeric(entry->d_name)) {
+            member.childrenPaths.append(taskDir + '/' + entry->d_name + "/children");
+        }
+    }
+    ::closedir(dir);
+}
+
+void ProcessTree::releasePaths(Member& member, FileDescriptorCache& files)
+{
+    for (const QByteArray& path : member.childrenPaths) {
+        files.releasePath(path);
+    }
+    member.childrenPaths.clear();
+}
+
+} // namespace Runtime
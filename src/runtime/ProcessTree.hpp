@@ -0,0 +1,52 @@
+#pragma once
+
+#include "FileDescriptorCache.hpp"
+
+#include <QByteArray>
+#include <QSet>
+#include <QVector>
+#include <QtGlobal>
+
+namespace Runtime {
+
+// One game's root process plus the descendants discovered through
+// /proc/<pid>/task/<tid>/children, kept between ticks so that /proc is never
+// rescanned. The provider visits members in order, reads each member's stat
+// and reports it through memberSampled(); children found there are appended
+// and visited in the same pass. A member's thread list is re-read only when
+// its thread count changes or one of its children files stops reading.
+class ProcessTree {
+public:
+    ProcessTree(qint64 rootPid, QByteArray procRoot);
+
+    qint64 rootPid() const;
+    int memberCount() const;
+    qint64 memberAt(int index) const;
+
+    void memberSampled(int index, const char* statData, qint64 statSize, FileDescriptorCache& files);
+
+    // Drops a member whose stat can no longer be read. Its children stay in
+    // the tree until they exit themselves. The root cannot be removed.
+    void removeMember(int index, FileDescriptorCache& files);
+
+    // Releases the descriptors of every member except the root, which the
+    // provider tracks on its own.
+    void release(FileDescriptorCache& files);
+
+private:
+    struct Member {
+        qint64 pid = 0;
+        qint64 threadCount = -1;
+        bool rescanThreads = true;
+        QVector<QByteArray> childrenPaths;
+    };
+
+    void rescanThreads(Member& member, FileDescriptorCache& files);
+    static void releasePaths(Member& member, FileDescriptorCache& files);
+
+    QByteArray m_procRoot;
+    QVector<Member> m_members;
+    QSet<qint64> m_memberPids;
+};
+
+} // namespace Runtime
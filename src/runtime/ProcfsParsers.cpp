@@ -0,0 +1,462 @@
+#include "ProcfsParsers.hpp"
+
+#include <cstring>
+#include <limits>
+
+namespace Runtime {
+namespace Procfs {
+
+namespace {
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+// Parses an optionally signed decimal integer starting at *pos and advances
+// *pos past it. Leading blanks are skipped. Fails on values beyond qint64.
+bool parseInteger(const char* data, qint64 size, qint64* pos, qint64* value)
+{
+    qint64 i = *pos;
+    while (i < size && (data[i] == ' ' || data[i] == '\t')) {
+        ++i;
+    }
+
+    bool negative = false;
+    if (i < size && (data[i] == '-' || data[i] == '+')) {
+        negative = data[i] == '-';
+        ++i;
+    }
+
+    const qint64 digitsStart = i;
+    constexpr quint64 MAX_VALUE = std::numeric_limits<qint64>::max();
+    quint64 result = 0;
+    while (i < size && isDigit(data[i])) {
+        const quint64 digit = static_cast<quint64>(data[i] - '0');
+        if (result > (MAX_VALUE - digit) / 10) {
+            return false;
+        }
+        result = result * 10 + digit;
+        ++i;
+    }
+    if (i == digitsStart) {
+        return false;
+    }
+
+    *value = negative ? -static_cast<qint64>(result) : static_cast<qint64>(result);
+    *pos = i;
+    return true;
+}
+
+bool hasPrefix(const char* data, qint64 size, const char* prefix, qint64 prefixLength)
+{
+    return size >= prefixLength && std::memcmp(data, prefix, prefixLength) == 0;
+}
+
+// Parses an unsigned decimal such as "12.34" at *pos and advances *pos past
+// it. The fraction is optional.
+bool parseDecimal(const char* data, qint64 size, qint64* pos, double* value)
+{
+    qint64 whole = 0;
+    qint64 i = *pos;
+    if (i >= size || !isDigit(data[i]) || !parseInteger(data, size, &i, &whole)) {
+        return false;
+    }
+    double result = static_cast<double>(whole);
+    if (i < size && data[i] == '.') {
+        double scale = 0.1;
+        for (++i; i < size && isDigit(data[i]); ++i) {
+            result += (data[i] - '0') * scale;
+            scale /= 10;
+        }
+    }
+    *value = result;
+    *pos = i;
+    return true;
+}
+
+// Finds "<key><value>" within the line [lineStart, lineEnd) and returns the
+// position of the value, or -1.
+qint64 findLineKey(const char* data, qint64 lineStart, qint64 lineEnd, const char* key, qint64 keyLength)
+{
+    for (qint64 pos = lineStart; pos + keyLength <= lineEnd; ++pos) {
+        if ((pos == lineStart || data[pos - 1] == ' ') && std::memcmp(data + pos, key, keyLength) == 0) {
+            return pos + keyLength;
+        }
+    }
+    return -1;
+}
+
+// The end of the line starting at lineStart, excluding the newline.
+qint64 lineEndFrom(const char* data, qint64 size, qint64 lineStart)
+{
+    const void* newline = std::memchr(data + lineStart, '\n', size - lineStart);
+    return newline ? static_cast<const char*>(newline) - data : size;
+}
+
+// Finds or adds the engine named [name, name + length). Returns nullptr when
+// the name does not fit or the table is full.
+DrmEngineCounters* drmEngine(DrmFdinfo* info, const char* name, qint64 length)
+{
+    if (length <= 0 || length >= DRM_ENGINE_NAME_SIZE) {
+        return nullptr;
+    }
+    for (int i = 0; i < info->engineCount; ++i) {
+        DrmEngineCounters& engine = info->engines[i];
+        if (std::strncmp(engine.name, name, length) == 0 && engine.name[length] == '\0') {
+            return &engine;
+        }
+    }
+    if (info->engineCount >= DRM_MAX_ENGINES) {
+        return nullptr;
+    }
+    DrmEngineCounters& engine = info->engines[info->engineCount++];
+    engine = DrmEngineCounters();
+    std::memcpy(engine.name, name, length);
+    engine.name[length] = '\0';
+    return &engine;
+}
+
+// Adds a drm-memory-<region> or drm-resident-<region> line to the VRAM or GTT
+// total. The region is [key + skip, key + keyLength), and the value, an
+// integer optionally followed by KiB or MiB, starts at pos. A bare integer
+// is in bytes.
+void addDrmMemory(const char* key, qint64 keyLength, qint64 lineLength, qint64 skip, qint64 pos,
+                  qint64* vramKb, qint64* gttKb)
+{
+    const char* region = key + skip;
+    const qint64 regionLength = keyLength - skip;
+    qint64* total = nullptr;
+    if (hasPrefix(region, regionLength, "vram", 4) || hasPrefix(region, regionLength, "local", 5)) {
+        total = vramKb;
+    } else if ((regionLength == 3 && hasPrefix(region, regionLength, "gtt", 3))
+               || hasPrefix(region, regionLength, "system", 6)) {
+        total = gttKb;
+    }
+    qint64 value = 0;
+    if (!total || !parseInteger(key, lineLength, &pos, &value) || value < 0) {
+        return;
+    }
+    while (pos < lineLength && (key[pos] == ' ' || key[pos] == '\t')) {
+        ++pos;
+    }
+    if (hasPrefix(key + pos, lineLength - pos, "KiB", 3)) {
+        *total += value;
+    } else if (hasPrefix(key + pos, lineLength - pos, "MiB", 3)) {
+        *total += value * 1024;
+    } else {
+        *total += value / 1024;
+    }
+}
+} // namespace
+
+bool statField(const char* data, qint64 size, int field, qint64* value)
+{
+    if (field < 4) {
+        return false;
+    }
+
+    qint64 closing = size - 1;
+    while (closing >= 0 && data[closing] != ')') {
+        --closing;
+    }
+    if (closing < 0) {
+        return false;
+    }
+
+    // After ") " comes field 3 (state); walk forward token by token.
+    qint64 i = closing + 1;
+    int current = 2;
+    while (i < size) {
+        while (i < size && data[i] == ' ') {
+            ++i;
+        }
+        if (i >= size || data[i] == '\n') {
+            return false;
+        }
+
+        ++current;
+        if (current == field) {
+            qint64 pos = i;
+            qint64 parsed = 0;
+            if (!parseInteger(data, size, &pos, &parsed)) {
+                return false;
+            }
+            if (pos < size && !isSpace(data[pos])) {
+                return false;
+            }
+            *value = parsed;
+            return true;
+        }
+
+        while (i < size && !isSpace(data[i])) {
+            ++i;
+        }
+    }
+
+    return false;
+}
+
+bool statCpuTicks(const char* data, qint64 size, qint64* ticks)
+{
+    qint64 utime = 0;
+    qint64 stime = 0;
+    if (!statField(data, size, 14, &utime) || !statField(data, size, 15, &stime)) {
+        return false;
+    }
+    *ticks = utime + stime;
+    return true;
+}
+
+bool statComm(const char* data, qint64 size, char* name, int nameSize)
+{
+    if (nameSize <= 0) {
+        return false;
+    }
+
+    const void* opening = std::memchr(data, '(', size);
+    qint64 closing = size - 1;
+    while (closing >= 0 && data[closing] != ')') {
+        --closing;
+    }
+    if (!opening || closing < 0) {
+        return false;
+    }
+    const qint64 start = static_cast<const char*>(opening) - data + 1;
+    if (closing < start) {
+        return false;
+    }
+
+    const qint64 length = qMin<qint64>(closing - start, nameSize - 1);
+    std::memcpy(name, data + start, length);
+    name[length] = '\0';
+    return true;
+}
+
+bool keyValueKb(const char* data, qint64 size, const char* key, qint64* kb)
+{
+    const qint64 keyLength = static_cast<qint64>(std::strlen(key));
+    qint64 lineStart = 0;
+    while (lineStart < size) {
+        if (size - lineStart >= keyLength && std::memcmp(data + lineStart, key, keyLength) == 0) {
+            qint64 pos = lineStart + keyLength;
+            return parseInteger(data, size, &pos, kb);
+        }
+
+        const void* newline = std::memchr(data + lineStart, '\n', size - lineStart);
+        if (!newline) {
+            break;
+        }
+        lineStart = static_cast<const char*>(newline) - data + 1;
+    }
+
+    return false;
+}
+
+bool statmResidentPages(const char* data, qint64 size, qint64* pages)
+{
+    qint64 pos = 0;
+    qint64 total = 0;
+    return parseInteger(data, size, &pos, &total) && parseInteger(data, size, &pos, pages);
+}
+
+bool sysfsInteger(const char* data, qint64 size, qint64* value)
+{
+    qint64 pos = 0;
+    while (pos < size && isSpace(data[pos])) {
+        ++pos;
+    }
+
+    qint64 parsed = 0;
+    if (!parseInteger(data, size, &pos, &parsed)) {
+        return false;
+    }
+    while (pos < size && isSpace(data[pos])) {
+        ++pos;
+    }
+    if (pos != size) {
+        return false;
+    }
+
+    *value = parsed;
+    return true;
+}
+
+int pidList(const char* data, qint64 size, qint64* pids, int maxCount)
+{
+    qint64 pos = 0;
+    int count = 0;
+    while (count < maxCount) {
+        while (pos < size && isSpace(data[pos])) {
+            ++pos;
+        }
+        if (pos >= size) {
+            break;
+        }
+
+        qint64 pid = 0;
+        if (!isDigit(data[pos]) || !parseInteger(data, size, &pos, &pid) || pid <= 0) {
+            return -1;
+        }
+        pids[count++] = pid;
+    }
+    return count;
+}
+
+bool drmFdinfo(const char* data, qint64 size, DrmFdinfo* info)
+{
+    constexpr char CLIENT_ID[] = "drm-client-id";
+    constexpr char PDEV[] = "drm-pdev";
+    constexpr char ENGINE_CAPACITY[] = "drm-engine-capacity-";
+    constexpr char ENGINE[] = "drm-engine-";
+    constexpr char TOTAL_CYCLES[] = "drm-total-cycles-";
+    constexpr char CYCLES[] = "drm-cycles-";
+    constexpr char MEMORY[] = "drm-memory-";
+    constexpr char RESIDENT[] = "drm-resident-";
+
+    DrmFdinfo parsed;
+    // amdgpu reports both key families for the same buffers.
+    bool hasMemoryKeys = false;
+    qint64 residentVramKb = 0;
+    qint64 residentGttKb = 0;
+    qint64 lineStart = 0;
+    while (lineStart < size) {
+        const void* newline = std::memchr(data + lineStart, '\n', size - lineStart);
+        const qint64 lineEnd = newline ? static_cast<const char*>(newline) - data : size;
+        const void* colon = std::memchr(data + lineStart, ':', lineEnd - lineStart);
+        if (colon) {
+            const char* key = data + lineStart;
+            const qint64 keyLength = static_cast<const char*>(colon) - key;
+            const qint64 lineLength = lineEnd - lineStart;
+            qint64 pos = keyLength + 1;
+            qint64 value = 0;
+            if (keyLength == static_cast<qint64>(sizeof(PDEV) - 1) && hasPrefix(key, keyLength, PDEV, sizeof(PDEV) - 1)) {
+                while (pos < lineLength && isSpace(key[pos])) {
+                    ++pos;
+                }
+                qint64 end = lineLength;
+                while (end > pos && isSpace(key[end - 1])) {
+                    --end;
+                }
+                const qint64 length = qMin<qint64>(end - pos, DRM_PDEV_SIZE - 1);
+                std::memcpy(parsed.pdev, key + pos, length);
+                parsed.pdev[length] = '\0';
+            } else if (hasPrefix(key, keyLength, MEMORY, sizeof(MEMORY) - 1)) {
+                hasMemoryKeys = true;
+                addDrmMemory(key, keyLength, lineLength, sizeof(MEMORY) - 1, pos, &parsed.vramKb, &parsed.gttKb);
+            } else if (hasPrefix(key, keyLength, RESIDENT, sizeof(RESIDENT) - 1)) {
+                addDrmMemory(key, keyLength, lineLength, sizeof(RESIDENT) - 1, pos, &residentVramKb, &residentGttKb);
+            } else if (parseInteger(key, lineLength, &pos, &value) && value >= 0) {
+                // The remaining values are integers, optionally followed by a unit.
+                DrmEngineCounters* engine = nullptr;
+                if (keyLength == static_cast<qint64>(sizeof(CLIENT_ID) - 1)
+                    && hasPrefix(key, keyLength, CLIENT_ID, sizeof(CLIENT_ID) - 1)) {
+                    parsed.clientId = value;
+                } else if (hasPrefix(key, keyLength, ENGINE_CAPACITY, sizeof(ENGINE_CAPACITY) - 1)) {
+                    const qint64 skip = sizeof(ENGINE_CAPACITY) - 1;
+                    if ((engine = drmEngine(&parsed, key + skip, keyLength - skip)) && value > 0) {
+                        engine->capacity = value;
+                    }
+                } else if (hasPrefix(key, keyLength, ENGINE, sizeof(ENGINE) - 1)) {
+                    const qint64 skip = sizeof(ENGINE) - 1;
+                    if ((engine = drmEngine(&parsed, key + skip, keyLength - skip))) {
+                        engine->hasBusyNs = true;
+                        engine->busyNs = static_cast<quint64>(value);
+                    }
+                } else if (hasPrefix(key, keyLength, TOTAL_CYCLES, sizeof(TOTAL_CYCLES) - 1)) {
+                    const qint64 skip = sizeof(TOTAL_CYCLES) - 1;
+                    if ((engine = drmEngine(&parsed, key + skip, keyLength - skip))) {
+                        engine->totalCycles = static_cast<quint64>(value);
+                    }
+                } else if (hasPrefix(key, keyLength, CYCLES, sizeof(CYCLES) - 1)) {
+                    const qint64 skip = sizeof(CYCLES) - 1;
+                    if ((engine = drmEngine(&parsed, key + skip, keyLength - skip))) {
+                        engine->cycles = static_cast<quint64>(value);
+                    }
+                }
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+
+    if (parsed.clientId < 0) {
+        return false;
+    }
+    if (!hasMemoryKeys) {
+        parsed.vramKb = residentVramKb;
+        parsed.gttKb = residentGttKb;
+    }
+    *info = parsed;
+    return true;
+}
+
+bool smapsRollup(const char* data, qint64 size, SmapsRollup* rollup)
+{
+    SmapsRollup parsed;
+    if (!keyValueKb(data, size, "Pss:", &parsed.pssKb)) {
+        return false;
+    }
+    qint64 privateClean = 0;
+    qint64 privateDirty = 0;
+    keyValueKb(data, size, "Private_Clean:", &privateClean);
+    keyValueKb(data, size, "Private_Dirty:", &privateDirty);
+    parsed.ussKb = privateClean + privateDirty;
+    if (!keyValueKb(data, size, "SwapPss:", &parsed.swapKb)) {
+        keyValueKb(data, size, "Swap:", &parsed.swapKb);
+    }
+    *rollup = parsed;
+    return true;
+}
+
+bool pressureSome(const char* data, qint64 size, PressureStats* stats)
+{
+    constexpr char SOME[] = "some ";
+    constexpr char AVG10[] = "avg10=";
+    constexpr char TOTAL[] = "total=";
+    qint64 lineStart = 0;
+    while (lineStart < size) {
+        const qint64 lineEnd = lineEndFrom(data, size, lineStart);
+        if (hasPrefix(data + lineStart, lineEnd - lineStart, SOME, sizeof(SOME) - 1)) {
+            PressureStats parsed;
+            qint64 avg10 = findLineKey(data, lineStart, lineEnd, AVG10, sizeof(AVG10) - 1);
+            qint64 total = findLineKey(data, lineStart, lineEnd, TOTAL, sizeof(TOTAL) - 1);
+            qint64 totalUs = 0;
+            if (avg10 < 0 || total < 0 || !parseDecimal(data, lineEnd, &avg10, &parsed.avg10)
+                || !parseInteger(data, lineEnd, &total, &totalUs) || totalUs < 0) {
+                return false;
+            }
+            parsed.totalUs = static_cast<quint64>(totalUs);
+            *stats = parsed;
+            return true;
+        }
+        lineStart = lineEnd + 1;
+    }
+    return false;
+}
+
+bool unifiedCgroupPath(const char* data, qint64 size, qint64* offset, qint64* length)
+{
+    constexpr char UNIFIED[] = "0::";
+    qint64 lineStart = 0;
+    while (lineStart < size) {
+        const qint64 lineEnd = lineEndFrom(data, size, lineStart);
+        if (hasPrefix(data + lineStart, lineEnd - lineStart, UNIFIED, sizeof(UNIFIED) - 1)) {
+            const qint64 pathStart = lineStart + sizeof(UNIFIED) - 1;
+            if (pathStart >= lineEnd || data[pathStart] != '/') {
+                return false;
+            }
+            *offset = pathStart;
+            *length = lineEnd - pathStart;
+            return true;
+        }
+        lineStart = lineEnd + 1;
+    }
+    return false;
+}
+
+} // namespace Procfs
+} // namespace Runtime
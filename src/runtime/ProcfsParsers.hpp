@@ -0,0 +1,113 @@
+#pragma once
+
+#include <QtGlobal>
+
+namespace Runtime {
+namespace Procfs {
+
+constexpr int DRM_ENGINE_NAME_SIZE = 16;
+// Fits a PCI address such as "0000:03:00.0" and platform device names.
+constexpr int DRM_PDEV_SIZE = 32;
+// Current drivers expose at most six engine classes per client.
+constexpr int DRM_MAX_ENGINES = 8;
+
+// The usage counters of one engine class of a DRM client. Utilization is
+// the busy time over wall time when busyNs is set, as on amdgpu and i915, or
+// busy cycles over total cycles when only cycles are exposed, as on xe.
+// Either way it is divided by capacity, the number of engines in the class.
+struct DrmEngineCounters {
+    char name[DRM_ENGINE_NAME_SIZE] = {}; // NUL-terminated.
+    bool hasBusyNs = false;
+    quint64 busyNs = 0;
+    quint64 cycles = 0;
+    quint64 totalCycles = 0;
+    qint64 capacity = 1;
+};
+
+// The DRM client keys of /proc/<pid>/fdinfo/<fd>, as documented in the
+// kernel's drm-usage-stats.
+struct DrmFdinfo {
+    qint64 clientId = -1;
+    char pdev[DRM_PDEV_SIZE] = {}; // The device the client is open on; NUL-terminated, may be empty.
+    int engineCount = 0;
+    DrmEngineCounters engines[DRM_MAX_ENGINES];
+    // Buffer objects of the client resident in device memory (VRAM, or
+    // "local" on i915) and in system memory mapped through the GTT.
+    qint64 vramKb = 0;
+    qint64 gttKb = 0;
+};
+
+// The totals of /proc/<pid>/smaps_rollup that RSS does not show. ussKb is
+// Private_Clean plus Private_Dirty. swapKb is SwapPss where the kernel has it
+// and Swap otherwise, so that it can be summed over processes like pssKb.
+struct SmapsRollup {
+    qint64 pssKb = 0;
+    qint64 ussKb = 0;
+    qint64 swapKb = 0;
+};
+
+// The "some" line of a PSI file such as /proc/pressure/memory or a cgroup's
+// memory.pressure: the share of wall time in which at least one task was
+// stalled on the resource, averaged over 10 s, and the cumulative stall time.
+struct PressureStats {
+    double avg10 = 0.0; // Percent.
+    quint64 totalUs = 0;
+};
+
+// Byte-level parsers for /proc and sysfs contents. They work directly on the
+// buffer filled by FileDescriptorCache and never allocate, so a steady-state
+// sample does not touch the heap. All of them return false on malformed input
+// and leave the output untouched.
+
+// Reads numeric field `field` of /proc/<pid>/stat, numbered as in proc(5)
+// (14 = utime, 15 = stime). Fields are counted from the last ')' so that a
+// comm containing spaces or parentheses cannot shift them. Only the numeric
+// fields, 4 and later, can be requested; field 3 (state) is a character.
+bool statField(const char* data, qint64 size, int field, qint64* value);
+
+// Convenience wrapper for utime + stime, in clock ticks.
+bool statCpuTicks(const char* data, qint64 size, qint64* ticks);
+
+// Field 2 of /proc/<pid>/stat, the comm between the first '(' and the last
+// ')', as /proc/<pid>/task/<tid>/comm would return it. Copied into name,
+// truncated to nameSize - 1 bytes and NUL-terminated.
+bool statComm(const char* data, qint64 size, char* name, int nameSize);
+
+// Finds a "Key:   <value> kB" line as used by /proc/<pid>/status and
+// /proc/meminfo. `key` includes the trailing colon, e.g. "VmRSS:".
+bool keyValueKb(const char* data, qint64 size, const char* key, qint64* kb);
+
+// Second field of /proc/<pid>/statm, in pages.
+bool statmResidentPages(const char* data, qint64 size, qint64* pages);
+
+// A single signed integer surrounded by optional whitespace, as exposed by
+// sysfs attributes such as temp1_input or gpu_busy_percent.
+bool sysfsInteger(const char* data, qint64 size, qint64* value);
+
+// Whitespace-separated PIDs as in /proc/<pid>/task/<tid>/children. Stores up
+// to maxCount of them in pids and returns how many were stored, or -1 if the
+// list is malformed.
+int pidList(const char* data, qint64 size, qint64* pids, int maxCount);
+
+// Reads the drm-client-id, drm-pdev, drm-engine-*, drm-engine-capacity-*, drm-cycles-*
+// and drm-total-cycles-* keys of a DRM fdinfo file into info. Other keys are
+// skipped, and engines beyond DRM_MAX_ENGINES are dropped. Memory comes from
+// the drm-memory-<region> keys, or from drm-resident-<region> on drivers
+// without them; "vram*" and "local*" regions count as VRAM, "gtt" and
+// "system*" as GTT. Returns false when there is no drm-client-id, i.e. the
+// descriptor is not a DRM client or its driver does not report usage.
+bool drmFdinfo(const char* data, qint64 size, DrmFdinfo* info);
+
+// Reads /proc/<pid>/smaps_rollup. Fails without a Pss line.
+bool smapsRollup(const char* data, qint64 size, SmapsRollup* rollup);
+
+// Reads the "some" line of a PSI file. The "full" line is ignored.
+bool pressureSome(const char* data, qint64 size, PressureStats* stats);
+
+// Finds the cgroup v2 entry, "0::<path>", of /proc/<pid>/cgroup and returns
+// where its path starts and how long it is. Fails on hosts that only mount
+// cgroup v1.
+bool unifiedCgroupPath(const char* data, qint64 size, qint64* offset, qint64* length);
+
+} // namespace Procfs
+} // namespace Runtime
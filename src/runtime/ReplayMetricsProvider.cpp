@@ -0,0 +1,287 @@
+#include "ReplayMetricsProvider.hpp"
+
+#include "FlightRecorder.hpp"
+
+#include <QElapsedTimer>
+#include <QFile>
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <numeric>
+
+namespace Runtime {
+
+namespace {
+constexpr int NO_COLUMN = -1;
+} // namespace
+
+ReplayMetricsProvider::ReplayMetricsProvider(Clock clock)
+    : m_clock(std::move(clock))
+{
+    if (!m_clock) {
+        auto timer = std::make_shared<QElapsedTimer>();
+        timer->start();
+        m_clock = [timer]() {
+            return timer->elapsed();
+        };
+    }
+}
+
+bool ReplayMetricsProvider::loadCsv(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        return false;
+    }
+
+    m_tracks.clear();
+    m_trackIndex.clear();
+
+    int timeColumn = NO_COLUMN;
+    int pidColumn = NO_COLUMN;
+    int titleColumn = NO_COLUMN;
+    int validColumn = NO_COLUMN;
+    int fieldColumns[METRIC_FIELD_COUNT];
+    std::fill(std::begin(fieldColumns), std::end(fieldColumns), NO_COLUMN);
+    bool haveHeader = false;
+
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const QList<QByteArray> columns = line.split(',');
+
+        if (!haveHeader) {
+            for (int i = 0; i < columns.size(); ++i) {
+                const QString name = QString::fromUtf8(columns[i].trimmed());
+                MetricField field;
+                if (name == QLatin1String("timeMs")) {
+                    timeColumn = i;
+                } else if (name == QLatin1String("pid")) {
+                    pidColumn = i;
+                } else if (name == QLatin1String("titleId")) {
+                    titleColumn = i;
+                } else if (name == QLatin1String("valid")) {
+                    validColumn = i;
+                } else if (metricFieldFromName(name, &field)) {
+                    fieldColumns[static_cast<int>(field)] = i;
+                }
+            }
+            if (timeColumn == NO_COLUMN || pidColumn == NO_COLUMN) {
+                return false;
+            }
+            haveHeader = true;
+            continue;
+        }
+
+        bool timeOk = false;
+        bool pidOk = false;
+        const qint64 timeMs = timeColumn < columns.size() ? columns[timeColumn].trimmed().toLongLong(&timeOk) : 0;
+        const qint64 pid = pidColumn < columns.size() ? columns[pidColumn].trimmed().toLongLong(&pidOk) : 0;
+        if (!timeOk || !pidOk) {
+            continue;
+        }
+
+        ProcessMetrics metrics;
+        metrics.pid = pid;
+        metrics.valid = validColumn == NO_COLUMN || validColumn >= columns.size()
+            || columns[validColumn].trimmed().toInt() != 0;
+        for (int i = 0; i < METRIC_FIELD_COUNT; ++i) {
+            const int column = fieldColumns[i];
+            if (column != NO_COLUMN && column < columns.size()) {
+                setMetricValue(metrics, static_cast<MetricField>(i), columns[column].trimmed().toDouble());
+            }
+        }
+        const QString titleId = titleColumn != NO_COLUMN && titleColumn < columns.size()
+            ? QString::fromUtf8(columns[titleColumn].trimmed())
+            : QString();
+        addSample(pid, titleId, timeMs, metrics);
+    }
+
+    finishLoading();
+    return haveHeader;
+}
+
+bool ReplayMetricsProvider::loadRecording(const QString& path)
+{
+    FlightRecording recording;
+    if (!readFlightRecording(path, &recording)) {
+        return false;
+    }
+    setRecording(recording);
+    return true;
+}
+
+void ReplayMetricsProvider::setRecording(const FlightRecording& recording)
+{
+    m_tracks.clear();
+    m_trackIndex.clear();
+    for (const FlightSample& sample : recording.samples) {
+        // Rows of a reused slot can no longer be attributed to a process.
+        if (sample.pid != 0) {
+            addSample(sample.pid, sample.titleId, sample.timeMs, sample.metrics);
+        }
+    }
+    finishLoading();
+}
+
+QVector<ReplayMetricsProvider::Game> ReplayMetricsProvider::games() const
+{
+    QVector<Game> games;
+    games.reserve(m_tracks.size());
+    for (const Track& track : m_tracks) {
+        games.append(track.game);
+    }
+    return games;
+}
+
+qint64 ReplayMetricsProvider::startTimeMs() const
+{
+    return m_stepTimes.isEmpty() ? 0 : m_stepTimes.first();
+}
+
+qint64 ReplayMetricsProvider::endTimeMs() const
+{
+    return m_stepTimes.isEmpty() ? 0 : m_stepTimes.last();
+}
+
+double ReplayMetricsProvider::speed() const
+{
+    return m_speed;
+}
+
+void ReplayMetricsProvider::setSpeed(double speed)
+{
+    speed = std::isfinite(speed) ? qMax(AS_FAST_AS_POSSIBLE, speed) : AS_FAST_AS_POSSIBLE;
+    if (speed == m_speed) {
+        return;
+    }
+
+    const qint64 now = traceTimeMs();
+    if (speed == AS_FAST_AS_POSSIBLE) {
+        // Continue stepping from the last timestamp already reached.
+        const auto reached = std::upper_bound(m_stepTimes.cbegin(), m_stepTimes.cend(), now);
+        m_step = static_cast<int>(reached - m_stepTimes.cbegin()) - 1;
+    }
+    m_speed = speed;
+    m_traceAnchorMs = now;
+    m_clockAnchorMs = m_clock();
+}
+
+void ReplayMetricsProvider::restart()
+{
+    for (Track& track : m_tracks) {
+        track.cursor = 0;
+    }
+    m_step = -1;
+    m_traceAnchorMs = startTimeMs();
+    m_clockAnchorMs = m_clock();
+}
+
+qint64 ReplayMetricsProvider::traceTimeMs() const
+{
+    if (m_speed == AS_FAST_AS_POSSIBLE) {
+        if (m_step < 0) {
+            return startTimeMs();
+        }
+        return m_step < m_stepTimes.size() ? m_stepTimes[m_step] : endTimeMs() + 1;
+    }
+    return m_traceAnchorMs + std::llround((m_clock() - m_clockAnchorMs) * m_speed);
+}
+
+bool ReplayMetricsProvider::finished() const
+{
+    return traceTimeMs() > endTimeMs();
+}
+
+ProcessMetrics ReplayMetricsProvider::metricsForPid(qint64 pid)
+{
+    return sampleAt(pid, traceTimeMs());
+}
+
+QVector<ProcessMetrics> ReplayMetricsProvider::metricsForPids(const QVector<qint64>& pids)
+{
+    if (m_speed == AS_FAST_AS_POSSIBLE && m_step < m_stepTimes.size()) {
+        ++m_step;
+    }
+
+    // One trace time for the whole tick, like one pass over /proc.
+    const qint64 now = traceTimeMs();
+    QVector<ProcessMetrics> result;
+    result.reserve(pids.size());
+    for (qint64 pid : pids) {
+        result.append(sampleAt(pid, now));
+    }
+    return result;
+}
+
+void ReplayMetricsProvider::addSample(qint64 pid, const QString& titleId, qint64 timeMs, const ProcessMetrics& metrics)
+{
+    auto it = m_trackIndex.constFind(pid);
+    if (it == m_trackIndex.constEnd()) {
+        Track track;
+        track.game.pid = pid;
+        track.game.titleId = titleId.isEmpty() ? QStringLiteral("replay-%1").arg(pid) : titleId;
+        it = m_trackIndex.insert(pid, m_tracks.size());
+        m_tracks.append(track);
+    }
+    Track& track = m_tracks[it.value()];
+    track.times.append(timeMs);
+    track.samples.append(metrics);
+    track.samples.last().pid = pid;
+}
+
+void ReplayMetricsProvider::finishLoading()
+{
+    m_stepTimes.clear();
+    for (Track& track : m_tracks) {
+        // Traces are normally in order already; keep equal timestamps stable.
+        QVector<int> order(track.times.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&track](int a, int b) {
+            return track.times[a] < track.times[b];
+        });
+        QVector<qint64> times;
+        QVector<ProcessMetrics> samples;
+        times.reserve(order.size());
+        samples.reserve(order.size());
+        for (int index : std::as_const(order)) {
+            times.append(track.times[index]);
+            samples.append(track.samples[index]);
+        }
+        track.times = times;
+        track.samples = samples;
+        m_stepTimes += track.times;
+    }
+    std::sort(m_stepTimes.begin(), m_stepTimes.end());
+    m_stepTimes.erase(std::unique(m_stepTimes.begin(), m_stepTimes.end()), m_stepTimes.end());
+    restart();
+}
+
+ProcessMetrics ReplayMetricsProvider::sampleAt(qint64 pid, qint64 traceTimeMs)
+{
+    auto it = m_trackIndex.constFind(pid);
+    if (it == m_trackIndex.constEnd()) {
+        ProcessMetrics gone;
+        gone.pid = pid;
+        return gone;
+    }
+
+    Track& track = m_tracks[it.value()];
+    if (traceTimeMs > track.times.last()) {
+        ProcessMetrics exited;
+        exited.pid = pid;
+        return exited;
+    }
+    if (track.cursor > 0 && track.times[track.cursor] > traceTimeMs) {
+        track.cursor = 0;
+    }
+    while (track.cursor + 1 < track.times.size() && track.times[track.cursor + 1] <= traceTimeMs) {
+        ++track.cursor;
+    }
+    return track.samples[track.cursor];
+}
+
+} // namespace Runtime
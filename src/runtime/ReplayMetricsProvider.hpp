@@ -0,0 +1,87 @@
+#pragma once
+
+#include "ProcessMetricsProvider.hpp"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include <functional>
+
+namespace Runtime {
+
+struct FlightRecording;
+
+// Plays back a recorded trace of per-PID samples instead of reading the
+// system, so that RunningManager, the alert rules and the overlay can be
+// driven through real telemetry at any speed and with reproducible results.
+//
+// Trace time advances with an injectable millisecond clock, scaled by
+// speed(); at AS_FAST_AS_POSSIBLE every metricsForPids() call steps to the
+// next timestamp in the trace instead. A PID reports its latest sample at or
+// before the trace time: its first sample before it appears in the trace, and
+// an invalid sample (the process exited) once the trace time passes its last.
+class ReplayMetricsProvider : public ProcessMetricsProvider {
+public:
+    // Returns monotonic milliseconds.
+    using Clock = std::function<qint64()>;
+
+    static constexpr double AS_FAST_AS_POSSIBLE = 0.0;
+
+    struct Game {
+        qint64 pid = 0;
+        QString titleId;
+    };
+
+    // Uses a steady clock unless one is given.
+    explicit ReplayMetricsProvider(Clock clock = Clock());
+
+    // Text trace: a header line naming the columns, then one sample per line.
+    // "timeMs" and "pid" are required; "titleId", "valid" and the metric names
+    // ("cpuPercent", ...) are optional. Lines starting with '#' are ignored.
+    bool loadCsv(const QString& path);
+    // A FlightRecorder file.
+    bool loadRecording(const QString& path);
+    void setRecording(const FlightRecording& recording);
+
+    // The PIDs in the trace, in order of first appearance.
+    QVector<Game> games() const;
+    qint64 startTimeMs() const;
+    qint64 endTimeMs() const;
+
+    double speed() const;
+    // Keeps the trace time continuous across the change.
+    void setSpeed(double speed);
+
+    // Rewinds to the start of the trace.
+    void restart();
+    qint64 traceTimeMs() const;
+    bool finished() const;
+
+    ProcessMetrics metricsForPid(qint64 pid) override;
+    QVector<ProcessMetrics> metricsForPids(const QVector<qint64>& pids) override;
+    bool readsLiveProcesses() const override { return false; }
+
+private:
+    struct Track {
+        Game game;
+        QVector<qint64> times;
+        QVector<ProcessMetrics> samples;
+        int cursor = 0;
+    };
+
+    void addSample(qint64 pid, const QString& titleId, qint64 timeMs, const ProcessMetrics& metrics);
+    void finishLoading();
+    ProcessMetrics sampleAt(qint64 pid, qint64 traceTimeMs);
+
+    Clock m_clock;
+    double m_speed = 1.0;
+    QVector<Track> m_tracks;
+    QHash<qint64, int> m_trackIndex;
+    QVector<qint64> m_stepTimes;
+    int m_step = -1;
+    qint64 m_traceAnchorMs = 0;
+    qint64 m_clockAnchorMs = 0;
+};
+
+} // namespace Runtime
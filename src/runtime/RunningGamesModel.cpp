@@ -0,0 +1,309 @@
+#include "RunningGamesModel.hpp"
+
+#include <cstring>
+
+namespace Runtime {
+
+RunningGamesModel::RunningGamesModel(QObject* parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int RunningGamesModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid()) {
+        return 0;
+    }
+    return m_rows.size();
+}
+
+QVariant RunningGamesModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid() || index.row() < 0 || index.row() >= m_rows.size()) {
+        return {};
+    }
+
+    const GameRow& game = m_rows.at(index.row());
+    switch (role) {
+    case Qt::DisplayRole:
+    case DisplayNameRole:
+        return game.displayName;
+    case TitleIdRole:
+        return game.titleId;
+    case PidRole:
+        return game.pid;
+    case SupportsSuspendRole:
+        return game.supportsSuspend;
+    case SuspendUnsupportedReasonRole:
+        return game.suspendUnsupportedReason;
+    case StateRole:
+        return game.suspended ? QStringLiteral("suspended") : QStringLiteral("running");
+    case MetricsValidRole:
+        return game.metrics.valid;
+    case CpuPercentRole:
+        return game.metrics.cpuPercent;
+    case GpuPercentRole:
+        return game.metrics.gpuPercent;
+    case RamMbRole:
+        return game.metrics.ramMb;
+    case RamPercentRole:
+        return game.metrics.ramPercent;
+    case TemperatureCRole:
+        return game.metrics.temperatureC;
+    case GpuTemperatureCRole:
+        return game.metrics.gpuTemperatureC;
+    case PowerWattsRole:
+        return game.metrics.powerWatts;
+    case FpsRole:
+        return game.metrics.fps;
+    case FrameTimeMsRole:
+        return game.metrics.frameTimeMs;
+    case FrameTimeMaxMsRole:
+        return game.metrics.frameTimeMaxMs;
+    case ThreadCpuPercentRole:
+        return game.metrics.threadCpuPercent;
+    case GpuDeviceRole:
+        return QString::fromLatin1(game.metrics.gpuDevice);
+    case GpuBusyPercentRole:
+        return game.metrics.gpuBusyPercent;
+    case GpuPowerWattsRole:
+        return game.metrics.gpuPowerWatts;
+    case PssMbRole:
+        return game.metrics.pssMb;
+    case PssPercentRole:
+        return game.metrics.pssPercent;
+    case UssMbRole:
+        return game.metrics.ussMb;
+    case SwapMbRole:
+        return game.metrics.swapMb;
+    case VramMbRole:
+        return game.metrics.vramMb;
+    case GttMbRole:
+        return game.metrics.gttMb;
+    case CpuPressureRole:
+        return game.metrics.cpuPressure;
+    case MemoryPressureRole:
+        return game.metrics.memoryPressure;
+    case IoPressureRole:
+        return game.metrics.ioPressure;
+    case CpuStallPercentRole:
+        return game.metrics.cpuStallPercent;
+    case MemoryStallPercentRole:
+        return game.metrics.memoryStallPercent;
+    case IoStallPercentRole:
+        return game.metrics.ioStallPercent;
+    case MetricsRole:
+        return QVariant::fromValue(game.metrics);
+    default:
+        return {};
+    }
+}
+
+QHash<int, QByteArray> RunningGamesModel::roleNames() const
+{
+    return {
+        {TitleIdRole, "titleId"},
+        {DisplayNameRole, "displayName"},
+        {PidRole, "pid"},
+        {SupportsSuspendRole, "supportsSuspend"},
+        {SuspendUnsupportedReasonRole, "suspendUnsupportedReason"},
+        {StateRole, "state"},
+        {MetricsValidRole, "metricsValid"},
+        {CpuPercentRole, "cpuPercent"},
+        {GpuPercentRole, "gpuPercent"},
+        {RamMbRole, "ramMb"},
+        {RamPercentRole, "ramPercent"},
+        {TemperatureCRole, "temperatureC"},
+        {GpuTemperatureCRole, "gpuTemperatureC"},
+        {PowerWattsRole, "powerWatts"},
+        {FpsRole, "fps"},
+        {FrameTimeMsRole, "frameTimeMs"},
+        {FrameTimeMaxMsRole, "frameTimeMaxMs"},
+        {ThreadCpuPercentRole, "threadCpuPercent"},
+        {GpuDeviceRole, "gpuDevice"},
+        {GpuBusyPercentRole, "gpuBusyPercent"},
+        {GpuPowerWattsRole, "gpuPowerWatts"},
+        {PssMbRole, "pssMb"},
+        {PssPercentRole, "pssPercent"},
+        {UssMbRole, "ussMb"},
+        {SwapMbRole, "swapMb"},
+        {VramMbRole, "vramMb"},
+        {GttMbRole, "gttMb"},
+        {CpuPressureRole, "cpuPressure"},
+        {MemoryPressureRole, "memoryPressure"},
+        {IoPressureRole, "ioPressure"},
+        {CpuStallPercentRole, "cpuStallPercent"},
+        {MemoryStallPercentRole, "memoryStallPercent"},
+        {IoStallPercentRole, "ioStallPercent"},
+        {MetricsRole, "metrics"}
+    };
+}
+
+int RunningGamesModel::count() const
+{
+    return m_rows.size();
+}
+
+void RunningGamesModel::insertGame(int row, const GameRow& game)
+{
+    row = qBound(0, row, static_cast<int>(m_rows.size()));
+    beginInsertRows(QModelIndex(), row, row);
+    m_rows.insert(row, game);
+    endInsertRows();
+    emit countChanged();
+}
+
+void RunningGamesModel::removeGame(int row)
+{
+    if (row < 0 || row >= m_rows.size()) {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+    m_rows.removeAt(row);
+    endRemoveRows();
+    emit countChanged();
+}
+
+void RunningGamesModel::updateGame(int row, const GameRow& game)
+{
+    if (row < 0 || row >= m_rows.size()) {
+        return;
+    }
+
+    GameRow& current = m_rows[row];
+    QList<int> roles;
+    if (current.titleId != game.titleId) {
+        roles.append(TitleIdRole);
+    }
+    if (current.displayName != game.displayName) {
+        roles.append(DisplayNameRole);
+        roles.append(Qt::DisplayRole);
+    }
+    if (current.pid != game.pid) {
+        roles.append(PidRole);
+    }
+    if (current.supportsSuspend != game.supportsSuspend) {
+        roles.append(SupportsSuspendRole);
+    }
+    if (current.suspendUnsupportedReason != game.suspendUnsupportedReason) {
+        roles.append(SuspendUnsupportedReasonRole);
+    }
+    if (current.suspended != game.suspended) {
+        roles.append(StateRole);
+    }
+    collectMetricRoles(current.metrics, game.metrics, roles);
+
+    current = game;
+    if (!roles.isEmpty()) {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, roles);
+    }
+}
+
+void RunningGamesModel::updateMetrics(int row, const ProcessMetrics& metrics)
+{
+    if (row < 0 || row >= m_rows.size()) {
+        return;
+    }
+
+    GameRow& current = m_rows[row];
+    QList<int> roles;
+    collectMetricRoles(current.metrics, metrics, roles);
+    current.metrics = metrics;
+    if (!roles.isEmpty()) {
+        const QModelIndex changed = index(row);
+        emit dataChanged(changed, changed, roles);
+    }
+}
+
+void RunningGamesModel::collectMetricRoles(const ProcessMetrics& before, const ProcessMetrics& after, QList<int>& roles)
+{
+    const int firstMetricRole = roles.size();
+    if (before.valid != after.valid) {
+        roles.append(MetricsValidRole);
+    }
+    if (before.cpuPercent != after.cpuPercent) {
+        roles.append(CpuPercentRole);
+    }
+    if (before.gpuPercent != after.gpuPercent) {
+        roles.append(GpuPercentRole);
+    }
+    if (before.ramMb != after.ramMb) {
+        roles.append(RamMbRole);
+    }
+    if (before.ramPercent != after.ramPercent) {
+        roles.append(RamPercentRole);
+    }
+    if (before.temperatureC != after.temperatureC) {
+        roles.append(TemperatureCRole);
+    }
+    if (before.gpuTemperatureC != after.gpuTemperatureC) {
+        roles.append(GpuTemperatureCRole);
+    }
+    if (before.powerWatts != after.powerWatts) {
+        roles.append(PowerWattsRole);
+    }
+    if (before.fps != after.fps) {
+        roles.append(FpsRole);
+    }
+    if (before.frameTimeMs != after.frameTimeMs) {
+        roles.append(FrameTimeMsRole);
+    }
+    if (before.frameTimeMaxMs != after.frameTimeMaxMs) {
+        roles.append(FrameTimeMaxMsRole);
+    }
+    if (before.threadCpuPercent != after.threadCpuPercent) {
+        roles.append(ThreadCpuPercentRole);
+    }
+    if (std::strcmp(before.gpuDevice, after.gpuDevice) != 0) {
+        roles.append(GpuDeviceRole);
+    }
+    if (before.gpuBusyPercent != after.gpuBusyPercent) {
+        roles.append(GpuBusyPercentRole);
+    }
+    if (before.gpuPowerWatts != after.gpuPowerWatts) {
+        roles.append(GpuPowerWattsRole);
+    }
+    if (before.pssMb != after.pssMb) {
+        roles.append(PssMbRole);
+    }
+    if (before.pssPercent != after.pssPercent) {
+        roles.append(PssPercentRole);
+    }
+    if (before.ussMb != after.ussMb) {
+        roles.append(UssMbRole);
+    }
+    if (before.swapMb != after.swapMb) {
+        roles.append(SwapMbRole);
+    }
+    if (before.vramMb != after.vramMb) {
+        roles.append(VramMbRole);
+    }
+    if (before.gttMb != after.gttMb) {
+        roles.append(GttMbRole);
+    }
+    if (before.cpuPressure != after.cpuPressure) {
+        roles.append(CpuPressureRole);
+    }
+    if (before.memoryPressure != after.memoryPressure) {
+        roles.append(MemoryPressureRole);
+    }
+    if (before.ioPressure != after.ioPressure) {
+        roles.append(IoPressureRole);
+    }
+    if (before.cpuStallPercent != after.cpuStallPercent) {
+        roles.append(CpuStallPercentRole);
+    }
+    if (before.memoryStallPercent != after.memoryStallPercent) {
+        roles.append(MemoryStallPercentRole);
+    }
+    if (before.ioStallPercent != after.ioStallPercent) {
+        roles.append(IoStallPercentRole);
+    }
+    if (roles.size() > firstMetricRole) {
+        roles.append(MetricsRole);
+    }
+}
+
+} // namespace Runtime
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ProcessMetricsProvider.hpp"
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVector>
+
+namespace Runtime {
+
+// Row-stable list model of running games. RunningManager pushes changes into
+// it so that delegates are created once per game and only the roles whose
+// values changed are refreshed on each tick.
+class RunningGamesModel : public QAbstractListModel {
+    Q_OBJECT
+    Q_PROPERTY(int count READ count NOTIFY countChanged)
+
+public:
+    enum Role {
+        TitleIdRole = Qt::UserRole + 1,
+        DisplayNameRole,
+        PidRole,
+        SupportsSuspendRole,
+        SuspendUnsupportedReasonRole,
+        StateRole,
+        MetricsValidRole,
+        CpuPercentRole,
+        GpuPercentRole,
+        RamMbRole,
+        RamPercentRole,
+        TemperatureCRole,
+        GpuTemperatureCRole,
+        PowerWattsRole,
+        FpsRole,
+        FrameTimeMsRole,
+        FrameTimeMaxMsRole,
+        ThreadCpuPercentRole,
+        GpuDeviceRole,
+        GpuBusyPercentRole,
+        GpuPowerWattsRole,
+        PssMbRole,
+        PssPercentRole,
+        UssMbRole,
+        SwapMbRole,
+        VramMbRole,
+        GttMbRole,
+        CpuPressureRole,
+        MemoryPressureRole,
+        IoPressureRole,
+        CpuStallPercentRole,
+        MemoryStallPercentRole,
+        IoStallPercentRole,
+        // The whole ProcessMetrics gadget, for delegates that show many fields.
+        MetricsRole
+    };
+    Q_ENUM(Role)
+
+    struct GameRow {
+        QString titleId;
+        QString displayName;
+        qint64 pid = 0;
+        bool supportsSuspend = false;
+        QString suspendUnsupportedReason;
+        bool suspended = false;
+        ProcessMetrics metrics;
+    };
+
+    explicit RunningGamesModel(QObject* parent = nullptr);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    int count() const;
+
+    void insertGame(int row, const GameRow& game);
+    void removeGame(int row);
+    void updateGame(int row, const GameRow& game);
+    void updateMetrics(int row, const ProcessMetrics& metrics);
+
+signals:
+    void countChanged();
+
+private:
+    static void collectMetricRoles(const ProcessMetrics& before, const ProcessMetrics& after, QList<int>& roles);
+
+    QVector<GameRow> m_rows;
+};
+
+} // namespace Runtime
@@ -3,16 +3,14 @@
 #include <QDateTime>
 #include <QVariantMap>
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+
 namespace Runtime {
 
 namespace {
-constexpr double CPU_ALERT_THRESHOLD = 95.0;
-constexpr double GPU_ALERT_THRESHOLD = 95.0;
-constexpr double RAM_ALERT_THRESHOLD_PERCENT = 90.0;
-constexpr double TEMP_ALERT_THRESHOLD = 85.0;
-constexpr double GPU_TEMP_ALERT_THRESHOLD = 85.0;
-constexpr double POWER_ALERT_THRESHOLD = 120.0;
-constexpr double FPS_FLOOR_ALERT = 15.0;
+constexpr qint64 NS_PER_MS = 1'000'000;
 
 QString severityToString(RunningManager::AlertSeverity severity)
 {
@@ -30,17 +28,30 @@ RunningManager::RunningManager(QObject* parent)
 RunningManager::RunningManager(std::shared_ptr<ProcessMetricsProvider> provider, QObject* parent)
     : QObject(parent)
     , m_metricsProvider(provider ? provider : createSystemMetricsProvider())
+    , m_sampler(std::make_shared<MetricsSampler>(m_metricsProvider))
+    , m_gamesModel(new RunningGamesModel(this))
+    , m_alertsModel(new ActiveAlertsModel(this))
+    , m_exitWatcher(new ProcessExitWatcher(this))
+    , m_pressureMonitor(new PressureMonitor(SystemPaths(), this))
 {
-    m_updateTimer.setInterval(m_updateIntervalMs);
+    qRegisterMetaType<Runtime::MetricsSnapshot>();
+
+    // One-shot timer armed for the next group deadline after every tick.
+    m_updateTimer.setSingleShot(true);
+    m_updateTimer.setTimerType(Qt::PreciseTimer);
     connect(&m_updateTimer, &QTimer::timeout, this, &RunningManager::updateMetrics);
-    if (m_metricsProvider) {
-        m_updateTimer.start();
-    }
+    connect(m_exitWatcher, &ProcessExitWatcher::processExited, this, &RunningManager::onProcessExited);
+    connect(m_pressureMonitor, &PressureMonitor::stallDetected, this, &RunningManager::onPressureStall);
+    m_demandedFields = m_alertEngine.fields();
+    m_clock.start();
+    m_scheduler.start(clockNs());
+    scheduleNextSample();
 }
 
 RunningManager::~RunningManager()
 {
     m_updateTimer.stop();
+    stopSamplerThread();
 }
 
 QVariantList RunningManager::games() const
@@ -57,13 +68,26 @@ QVariantList RunningManager::alerts() const
 {
     QVariantList list;
     for (const auto& game : m_games) {
-        for (const auto& alert : game.activeAlerts) {
-            list.append(serializeAlert(alert));
+        for (int i = 0; i < ALERT_KIND_COUNT; ++i) {
+            const auto kind = static_cast<AlertKind>(i);
+            if (game.alerts.active & alertKindBit(kind)) {
+                list.append(serializeAlert(game.alertInfo[i]));
+            }
         }
     }
     return list;
 }
 
+RunningGamesModel* RunningManager::gamesModel() const
+{
+    return m_gamesModel;
+}
+
+ActiveAlertsModel* RunningManager::alertsModel() const
+{
+    return m_alertsModel;
+}
+
 int RunningManager::updateIntervalMs() const
 {
     return m_updateIntervalMs;
@@ -79,24 +103,206 @@ void RunningManager::setUpdateIntervalMs(int interval)
     }
 
     m_updateIntervalMs = interval;
-    m_updateTimer.setInterval(m_updateIntervalMs);
+    m_scheduler.setBaseIntervalMs(m_updateIntervalMs, clockNs());
+    scheduleNextSample();
     emit updateIntervalMsChanged();
 }
 
+bool RunningManager::threadedSampling() const
+{
+    return m_threadedSampling;
+}
+
+void RunningManager::setThreadedSampling(bool enabled)
+{
+    if (m_threadedSampling == enabled) {
+        return;
+    }
+
+    m_threadedSampling = enabled;
+    if (m_threadedSampling) {
+        startSamplerThread();
+    } else {
+        stopSamplerThread();
+    }
+    // A dropped in-flight sample would otherwise leave the timer disarmed.
+    scheduleNextSample();
+    emit threadedSamplingChanged();
+}
+
+bool RunningManager::aggregateProcessTree() const
+{
+    return m_aggregateProcessTree;
+}
+
+void RunningManager::setAggregateProcessTree(bool enabled)
+{
+    if (m_aggregateProcessTree == enabled) {
+        return;
+    }
+
+    m_aggregateProcessTree = enabled;
+    configureSampler();
+    emit aggregateProcessTreeChanged();
+}
+
+int RunningManager::historyCapacity() const
+{
+    return m_historyCapacity;
+}
+
+void RunningManager::setHistoryCapacity(int capacity)
+{
+    if (capacity <= 0) {
+        capacity = 300;
+    }
+    if (m_historyCapacity == capacity) {
+        return;
+    }
+
+    m_historyCapacity = capacity;
+    emit historyCapacityChanged();
+}
+
+bool RunningManager::overlayVisible() const
+{
+    return m_overlayVisible;
+}
+
+void RunningManager::setOverlayVisible(bool visible)
+{
+    if (m_overlayVisible == visible) {
+        return;
+    }
+
+    m_overlayVisible = visible;
+    updateLowPower();
+    emit overlayVisibleChanged();
+}
+
+bool RunningManager::onBattery() const
+{
+    return m_onBattery;
+}
+
+void RunningManager::setOnBattery(bool onBattery)
+{
+    if (m_onBattery == onBattery) {
+        return;
+    }
+
+    ChangeTransaction transaction(this);
+    m_onBattery = onBattery;
+    m_changes.batteryChanged = true;
+    updateLowPower();
+}
+
+bool RunningManager::startRecording(const QString& path)
+{
+    const bool wasRecording = m_recorder.isOpen();
+    if (!m_recorder.open(path)) {
+        if (wasRecording) {
+            emit recordingChanged();
+        }
+        return false;
+    }
+
+    const qint64 nowMs = QDateTime::currentMSecsSinceEpoch();
+    for (auto& game : m_games) {
+        game.recorderSlot = m_recorder.registerGame(game.pid, game.titleId, nowMs);
+    }
+    if (!wasRecording) {
+        emit recordingChanged();
+    }
+    return true;
+}
+
+void RunningManager::stopRecording()
+{
+    if (!m_recorder.isOpen()) {
+        return;
+    }
+
+    m_recorder.close();
+    for (auto& game : m_games) {
+        game.recorderSlot = -1;
+    }
+    emit recordingChanged();
+}
+
+bool RunningManager::recording() const
+{
+    return m_recorder.isOpen();
+}
+
+bool RunningManager::startExporter(int port, const QString& address)
+{
+    const quint16 previousPort = m_exporter.serverPort();
+    const QHostAddress hostAddress(address);
+    const bool listening = port >= 0 && port <= std::numeric_limits<quint16>::max() && !hostAddress.isNull()
+        && m_exporter.listen(hostAddress, static_cast<quint16>(port));
+    if (listening) {
+        // Every exported gauge has to stay fresh, whatever else is subscribed.
+        if (m_exporterSubscription == 0) {
+            m_exporterSubscription = subscribeAll();
+        }
+        publishExport();
+    } else if (!m_exporter.isListening() && m_exporterSubscription != 0) {
+        unsubscribe(m_exporterSubscription);
+        m_exporterSubscription = 0;
+    }
+    if (m_exporter.serverPort() != previousPort) {
+        emit exporterPortChanged();
+    }
+    return listening;
+}
+
+void RunningManager::stopExporter()
+{
+    if (!m_exporter.isListening()) {
+        return;
+    }
+
+    m_exporter.close();
+    unsubscribe(m_exporterSubscription);
+    m_exporterSubscription = 0;
+    emit exporterPortChanged();
+}
+
+int RunningManager::exporterPort() const
+{
+    return m_exporter.serverPort();
+}
+
 void RunningManager::registerGame(const QString& titleId,
                                   const QString& displayName,
                                   qint64 pid,
                                   bool supportsSuspend,
                                   const QString& suspendUnsupportedReason)
 {
+    ChangeTransaction transaction(this);
+    QStringList clearedAlerts;
     int index = indexForId(titleId);
     if (index >= 0) {
         auto& game = m_games[index];
+        if (game.pid != pid) {
+            releaseProviderPid(game.pid);
+            m_exitWatcher->unwatch(game.pid);
+            m_pressureMonitor->unwatch(game.pid);
+            game.history->clear();
+            game.distribution->clear();
+            clearedAlerts = clearAlerts(game);
+            if (m_recorder.isOpen()) {
+                game.recorderSlot = m_recorder.registerGame(pid, titleId, QDateTime::currentMSecsSinceEpoch());
+            }
+        }
         game.displayName = displayName;
         game.pid = pid;
         game.supportsSuspend = supportsSuspend;
         game.suspendUnsupportedReason = suspendUnsupportedReason;
         game.state = GameState::Running;
+        m_gamesModel->updateGame(index, gameRow(game));
+        recordGameUpdated(titleId);
     } else {
         RunningGame game;
         game.titleId = titleId;
@@ -104,15 +310,29 @@ void RunningManager::registerGame(const QString& titleId,
         game.pid = pid;
         game.supportsSuspend = supportsSuspend;
         game.suspendUnsupportedReason = suspendUnsupportedReason;
+        game.exportLabel = openMetricsLabelValue(titleId);
+        game.history = std::make_shared<MetricHistory>(m_historyCapacity);
+        game.distribution = std::make_shared<MetricDistribution>();
+        if (m_recorder.isOpen()) {
+            game.recorderSlot = m_recorder.registerGame(pid, titleId, QDateTime::currentMSecsSinceEpoch());
+        }
         m_gameIndex.insert(titleId, m_games.size());
         m_games.push_back(game);
+        m_gamesModel->insertGame(m_games.size() - 1, gameRow(game));
+        recordGameAdded(titleId);
+        updateDemand();
     }
 
-    if (!m_updateTimer.isActive() && m_metricsProvider) {
-        m_updateTimer.start();
+    // Without a pidfd the exit is still noticed by the next sample, and
+    // without PSI triggers stalls by the medium group.
+    if (watchesProcesses()) {
+        m_exitWatcher->watch(pid);
+        m_pressureMonitor->watch(pid);
     }
 
-    emit gamesChanged();
+    for (const QString& type : std::as_const(clearedAlerts)) {
+        emit alertCleared(titleId, type);
+    }
 }
 
 void RunningManager::markGameExited(const QString& titleId)
@@ -122,24 +342,70 @@ void RunningManager::markGameExited(const QString& titleId)
         return;
     }
 
+    ChangeTransaction transaction(this);
     removeGameAt(index);
     emit gameClosed(titleId);
-    emit gamesChanged();
+}
+
+void RunningManager::onProcessExited(qint64 pid)
+{
+    for (const auto& game : std::as_const(m_games)) {
+        if (game.pid == pid) {
+            const QString titleId = game.titleId;
+            markGameExited(titleId);
+            return;
+        }
+    }
+}
+
+void RunningManager::onPressureStall(qint64 pid, PressureResource resource)
+{
+    Q_UNUSED(resource);
+    const MetricFieldMask fields = PRESSURE_FIELDS & m_demandedFields;
+    if (!watchesProcesses() || fields == 0 || (m_threadedSampling && m_samplePending)) {
+        return;
+    }
+
+    // Sample the stall now instead of at the next medium tick, so that its
+    // alert is raised while the game is still stuttering. The kernel fires a
+    // trigger at most once per window.
+    const bool tracked = std::any_of(m_games.cbegin(), m_games.cend(), [pid](const RunningGame& game) {
+        return game.pid == pid && game.state != GameState::Suspended;
+    });
+    if (tracked) {
+        sampleFields(fields);
+    }
 }
 
 void RunningManager::refreshNow()
 {
-    updateMetrics();
+    if (!m_metricsProvider || (m_threadedSampling && m_samplePending)) {
+        return;
+    }
+
+    m_scheduler.markAllSampled(clockNs());
+    sampleFields(m_demandedFields);
+    scheduleNextSample();
+}
+
+ProcessMetrics RunningManager::metricsFor(const QString& titleId) const
+{
+    int index = indexForId(titleId);
+    if (index < 0) {
+        return {};
+    }
+
+    return m_games[index].metrics;
 }
 
-QVariantMap RunningManager::metricsFor(const QString& titleId) const
+QVariantList RunningManager::hotThreads(const QString& titleId) const
 {
     int index = indexForId(titleId);
     if (index < 0) {
         return {};
     }
 
-    return serializeGame(m_games[index]).value(QStringLiteral("metrics")).toMap();
+    return serializeHotThreads(m_games[index].metrics);
 }
 
 void RunningManager::focusGame(const QString& titleId)
@@ -162,15 +428,14 @@ void RunningManager::suspendGame(const QString& titleId)
 
     auto& game = m_games[index];
     if (!game.supportsSuspend) {
-        QVariantMap alert;
-        alert["type"] = QStringLiteral("suspendUnsupported");
-        alert["titleId"] = game.titleId;
-        alert["message"] = game.suspendUnsupportedReason.isEmpty()
-            ? tr("Suspend is not supported for this title.")
-            : game.suspendUnsupportedReason;
-        alert["severity"] = QStringLiteral("warning");
+        AlertInfo alert;
+        alert.type = QStringLiteral("suspendUnsupported");
+        alert.titleId = game.titleId;
+        alert.message = suspendUnsupportedMessage(game);
+        alert.severity = severityToString(AlertSeverity::Warning);
+        alert.raisedAtMs = QDateTime::currentMSecsSinceEpoch();
+        // A one-off notice; it is not kept in alerts().
         emit alertRaised(game.titleId, alert);
-        emit alertsChanged();
         return;
     }
 
@@ -178,10 +443,12 @@ void RunningManager::suspendGame(const QString& titleId)
         return;
     }
 
+    ChangeTransaction transaction(this);
     game.state = GameState::Suspended;
+    m_gamesModel->updateGame(index, gameRow(game));
+    recordGameUpdated(game.titleId);
     emit suspendRequested(game.titleId, game.pid);
     emit gameSuspended(game.titleId);
-    emit gamesChanged();
 }
 
 void RunningManager::resumeGame(const QString& titleId)
@@ -196,10 +463,12 @@ void RunningManager::resumeGame(const QString& titleId)
         return;
     }
 
+    ChangeTransaction transaction(this);
     game.state = GameState::Running;
+    m_gamesModel->updateGame(index, gameRow(game));
+    recordGameUpdated(game.titleId);
     emit resumeRequested(game.titleId, game.pid);
     emit gameResumed(game.titleId);
-    emit gamesChanged();
 }
 
 void RunningManager::forceQuit(const QString& titleId)
@@ -209,21 +478,260 @@ void RunningManager::forceQuit(const QString& titleId)
         return;
     }
 
-    const auto& game = m_games.at(index);
-    emit forceQuitRequested(game.titleId, game.pid);
+    ChangeTransaction transaction(this);
+    const QString id = m_games.at(index).titleId;
+    emit forceQuitRequested(id, m_games.at(index).pid);
     removeGameAt(index);
-    emit gameClosed(game.titleId);
-    emit gamesChanged();
+    emit gameClosed(id);
+}
+
+int RunningManager::historySize(const QString& titleId) const
+{
+    const MetricHistory* history = historyFor(titleId);
+    return history ? history->size() : 0;
+}
+
+double RunningManager::historyValue(const QString& titleId, const QString& metric, int age) const
+{
+    const MetricHistory* history = historyFor(titleId);
+    MetricField field = MetricField::CpuPercent;
+    if (!history || !metricFieldFromName(metric, &field)) {
+        return 0.0;
+    }
+    return history->valueAt(field, age);
+}
+
+QVariantMap RunningManager::historyStats(const QString& titleId, const QString& metric, int windowSamples) const
+{
+    const MetricHistory* history = historyFor(titleId);
+    MetricField field = MetricField::CpuPercent;
+    if (!history || !metricFieldFromName(metric, &field)) {
+        return {};
+    }
+
+    const MetricHistory::Stats stats = history->stats(field, windowSamples);
+    QVariantMap map;
+    map["count"] = stats.count;
+    map["min"] = stats.min;
+    map["max"] = stats.max;
+    map["mean"] = stats.mean;
+    map["stddev"] = stats.stddev;
+    return map;
+}
+
+const MetricHistory* RunningManager::historyFor(const QString& titleId) const
+{
+    int index = indexForId(titleId);
+    if (index < 0) {
+        return nullptr;
+    }
+    return m_games[index].history.get();
+}
+
+double RunningManager::metricQuantile(const QString& titleId, const QString& metric, double quantile, int windowSeconds) const
+{
+    const MetricDistribution* distribution = distributionFor(titleId);
+    MetricField field = MetricField::CpuPercent;
+    if (!distribution || !metricFieldFromName(metric, &field)) {
+        return 0.0;
+    }
+    return distribution->quantile(field, quantile, windowSeconds * 1000LL);
+}
+
+QVariantMap RunningManager::metricSummary(const QString& titleId, const QString& metric, int windowSeconds) const
+{
+    const MetricDistribution* distribution = distributionFor(titleId);
+    MetricField field = MetricField::CpuPercent;
+    if (!distribution || !metricFieldFromName(metric, &field)) {
+        return {};
+    }
+
+    const MetricDistribution::Summary summary = distribution->summary(field, windowSeconds * 1000LL);
+    QVariantMap map;
+    map["count"] = summary.count;
+    map["min"] = summary.min;
+    map["max"] = summary.max;
+    map["mean"] = summary.mean;
+    map["p1"] = summary.p1;
+    map["p50"] = summary.p50;
+    map["p95"] = summary.p95;
+    map["p99"] = summary.p99;
+    return map;
+}
+
+const MetricDistribution* RunningManager::distributionFor(const QString& titleId) const
+{
+    int index = indexForId(titleId);
+    if (index < 0) {
+        return nullptr;
+    }
+    return m_games[index].distribution.get();
+}
+
+QVariantMap RunningManager::schedulerState() const
+{
+    QVariantList groups;
+    for (int i = 0; i < METRIC_GROUP_COUNT; ++i) {
+        const auto group = static_cast<MetricGroup>(i);
+        const SamplingScheduler::GroupState& state = m_scheduler.groupState(group);
+        QVariantMap map;
+        map["name"] = metricGroupName(group);
+        map["intervalMs"] = state.intervalMs;
+        map["samples"] = state.samples;
+        map["missed"] = state.missed;
+        map["burst"] = (m_scheduler.burstGroups() & metricGroupBit(group)) != 0;
+        map["meanLatenessMs"] = state.samples > 0 ? state.totalLatenessNs / double(state.samples) / NS_PER_MS : 0.0;
+        map["maxLatenessMs"] = state.maxLatenessNs / double(NS_PER_MS);
+        groups.append(map);
+    }
+
+    const quint64 sampleCount = m_scheduler.sampleCount();
+    QVariantMap map;
+    map["baseIntervalMs"] = m_scheduler.baseIntervalMs();
+    map["lowPower"] = m_scheduler.lowPower();
+    map["groups"] = groups;
+    map["sampleCount"] = sampleCount;
+    map["meanSampleCostUs"] = sampleCount > 0 ? m_scheduler.totalSampleCostNs() / double(sampleCount) / 1000.0 : 0.0;
+    map["maxSampleCostUs"] = m_scheduler.maxSampleCostNs() / 1000.0;
+    return map;
+}
+
+int RunningManager::subscribe(const QStringList& metrics, const QStringList& titleIds, int maxAgeMs)
+{
+    Subscription subscription;
+    for (const QString& name : metrics) {
+        MetricField field = MetricField::CpuPercent;
+        if (!metricFieldFromName(name, &field)) {
+            return 0;
+        }
+        subscription.fields |= metricFieldBit(field);
+    }
+    subscription.titleIds = QSet<QString>(titleIds.cbegin(), titleIds.cend());
+    subscription.maxAgeMs = qMax(0, maxAgeMs);
+    return addSubscription(subscription);
+}
+
+int RunningManager::subscribeAll(const QStringList& titleIds, int maxAgeMs)
+{
+    Subscription subscription;
+    subscription.fields = ALL_METRIC_FIELDS;
+    subscription.titleIds = QSet<QString>(titleIds.cbegin(), titleIds.cend());
+    subscription.maxAgeMs = qMax(0, maxAgeMs);
+    return addSubscription(subscription);
+}
+
+int RunningManager::addSubscription(const Subscription& subscription)
+{
+    const int id = m_nextSubscriptionId++;
+    m_subscriptions.insert(id, subscription);
+    updateDemand();
+    return id;
+}
+
+void RunningManager::unsubscribe(int subscriptionId)
+{
+    if (m_subscriptions.remove(subscriptionId) > 0) {
+        updateDemand();
+    }
+}
+
+QStringList RunningManager::demandedMetrics() const
+{
+    QStringList names;
+    for (int i = 0; i < METRIC_FIELD_COUNT; ++i) {
+        const auto field = static_cast<MetricField>(i);
+        if (m_demandedFields & metricFieldBit(field)) {
+            names.append(metricFieldName(field));
+        }
+    }
+    return names;
+}
+
+MetricFieldMask RunningManager::demandedFields() const
+{
+    return m_demandedFields;
+}
+
+QVariantList RunningManager::alertRules() const
+{
+    QVariantList list;
+    for (int i = 0; i < ALERT_KIND_COUNT; ++i) {
+        const AlertRule& rule = m_alertEngine.rule(static_cast<AlertKind>(i));
+        QVariantMap map;
+        map["type"] = alertKindName(rule.kind);
+        map["metric"] = metricFieldName(rule.field);
+        map["below"] = rule.below;
+        map["enter"] = rule.enterThreshold;
+        map["exit"] = rule.exitThreshold;
+        map["critical"] = rule.criticalThreshold;
+        map["minDurationMs"] = rule.minDurationMs;
+        map["enabled"] = rule.enabled;
+        list.append(map);
+    }
+    return list;
+}
+
+bool RunningManager::setAlertRule(const QVariantMap& map)
+{
+    AlertKind kind = AlertKind::Temperature;
+    if (!alertKindFromName(map.value("type").toString(), &kind)) {
+        return false;
+    }
+
+    AlertRule rule = m_alertEngine.rule(kind);
+    if (map.contains("metric") && !metricFieldFromName(map.value("metric").toString(), &rule.field)) {
+        return false;
+    }
+    if (map.contains("below")) {
+        rule.below = map.value("below").toBool();
+    }
+    if (map.contains("enter")) {
+        rule.enterThreshold = map.value("enter").toDouble();
+    }
+    if (map.contains("exit")) {
+        rule.exitThreshold = map.value("exit").toDouble();
+    }
+    if (map.contains("critical")) {
+        rule.criticalThreshold = map.value("critical").toDouble();
+    }
+    if (map.contains("minDurationMs")) {
+        rule.minDurationMs = qMax<qint64>(0, map.value("minDurationMs").toLongLong());
+    }
+    if (map.contains("enabled")) {
+        rule.enabled = map.value("enabled").toBool();
+    }
+    setAlertRule(rule);
+    return true;
+}
+
+const AlertRule& RunningManager::alertRule(AlertKind kind) const
+{
+    return m_alertEngine.rule(kind);
+}
+
+void RunningManager::setAlertRule(const AlertRule& rule)
+{
+    m_alertEngine.setRule(rule);
+    updateDemand();
 }
 
 void RunningManager::setMetricsProvider(std::shared_ptr<ProcessMetricsProvider> provider)
 {
+    const bool watched = watchesProcesses();
     m_metricsProvider = provider;
-    if (m_metricsProvider && !m_updateTimer.isActive()) {
-        m_updateTimer.start();
-    } else if (!m_metricsProvider) {
-        m_updateTimer.stop();
+    if (watchesProcesses() != watched) {
+        for (const auto& game : std::as_const(m_games)) {
+            if (watched) {
+                m_exitWatcher->unwatch(game.pid);
+                m_pressureMonitor->unwatch(game.pid);
+            } else {
+                m_exitWatcher->watch(game.pid);
+                m_pressureMonitor->watch(game.pid);
+            }
+        }
     }
+    configureSampler();
+    scheduleNextSample();
 }
 
 void RunningManager::updateMetrics()
@@ -231,33 +739,275 @@ void RunningManager::updateMetrics()
     if (!m_metricsProvider) {
         return;
     }
+    // Skip the tick rather than queueing behind a sample that is still blocked
+    // on slow sysfs reads. Its snapshot re-arms the timer, and the groups that
+    // fell due meanwhile are taken then.
+    if (m_threadedSampling && m_samplePending) {
+        return;
+    }
+
+    const MetricGroupMask groups = m_scheduler.takeDueGroups(clockNs());
+    const MetricFieldMask fields = metricGroupFields(groups) & m_demandedFields;
+    // The fast tick doubles as the liveness check for games without a pidfd,
+    // so for them it runs even when none of its metrics are demanded.
+    if (fields != 0 || ((groups & metricGroupBit(MetricGroup::Fast)) && hasUnwatchedGame())) {
+        sampleFields(fields);
+    }
+    scheduleNextSample();
+}
+
+bool RunningManager::hasUnwatchedGame() const
+{
+    return std::any_of(m_games.cbegin(), m_games.cend(), [this](const RunningGame& game) {
+        return game.state != GameState::Suspended && !m_exitWatcher->isWatching(game.pid);
+    });
+}
+
+// Replayed PIDs are not processes on this machine, so watching them would
+// report unrelated exits and stalls, and an out-of-band sample would step the
+// replay ahead of the tick.
+bool RunningManager::watchesProcesses() const
+{
+    return m_metricsProvider && m_metricsProvider->readsLiveProcesses();
+}
+
+void RunningManager::sampleFields(MetricFieldMask fields)
+{
+    if (m_threadedSampling) {
+        requestThreadedSample(fields);
+        return;
+    }
+
+    QVector<QString> titleIds;
+    QVector<qint64> pids;
+    QVector<MetricFieldMask> pidFields;
+    collectSampleTargets(fields, titleIds, pids, pidFields);
+
+    applySnapshot(m_sampler->sample(++m_tick, titleIds, pids, pidFields));
+}
+
+void RunningManager::scheduleNextSample()
+{
+    if (!m_metricsProvider) {
+        m_updateTimer.stop();
+        return;
+    }
+
+    const qint64 delayNs = m_scheduler.nextDeadlineNs() - clockNs();
+    const qint64 delayMs = delayNs > 0 ? (delayNs + NS_PER_MS - 1) / NS_PER_MS : 0;
+    m_updateTimer.start(static_cast<int>(qMin<qint64>(delayMs, std::numeric_limits<int>::max())));
+}
+
+void RunningManager::updateLowPower()
+{
+    m_scheduler.setLowPower(!m_overlayVisible || m_onBattery, clockNs());
+    scheduleNextSample();
+}
+
+void RunningManager::updateBurstGroups()
+{
+    AlertMask active = 0;
+    for (const auto& game : std::as_const(m_games)) {
+        active |= game.alerts.active;
+    }
+    MetricGroupMask groups = 0;
+    for (int i = 0; i < ALERT_KIND_COUNT; ++i) {
+        const auto kind = static_cast<AlertKind>(i);
+        if (active & alertKindBit(kind)) {
+            groups |= metricGroupBit(metricGroupOf(m_alertEngine.rule(kind).field));
+        }
+    }
+    m_scheduler.setBurstGroups(groups, clockNs());
+}
+
+void RunningManager::updateDemand()
+{
+    // Alerts always get their metrics; anything else only while subscribed.
+    MetricFieldMask fields = m_alertEngine.fields();
+    for (RunningGame& game : m_games) {
+        game.demandedFields = fields;
+    }
+    MetricFieldMask everyGame = 0;
+    qint64 maxIntervalMs[METRIC_GROUP_COUNT] = {};
+    for (const Subscription& subscription : std::as_const(m_subscriptions)) {
+        if (subscription.titleIds.isEmpty()) {
+            everyGame |= subscription.fields;
+        } else {
+            bool tracked = false;
+            for (const QString& id : subscription.titleIds) {
+                const int index = indexForId(id);
+                if (index >= 0) {
+                    m_games[index].demandedFields |= subscription.fields;
+                    tracked = true;
+                }
+            }
+            if (!tracked) {
+                continue;
+            }
+        }
+
+        fields |= subscription.fields;
+        if (subscription.maxAgeMs <= 0) {
+            continue;
+        }
+        for (int i = 0; i < METRIC_GROUP_COUNT; ++i) {
+            if (!(metricGroupFields(metricGroupBit(static_cast<MetricGroup>(i))) & subscription.fields)) {
+                continue;
+            }
+            qint64& bound = maxIntervalMs[i];
+            bound = bound > 0 ? qMin(bound, subscription.maxAgeMs) : subscription.maxAgeMs;
+        }
+    }
+
+    for (RunningGame& game : m_games) {
+        game.demandedFields |= everyGame;
+    }
+    m_demandedFields = fields;
+    const qint64 now = clockNs();
+    for (int i = 0; i < METRIC_GROUP_COUNT; ++i) {
+        m_scheduler.setMaxIntervalMs(static_cast<MetricGroup>(i), maxIntervalMs[i], now);
+    }
+    scheduleNextSample();
+}
+
+qint64 RunningManager::clockNs() const
+{
+    return m_clock.nsecsElapsed();
+}
+
+void RunningManager::applySnapshot(const MetricsSnapshot& snapshot)
+{
+    if (snapshot.tick <= m_lastAppliedTick) {
+        return;
+    }
+    m_lastAppliedTick = snapshot.tick;
+    m_scheduler.recordSampleCost(snapshot.sampleDurationNs);
+    ChangeTransaction transaction(this);
+    m_changes.tick = snapshot.tick;
+    if (snapshot.onBattery != m_providerOnBattery) {
+        m_providerOnBattery = snapshot.onBattery;
+        setOnBattery(snapshot.onBattery);
+    }
 
     QVector<QString> toRemove;
-    bool anyGameUpdated = false;
+    m_updatedGames.clear();
 
-    for (auto& game : m_games) {
-        if (game.state == GameState::Suspended) {
+    const int count = qMin(qMin(snapshot.titleIds.size(), snapshot.pids.size()),
+                           qMin(snapshot.fields.size(), snapshot.metrics.size()));
+    for (int i = 0; i < count; ++i) {
+        const int index = indexForId(snapshot.titleIds[i]);
+        if (index < 0) {
+            continue;
+        }
+
+        auto& game = m_games[index];
+        const ProcessMetrics& metrics = snapshot.metrics[i];
+        // The game may have been suspended or re-registered with another PID
+        // while the sample was in flight. Invalid metrics carry no PID, so
+        // compare against the one that was requested.
+        if (game.state == GameState::Suspended || game.pid != snapshot.pids[i]) {
             continue;
         }
 
-        ProcessMetrics metrics = m_metricsProvider->metricsForPid(game.pid);
         if (!metrics.valid) {
+            m_recorder.recordSample(game.recorderSlot, metrics, snapshot.sampledAtMs);
             toRemove.append(game.titleId);
             continue;
         }
+        // A liveness tick samples no fields: the game is still running and
+        // nothing else changed.
+        if (snapshot.fields[i] == 0) {
+            continue;
+        }
 
-        game.metrics = metrics;
-        evaluateAlerts(game);
-        anyGameUpdated = true;
+        // Metrics that were not due or not subscribed keep their last values.
+        // History and recorder rows repeat them; the distribution counts
+        // fresh values only.
+        mergeMetricFields(game.metrics, metrics, snapshot.fields[i]);
+        m_recorder.recordSample(game.recorderSlot, game.metrics, snapshot.sampledAtMs);
+        game.history->append(game.metrics, snapshot.sampledAtMs);
+        game.distribution->append(game.metrics, snapshot.sampledAtMs, snapshot.fields[i]);
+        m_gamesModel->updateMetrics(index, game.metrics);
+        m_updatedGames.append(index);
+        recordMetricsUpdated(game.titleId);
     }
+    evaluateAlerts(m_updatedGames, snapshot.sampledAtMs);
 
     for (const auto& id : toRemove) {
         markGameExited(id);
     }
+    updateBurstGroups();
+}
 
-    if (anyGameUpdated || !toRemove.isEmpty()) {
-        emit gamesChanged();
+void RunningManager::collectSampleTargets(MetricFieldMask fields, QVector<QString>& titleIds, QVector<qint64>& pids,
+                                          QVector<MetricFieldMask>& pidFields) const
+{
+    titleIds.reserve(m_games.size());
+    pids.reserve(m_games.size());
+    pidFields.reserve(m_games.size());
+    for (const auto& game : m_games) {
+        if (game.state == GameState::Suspended) {
+            continue;
+        }
+        titleIds.append(game.titleId);
+        pids.append(game.pid);
+        pidFields.append(fields & game.demandedFields);
+    }
+}
+
+void RunningManager::requestThreadedSample(MetricFieldMask fields)
+{
+    if (!m_samplerWorker || m_samplePending) {
+        return;
+    }
+
+    QVector<QString> titleIds;
+    QVector<qint64> pids;
+    QVector<MetricFieldMask> pidFields;
+    collectSampleTargets(fields, titleIds, pids, pidFields);
+
+    m_samplePending = true;
+    const quint64 tick = ++m_tick;
+    MetricsSamplerWorker* worker = m_samplerWorker;
+    QMetaObject::invokeMethod(
+        worker,
+        [worker, tick, titleIds, pids, pidFields]() {
+            worker->requestSample(tick, titleIds, pids, pidFields);
+        },
+        Qt::QueuedConnection);
+}
+
+void RunningManager::startSamplerThread()
+{
+    if (m_samplerWorker) {
+        return;
+    }
+
+    m_samplerWorker = new MetricsSamplerWorker(m_sampler);
+    m_samplerWorker->moveToThread(&m_samplerThread);
+    connect(&m_samplerThread, &QThread::finished, m_samplerWorker, &QObject::deleteLater);
+    connect(m_samplerWorker, &MetricsSamplerWorker::snapshotReady, this, [this](const MetricsSnapshot& snapshot) {
+        m_samplePending = false;
+        applySnapshot(snapshot);
+        scheduleNextSample();
+    });
+
+    m_samplerThread.setObjectName(QStringLiteral("RunningManagerSampler"));
+    m_samplerThread.start(QThread::LowPriority);
+}
+
+void RunningManager::stopSamplerThread()
+{
+    if (!m_samplerWorker) {
+        return;
     }
+
+    m_samplerThread.quit();
+    m_samplerThread.wait();
+    m_samplerWorker = nullptr;
+    m_samplePending = false;
+    // Settings still queued for the worker were dropped with its event loop.
+    configureSampler();
 }
 
 QVariantMap RunningManager::serializeGame(const RunningGame& game) const
@@ -267,11 +1017,7 @@ QVariantMap RunningManager::serializeGame(const RunningGame& game) const
     map["displayName"] = game.displayName;
     map["pid"] = game.pid;
     map["supportsSuspend"] = game.supportsSuspend;
-    map["suspendUnsupportedReason"] = game.supportsSuspend
-        ? QString()
-        : (game.suspendUnsupportedReason.isEmpty()
-            ? tr("Suspend is not supported for this title.")
-            : game.suspendUnsupportedReason);
+    map["suspendUnsupportedReason"] = game.supportsSuspend ? QString() : suspendUnsupportedMessage(game);
     map["state"] = game.state == GameState::Running ? QStringLiteral("running") : QStringLiteral("suspended");
 
     QVariantMap metricsMap;
@@ -284,130 +1030,240 @@ QVariantMap RunningManager::serializeGame(const RunningGame& game) const
     metricsMap["gpuTemperatureC"] = game.metrics.gpuTemperatureC;
     metricsMap["powerWatts"] = game.metrics.powerWatts;
     metricsMap["fps"] = game.metrics.fps;
-    metricsMap["updatedAt"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    metricsMap["frameTimeMs"] = game.metrics.frameTimeMs;
+    metricsMap["frameTimeMaxMs"] = game.metrics.frameTimeMaxMs;
+    metricsMap["threadCpuPercent"] = game.metrics.threadCpuPercent;
+    metricsMap["hotThreads"] = serializeHotThreads(game.metrics);
+    metricsMap["gpuDevice"] = QString::fromLatin1(game.metrics.gpuDevice);
+    metricsMap["gpuBusyPercent"] = game.metrics.gpuBusyPercent;
+    metricsMap["gpuPowerWatts"] = game.metrics.gpuPowerWatts;
+    metricsMap["pssMb"] = game.metrics.pssMb;
+    metricsMap["pssPercent"] = game.metrics.pssPercent;
+    metricsMap["ussMb"] = game.metrics.ussMb;
+    metricsMap["swapMb"] = game.metrics.swapMb;
+    metricsMap["vramMb"] = game.metrics.vramMb;
+    metricsMap["gttMb"] = game.metrics.gttMb;
+    metricsMap["cpuPressure"] = game.metrics.cpuPressure;
+    metricsMap["memoryPressure"] = game.metrics.memoryPressure;
+    metricsMap["ioPressure"] = game.metrics.ioPressure;
+    metricsMap["cpuStallPercent"] = game.metrics.cpuStallPercent;
+    metricsMap["memoryStallPercent"] = game.metrics.memoryStallPercent;
+    metricsMap["ioStallPercent"] = game.metrics.ioStallPercent;
+    metricsMap["updatedAt"] = game.metrics.sampledAtMs > 0
+        ? QDateTime::fromMSecsSinceEpoch(game.metrics.sampledAtMs, Qt::UTC).toString(Qt::ISODate)
+        : QString();
     map["metrics"] = metricsMap;
 
     QVariantList alertList;
-    for (const auto& alert : game.activeAlerts) {
-        alertList.append(serializeAlert(alert));
+    for (int i = 0; i < ALERT_KIND_COUNT; ++i) {
+        const auto kind = static_cast<AlertKind>(i);
+        if (game.alerts.active & alertKindBit(kind)) {
+            alertList.append(serializeAlert(game.alertInfo[i]));
+        }
     }
     map["alerts"] = alertList;
 
     return map;
 }
 
-QVariantMap RunningManager::serializeAlert(const Alert& alert) const
+RunningGamesModel::GameRow RunningManager::gameRow(const RunningGame& game) const
+{
+    RunningGamesModel::GameRow row;
+    row.titleId = game.titleId;
+    row.displayName = game.displayName;
+    row.pid = game.pid;
+    row.supportsSuspend = game.supportsSuspend;
+    row.suspendUnsupportedReason = game.supportsSuspend ? QString() : suspendUnsupportedMessage(game);
+    row.suspended = game.state == GameState::Suspended;
+    row.metrics = game.metrics;
+    return row;
+}
+
+QString RunningManager::suspendUnsupportedMessage(const RunningGame& game) const
+{
+    return game.suspendUnsupportedReason.isEmpty()
+        ? tr("Suspend is not supported for this title.")
+        : game.suspendUnsupportedReason;
+}
+
+QVariantList RunningManager::serializeHotThreads(const ProcessMetrics& metrics)
+{
+    QVariantList threads;
+    for (int i = 0; i < metrics.hotThreadCount; ++i) {
+        const ThreadCpuUsage& usage = metrics.hotThreads[i];
+        QVariantMap thread;
+        thread["tid"] = usage.tid;
+        thread["name"] = QString::fromUtf8(usage.name);
+        thread["cpuPercent"] = usage.cpuPercent;
+        threads.append(thread);
+    }
+    return threads;
+}
+
+QVariantMap RunningManager::serializeAlert(const AlertInfo& alert)
 {
     QVariantMap map;
     map["type"] = alert.type;
     map["titleId"] = alert.titleId;
     map["message"] = alert.message;
-    map["severity"] = severityToString(alert.severity);
-    map["timestamp"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    map["severity"] = alert.severity;
+    map["value"] = alert.value;
+    map["timestamp"] = QDateTime::fromMSecsSinceEpoch(alert.raisedAtMs, Qt::UTC).toString(Qt::ISODate);
     return map;
 }
 
-void RunningManager::evaluateAlerts(RunningGame& game)
+QString RunningManager::alertMessage(const RunningGame& game, AlertKind kind, double value) const
 {
-    auto triggerAlert = [&](const QString& key, const QString& message, AlertSeverity severity) {
-        auto it = game.activeAlerts.find(key);
-        bool updated = false;
-        if (it == game.activeAlerts.end()) {
-            Alert alert;
-            alert.type = key;
-            alert.titleId = game.titleId;
-            alert.message = message;
-            alert.severity = severity;
-            game.activeAlerts.insert(key, alert);
-            emit alertRaised(game.titleId, serializeAlert(alert));
-            updated = true;
-        } else {
-            Alert& existing = it.value();
-            if (existing.message != message || existing.severity != severity) {
-                existing.message = message;
-                existing.severity = severity;
-                emit alertRaised(game.titleId, serializeAlert(existing));
-                updated = true;
-            }
-        }
-        if (updated) {
-            emit alertsChanged();
-        }
-    };
-
-    auto clearAlert = [&](const QString& key) {
-        if (game.activeAlerts.remove(key) > 0) {
-            emit alertCleared(game.titleId, key);
-            emit alertsChanged();
-        }
-    };
-
-    if (game.metrics.temperatureC >= TEMP_ALERT_THRESHOLD) {
-        const QString message = tr("%1 is overheating (%2°C)")
+    switch (kind) {
+    case AlertKind::Temperature:
+        return tr("%1 is overheating (%2°C)").arg(game.displayName).arg(value, 0, 'f', 1);
+    case AlertKind::GpuTemperature:
+        return tr("GPU temperature high for %1 (%2°C)").arg(game.displayName).arg(value, 0, 'f', 1);
+    case AlertKind::Cpu:
+        return tr("CPU usage high for %1 (%2%)").arg(game.displayName).arg(value, 0, 'f', 1);
+    case AlertKind::Gpu:
+        return tr("GPU usage high for %1 (%2%)").arg(game.displayName).arg(value, 0, 'f', 1);
+    case AlertKind::Memory:
+        return tr("Memory usage high for %1 (%2%)").arg(game.displayName).arg(value, 0, 'f', 1);
+    case AlertKind::Power:
+        return tr("Power draw unusually high for %1 (%2 W)").arg(game.displayName).arg(value, 0, 'f', 1);
+    case AlertKind::Fps:
+        return tr("FPS dropping on %1 (%2 FPS)").arg(game.displayName).arg(value, 0, 'f', 0);
+    case AlertKind::CpuThread:
+        return tr("Thread %1 of %2 saturates a CPU core (%3%)")
+            .arg(game.metrics.hotThreadCount > 0 ? QString::fromUtf8(game.metrics.hotThreads[0].name) : QString())
             .arg(game.displayName)
-            .arg(game.metrics.temperatureC, 0, 'f', 1);
-        triggerAlert(QStringLiteral("temperature"), message,
-                     game.metrics.temperatureC >= TEMP_ALERT_THRESHOLD + 5.0 ? AlertSeverity::Critical
-                                                                           : AlertSeverity::Warning);
-    } else {
-        clearAlert(QStringLiteral("temperature"));
+            .arg(value, 0, 'f', 0);
+    case AlertKind::Pss:
+        return tr("%1 holds %2% of system memory").arg(game.displayName).arg(value, 0, 'f', 1);
+    case AlertKind::Swap:
+        return tr("%1 is swapping (%2 MB swapped out)").arg(game.displayName).arg(value, 0, 'f', 0);
+    case AlertKind::MemoryStall:
+        return tr("%1 is stalled on memory %2% of the time").arg(game.displayName).arg(value, 0, 'f', 0);
+    case AlertKind::IoStall:
+        return tr("%1 is stalled on disk IO %2% of the time").arg(game.displayName).arg(value, 0, 'f', 0);
+    case AlertKind::Count:
+        break;
     }
+    return {};
+}
 
-    if (game.metrics.gpuTemperatureC >= GPU_TEMP_ALERT_THRESHOLD) {
-        const QString message = tr("GPU temperature high for %1 (%2°C)")
-            .arg(game.displayName)
-            .arg(game.metrics.gpuTemperatureC, 0, 'f', 1);
-        triggerAlert(QStringLiteral("gpuTemperature"), message,
-                     game.metrics.gpuTemperatureC >= GPU_TEMP_ALERT_THRESHOLD + 5.0 ? AlertSeverity::Critical
-                                                                                  : AlertSeverity::Warning);
-    } else {
-        clearAlert(QStringLiteral("gpuTemperature"));
+void RunningManager::evaluateAlerts(const QVector<int>& gameIndexes, qint64 nowMs)
+{
+    m_alertMetrics.clear();
+    m_alertStates.clear();
+    for (int index : gameIndexes) {
+        m_alertMetrics.append(&m_games[index].metrics);
+        m_alertStates.append(&m_games[index].alerts);
+    }
+    m_alertTransitions.clear();
+    m_alertEngine.evaluate(m_alertMetrics.constData(), m_alertStates.constData(), m_alertMetrics.size(), nowMs,
+                           m_alertTransitions);
+    if (m_alertTransitions.isEmpty()) {
+        return;
     }
 
-    if (game.metrics.cpuPercent >= CPU_ALERT_THRESHOLD) {
-        const QString message = tr("CPU usage high for %1 (%2%)")
-            .arg(game.displayName)
-            .arg(game.metrics.cpuPercent, 0, 'f', 1);
-        triggerAlert(QStringLiteral("cpu"), message, AlertSeverity::Warning);
-    } else {
-        clearAlert(QStringLiteral("cpu"));
+    // Resolve every game before emitting: slots may register or remove games.
+    QVector<QString> titleIds;
+    titleIds.reserve(m_alertTransitions.size());
+    for (const AlertTransition& transition : std::as_const(m_alertTransitions)) {
+        titleIds.append(m_games[gameIndexes[transition.game]].titleId);
     }
 
-    if (game.metrics.gpuPercent >= GPU_ALERT_THRESHOLD) {
-        const QString message = tr("GPU usage high for %1 (%2%)")
-            .arg(game.displayName)
-            .arg(game.metrics.gpuPercent, 0, 'f', 1);
-        triggerAlert(QStringLiteral("gpu"), message, AlertSeverity::Warning);
-    } else {
-        clearAlert(QStringLiteral("gpu"));
+    const QVector<AlertTransition> transitions = m_alertTransitions;
+    for (int i = 0; i < transitions.size(); ++i) {
+        const AlertTransition& transition = transitions[i];
+        const int index = indexForId(titleIds[i]);
+        if (index < 0) {
+            continue;
+        }
+
+        RunningGame& game = m_games[index];
+        m_recorder.recordAlert(game.recorderSlot, transition, nowMs);
+        const QString type = alertKindName(transition.kind);
+        AlertInfo& alert = game.alertInfo[static_cast<int>(transition.kind)];
+        if (transition.type == AlertTransition::Type::Cleared) {
+            alert = AlertInfo();
+            m_alertsModel->removeAlert(game.titleId, type);
+            QVariantMap cleared;
+            cleared["titleId"] = game.titleId;
+            cleared["type"] = type;
+            m_changes.cleared.append(cleared);
+            emit alertCleared(game.titleId, type);
+        } else {
+            const AlertSeverity severity = transition.critical ? AlertSeverity::Critical : AlertSeverity::Warning;
+            alert.type = type;
+            alert.titleId = game.titleId;
+            alert.message = alertMessage(game, transition.kind, transition.value);
+            alert.severity = severityToString(severity);
+            alert.value = transition.value;
+            alert.raisedAtMs = nowMs;
+            m_alertsModel->upsertAlert({type, game.titleId, alert.message, alert.severity});
+            m_changes.raised.append(QVariant::fromValue(alert));
+            emit alertRaised(game.titleId, alert);
+        }
     }
+}
 
-    if (game.metrics.ramPercent >= RAM_ALERT_THRESHOLD_PERCENT) {
-        const QString message = tr("Memory usage high for %1 (%2%)")
-            .arg(game.displayName)
-            .arg(game.metrics.ramPercent, 0, 'f', 1);
-        triggerAlert(QStringLiteral("memory"), message, AlertSeverity::Warning);
-    } else {
-        clearAlert(QStringLiteral("memory"));
+QStringList RunningManager::clearAlerts(RunningGame& game)
+{
+    QStringList types;
+    for (int kind = 0; kind < ALERT_KIND_COUNT; ++kind) {
+        if (!(game.alerts.active & alertKindBit(static_cast<AlertKind>(kind)))) {
+            continue;
+        }
+        const QString type = alertKindName(static_cast<AlertKind>(kind));
+        m_alertsModel->removeAlert(game.titleId, type);
+        QVariantMap cleared;
+        cleared["titleId"] = game.titleId;
+        cleared["type"] = type;
+        m_changes.cleared.append(cleared);
+        types.append(type);
+    }
+    game.alerts = AlertState();
+    for (AlertInfo& alert : game.alertInfo) {
+        alert = AlertInfo();
     }
+    return types;
+}
 
-    if (game.metrics.powerWatts >= POWER_ALERT_THRESHOLD) {
-        const QString message = tr("Power draw unusually high for %1 (%2 W)")
-            .arg(game.displayName)
-            .arg(game.metrics.powerWatts, 0, 'f', 1);
-        triggerAlert(QStringLiteral("power"), message, AlertSeverity::Warning);
-    } else {
-        clearAlert(QStringLiteral("power"));
+void RunningManager::releaseProviderPid(qint64 pid)
+{
+    // In threaded mode the provider may be busy with a slow read; hand the
+    // release to the sampler thread instead of waiting for its lock here.
+    if (m_samplerWorker) {
+        MetricsSamplerWorker* worker = m_samplerWorker;
+        QMetaObject::invokeMethod(
+            worker,
+            [worker, pid]() {
+                worker->releasePid(pid);
+            },
+            Qt::QueuedConnection);
+        return;
     }
 
-    if (game.metrics.fps > 0.0 && game.metrics.fps < FPS_FLOOR_ALERT) {
-        const QString message = tr("FPS dropping on %1 (%2 FPS)")
-            .arg(game.displayName)
-            .arg(game.metrics.fps, 0, 'f', 0);
-        triggerAlert(QStringLiteral("fps"), message, AlertSeverity::Warning);
-    } else {
-        clearAlert(QStringLiteral("fps"));
+    m_sampler->releasePid(pid);
+}
+
+void RunningManager::configureSampler()
+{
+    // Like releaseProviderPid(): in threaded mode the sampler thread applies
+    // the settings between samples, so the GUI thread never waits for its lock.
+    if (m_samplerWorker) {
+        MetricsSamplerWorker* worker = m_samplerWorker;
+        const std::shared_ptr<ProcessMetricsProvider> provider = m_metricsProvider;
+        const bool aggregate = m_aggregateProcessTree;
+        QMetaObject::invokeMethod(
+            worker,
+            [worker, provider, aggregate]() {
+                worker->configure(provider, aggregate);
+            },
+            Qt::QueuedConnection);
+        return;
     }
+
+    m_sampler->setMetricsProvider(m_metricsProvider);
+    m_sampler->setProcessTreeAggregation(m_aggregateProcessTree);
 }
 
 void RunningManager::removeGameAt(int index)
@@ -417,12 +1273,123 @@ void RunningManager::removeGameAt(int index)
     }
 
     const QString id = m_games[index].titleId;
+    recordGameRemoved(id, m_games[index].alerts.active != 0);
+    releaseProviderPid(m_games[index].pid);
+    m_exitWatcher->unwatch(m_games[index].pid);
+    m_pressureMonitor->unwatch(m_games[index].pid);
     m_games.removeAt(index);
     m_gameIndex.remove(id);
+    m_gamesModel->removeGame(index);
+    m_alertsModel->removeAlertsFor(id);
 
     for (int i = index; i < m_games.size(); ++i) {
         m_gameIndex[m_games[i].titleId] = i;
     }
+    updateDemand();
+}
+
+bool RunningManager::ChangeSet::isEmpty() const
+{
+    return added.isEmpty() && removed.isEmpty() && updated.isEmpty() && raised.isEmpty() && cleared.isEmpty()
+        && !alertsRemoved && !batteryChanged;
+}
+
+RunningManager::ChangeTransaction::ChangeTransaction(RunningManager* manager)
+    : m_manager(manager)
+{
+    ++m_manager->m_transactionDepth;
+}
+
+RunningManager::ChangeTransaction::~ChangeTransaction()
+{
+    if (--m_manager->m_transactionDepth == 0) {
+        m_manager->commitChanges();
+    }
+}
+
+void RunningManager::recordGameAdded(const QString& titleId)
+{
+    m_changes.added.append(titleId);
+}
+
+void RunningManager::recordGameRemoved(const QString& titleId, bool hadAlerts)
+{
+    m_changes.updated.removeAll(titleId);
+    // A game that came and went within one transaction was never visible.
+    if (m_changes.added.removeAll(titleId) == 0) {
+        m_changes.removed.append(titleId);
+    }
+    m_changes.alertsRemoved = m_changes.alertsRemoved || hadAlerts;
+}
+
+void RunningManager::recordGameUpdated(const QString& titleId)
+{
+    recordMetricsUpdated(titleId);
+    m_changes.gameStateChanged = true;
+}
+
+void RunningManager::recordMetricsUpdated(const QString& titleId)
+{
+    if (!m_changes.added.contains(titleId) && !m_changes.updated.contains(titleId)) {
+        m_changes.updated.append(titleId);
+    }
+}
+
+void RunningManager::commitChanges()
+{
+    if (m_changes.isEmpty()) {
+        m_changes = ChangeSet();
+        return;
+    }
+
+    // Slots may start transactions of their own.
+    const ChangeSet changes = std::exchange(m_changes, ChangeSet());
+    const bool alertsTouched = !changes.raised.isEmpty() || !changes.cleared.isEmpty() || changes.alertsRemoved;
+    // Fresh metrics alone do not touch the games list: the games model
+    // carries them, and a sampling tick is announced by changesCommitted().
+    const bool gamesTouched = !changes.added.isEmpty() || !changes.removed.isEmpty() || changes.gameStateChanged;
+
+    if (m_exporter.isListening()) {
+        publishExport();
+    }
+
+    QVariantMap map;
+    if (changes.tick >= 0) {
+        map["tick"] = changes.tick;
+    }
+    map["added"] = changes.added;
+    map["removed"] = changes.removed;
+    map["updated"] = changes.updated;
+    map["raised"] = changes.raised;
+    map["cleared"] = changes.cleared;
+    if (changes.batteryChanged) {
+        map["onBattery"] = m_onBattery;
+    }
+
+    if (changes.batteryChanged) {
+        emit onBatteryChanged();
+    }
+    if (gamesTouched) {
+        emit gamesChanged();
+    }
+    if (alertsTouched) {
+        emit alertsChanged();
+    }
+    emit changesCommitted(map);
+}
+
+void RunningManager::publishExport()
+{
+    m_exportGames.clear();
+    for (const auto& game : std::as_const(m_games)) {
+        ExportedGame exported;
+        exported.titleLabel = &game.exportLabel;
+        exported.metrics = &game.metrics;
+        exported.activeAlerts = game.alerts.active;
+        exported.criticalAlerts = game.alerts.critical;
+        m_exportGames.append(exported);
+    }
+    m_exporter.publish(m_exportGames);
 }
 
 int RunningManager::indexForId(const QString& titleId) const
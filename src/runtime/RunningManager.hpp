@@ -1,9 +1,24 @@
 #pragma once
 
+#include "ActiveAlertsModel.hpp"
+#include "AlertRules.hpp"
+#include "FlightRecorder.hpp"
+#include "MetricDistribution.hpp"
+#include "MetricHistory.hpp"
+#include "MetricsExporter.hpp"
+#include "MetricsSampler.hpp"
+#include "PressureMonitor.hpp"
+#include "ProcessExitWatcher.hpp"
 #include "ProcessMetricsProvider.hpp"
+#include "RunningGamesModel.hpp"
+#include "SamplingScheduler.hpp"
 
+#include <QElapsedTimer>
 #include <QHash>
+#include <QSet>
+#include <QStringList>
 #include <QObject>
+#include <QThread>
 #include <QTimer>
 #include <QVariantList>
 #include <QVariantMap>
@@ -16,9 +31,28 @@ class RunningManager : public QObject {
     Q_OBJECT
     Q_PROPERTY(QVariantList games READ games NOTIFY gamesChanged)
     Q_PROPERTY(QVariantList alerts READ alerts NOTIFY alertsChanged)
+    Q_PROPERTY(Runtime::RunningGamesModel* gamesModel READ gamesModel CONSTANT)
+    Q_PROPERTY(Runtime::ActiveAlertsModel* alertsModel READ alertsModel CONSTANT)
     Q_PROPERTY(int updateIntervalMs READ updateIntervalMs WRITE setUpdateIntervalMs NOTIFY updateIntervalMsChanged)
+    Q_PROPERTY(bool threadedSampling READ threadedSampling WRITE setThreadedSampling NOTIFY threadedSamplingChanged)
+    Q_PROPERTY(bool aggregateProcessTree READ aggregateProcessTree WRITE setAggregateProcessTree NOTIFY aggregateProcessTreeChanged)
+    Q_PROPERTY(int historyCapacity READ historyCapacity WRITE setHistoryCapacity NOTIFY historyCapacityChanged)
+    Q_PROPERTY(bool overlayVisible READ overlayVisible WRITE setOverlayVisible NOTIFY overlayVisibleChanged)
+    Q_PROPERTY(bool onBattery READ onBattery WRITE setOnBattery NOTIFY onBatteryChanged)
+    Q_PROPERTY(bool recording READ recording NOTIFY recordingChanged)
+    Q_PROPERTY(int exporterPort READ exporterPort NOTIFY exporterPortChanged)
 
 public:
+    enum class GameState {
+        Running,
+        Suspended
+    };
+
+    enum class AlertSeverity {
+        Warning,
+        Critical
+    };
+
     explicit RunningManager(QObject* parent = nullptr);
     explicit RunningManager(std::shared_ptr<ProcessMetricsProvider> provider, QObject* parent = nullptr);
     ~RunningManager() override;
@@ -26,9 +60,48 @@ public:
     QVariantList games() const;
     QVariantList alerts() const;
 
+    RunningGamesModel* gamesModel() const;
+    ActiveAlertsModel* alertsModel() const;
+
     int updateIntervalMs() const;
     void setUpdateIntervalMs(int interval);
 
+    bool threadedSampling() const;
+    void setThreadedSampling(bool enabled);
+
+    // Sum CPU and memory over each game's whole process tree.
+    bool aggregateProcessTree() const;
+    void setAggregateProcessTree(bool enabled);
+
+    // Samples kept per game. Applies to games registered after the change.
+    int historyCapacity() const;
+    void setHistoryCapacity(int capacity);
+
+    // Sampling drops to low-power rates while the overlay is hidden or the
+    // machine runs on battery. Groups with an active alert keep a burst rate.
+    // onBattery follows the provider whenever its power source changes; a
+    // value set in between holds until the next change.
+    bool overlayVisible() const;
+    void setOverlayVisible(bool visible);
+    bool onBattery() const;
+    void setOnBattery(bool onBattery);
+
+    // Appends every applied sample and alert transition to a FlightRecorder
+    // file at path, which survives a crash of this process. Pass a new path
+    // per session; readFlightRecording() reads it back.
+    Q_INVOKABLE bool startRecording(const QString& path);
+    Q_INVOKABLE void stopRecording();
+    bool recording() const;
+
+    // Serves every game's metrics and alert states at /metrics in the
+    // OpenMetrics text format, labelled by titleId. The document is rendered
+    // once per tick; scrapes are answered on a thread of their own. Port 0
+    // picks a free port, see exporterPort(), which is 0 while stopped. Every
+    // metric is subscribed while the exporter runs.
+    Q_INVOKABLE bool startExporter(int port, const QString& address = QStringLiteral("127.0.0.1"));
+    Q_INVOKABLE void stopExporter();
+    int exporterPort() const;
+
     Q_INVOKABLE void registerGame(const QString& titleId,
                                   const QString& displayName,
                                   qint64 pid,
@@ -36,50 +109,124 @@ public:
                                   const QString& suspendUnsupportedReason = {});
     Q_INVOKABLE void markGameExited(const QString& titleId);
     Q_INVOKABLE void refreshNow();
-    Q_INVOKABLE QVariantMap metricsFor(const QString& titleId) const;
+    Q_INVOKABLE Runtime::ProcessMetrics metricsFor(const QString& titleId) const;
+    // The game's busiest threads, hottest first, as {tid, name, cpuPercent}
+    // maps with cpuPercent in percent of one core.
+    Q_INVOKABLE QVariantList hotThreads(const QString& titleId) const;
     Q_INVOKABLE void focusGame(const QString& titleId);
     Q_INVOKABLE void suspendGame(const QString& titleId);
     Q_INVOKABLE void resumeGame(const QString& titleId);
     Q_INVOKABLE void forceQuit(const QString& titleId);
 
+    Q_INVOKABLE int historySize(const QString& titleId) const;
+    Q_INVOKABLE double historyValue(const QString& titleId, const QString& metric, int age) const;
+    Q_INVOKABLE QVariantMap historyStats(const QString& titleId, const QString& metric, int windowSamples = 0) const;
+    const MetricHistory* historyFor(const QString& titleId) const;
+
+    // Streaming quantiles over the whole session (windowSeconds <= 0) or the
+    // last windowSeconds, up to MetricDistribution::MAX_WINDOW_MS. The 1% low
+    // FPS is metricQuantile(titleId, "fps", 0.01, window).
+    Q_INVOKABLE double metricQuantile(const QString& titleId, const QString& metric, double quantile, int windowSeconds = 0) const;
+    Q_INVOKABLE QVariantMap metricSummary(const QString& titleId, const QString& metric, int windowSeconds = 0) const;
+    const MetricDistribution* distributionFor(const QString& titleId) const;
+
+    // Per-group intervals, lateness and provider cost of the sampling loop.
+    Q_INVOKABLE QVariantMap schedulerState() const;
+
+    // Declares that a consumer needs the named metrics ("cpuPercent", ...)
+    // for the given games (every game when empty), refreshed at least every
+    // maxAgeMs (0 keeps the group's own rate). Each game is read for the
+    // metrics its alerts need plus those of the subscriptions covering it;
+    // without subscriptions only alerts are served. Returns an id for
+    // unsubscribe(), or 0 if a metric name is unknown.
+    Q_INVOKABLE int subscribe(const QStringList& metrics, const QStringList& titleIds = {}, int maxAgeMs = 0);
+    // Like subscribe() with every metric, for consumers that show or export
+    // all of them.
+    Q_INVOKABLE int subscribeAll(const QStringList& titleIds = {}, int maxAgeMs = 0);
+    Q_INVOKABLE void unsubscribe(int subscriptionId);
+    Q_INVOKABLE QStringList demandedMetrics() const;
+    MetricFieldMask demandedFields() const;
+
+    // The alert rule table. A rule map has the keys type, metric, below,
+    // enter, exit, critical (NaN for none), minDurationMs and enabled;
+    // setAlertRule() only changes the keys present. Returns false for an
+    // unknown type or metric.
+    Q_INVOKABLE QVariantList alertRules() const;
+    Q_INVOKABLE bool setAlertRule(const QVariantMap& rule);
+    const AlertRule& alertRule(AlertKind kind) const;
+    void setAlertRule(const AlertRule& rule);
+
     void setMetricsProvider(std::shared_ptr<ProcessMetricsProvider> provider);
 
 signals:
     void gamesChanged();
     void alertsChanged();
     void updateIntervalMsChanged();
+    void threadedSamplingChanged();
+    void aggregateProcessTreeChanged();
+    void historyCapacityChanged();
+    void overlayVisibleChanged();
+    void onBatteryChanged();
+    void recordingChanged();
+    void exporterPortChanged();
 
     void focusRequested(const QString& titleId, qint64 pid);
     void suspendRequested(const QString& titleId, qint64 pid);
     void resumeRequested(const QString& titleId, qint64 pid);
     void forceQuitRequested(const QString& titleId, qint64 pid);
 
-    void alertRaised(const QString& titleId, const QVariantMap& alert);
+    void alertRaised(const QString& titleId, const Runtime::AlertInfo& alert);
     void alertCleared(const QString& titleId, const QString& type);
 
     void gameSuspended(const QString& titleId);
     void gameResumed(const QString& titleId);
     void gameClosed(const QString& titleId);
 
+    // Emitted once per transaction (a sampling tick, a registration, an
+    // exit, ...) after onBatteryChanged()/gamesChanged()/alertsChanged(), with
+    // what changed: "added", "removed" and "updated" title ids, "raised"
+    // AlertInfos and "cleared" {titleId, type} maps. Alerts of removed games
+    // are implied. Sampling ticks also carry the "tick" number, and a power
+    // source change the new "onBattery" value. A tick that only refreshes
+    // metrics emits this signal alone.
+    void changesCommitted(const QVariantMap& changes);
+
 private slots:
     void updateMetrics();
+    void onProcessExited(qint64 pid);
+    void onPressureStall(qint64 pid, Runtime::PressureResource resource);
 
 private:
-    enum class GameState {
-        Running,
-        Suspended
+    struct ChangeSet {
+        QStringList added;
+        QStringList removed;
+        QStringList updated;
+        QVariantList raised;
+        QVariantList cleared;
+        bool alertsRemoved = false;
+        // An update other than fresh metrics, e.g. a state change.
+        bool gameStateChanged = false;
+        bool batteryChanged = false;
+        qint64 tick = -1;
+
+        bool isEmpty() const;
     };
 
-    enum class AlertSeverity {
-        Warning,
-        Critical
+    // Collects the changes made while it is alive and publishes them as one
+    // notification when the outermost transaction ends.
+    class ChangeTransaction {
+    public:
+        explicit ChangeTransaction(RunningManager* manager);
+        ~ChangeTransaction();
+
+    private:
+        RunningManager* m_manager;
     };
 
-    struct Alert {
-        QString type;
-        QString titleId;
-        QString message;
-        AlertSeverity severity = AlertSeverity::Warning;
+    struct Subscription {
+        MetricFieldMask fields = 0;
+        QSet<QString> titleIds;
+        qint64 maxAgeMs = 0;
     };
 
     struct RunningGame {
@@ -90,20 +237,90 @@ private:
         QString suspendUnsupportedReason;
         GameState state = GameState::Running;
         ProcessMetrics metrics;
-        QHash<QString, Alert> activeAlerts;
+        std::shared_ptr<MetricHistory> history;
+        std::shared_ptr<MetricDistribution> distribution;
+        AlertState alerts;
+        // Filled in when an alert is raised or changes severity.
+        AlertInfo alertInfo[ALERT_KIND_COUNT];
+        int recorderSlot = -1;
+        QByteArray exportLabel;
+        // Metrics read for this game: its alerts' plus its subscriptions'.
+        MetricFieldMask demandedFields = 0;
     };
 
     QVariantMap serializeGame(const RunningGame& game) const;
-    QVariantMap serializeAlert(const Alert& alert) const;
-    void evaluateAlerts(RunningGame& game);
+    static QVariantList serializeHotThreads(const ProcessMetrics& metrics);
+    static QVariantMap serializeAlert(const AlertInfo& alert);
+    QString alertMessage(const RunningGame& game, AlertKind kind, double value) const;
+    RunningGamesModel::GameRow gameRow(const RunningGame& game) const;
+    QString suspendUnsupportedMessage(const RunningGame& game) const;
+    void evaluateAlerts(const QVector<int>& gameIndexes, qint64 nowMs);
+    void applySnapshot(const MetricsSnapshot& snapshot);
+    void collectSampleTargets(MetricFieldMask fields, QVector<QString>& titleIds, QVector<qint64>& pids,
+                              QVector<MetricFieldMask>& pidFields) const;
+    bool watchesProcesses() const;
+    bool hasUnwatchedGame() const;
+    void sampleFields(MetricFieldMask fields);
+    void requestThreadedSample(MetricFieldMask fields);
+    void scheduleNextSample();
+    void updateLowPower();
+    void updateBurstGroups();
+    int addSubscription(const Subscription& subscription);
+    void updateDemand();
+    void recordGameAdded(const QString& titleId);
+    void recordGameRemoved(const QString& titleId, bool hadAlerts);
+    void recordGameUpdated(const QString& titleId);
+    void recordMetricsUpdated(const QString& titleId);
+    void commitChanges();
+    void publishExport();
+    qint64 clockNs() const;
+    void startSamplerThread();
+    void stopSamplerThread();
+    void releaseProviderPid(qint64 pid);
+    // Drops the game's alerts, e.g. when its PID changes, records the clears
+    // and returns the types cleared.
+    QStringList clearAlerts(RunningGame& game);
+    void configureSampler();
     void removeGameAt(int index);
     int indexForId(const QString& titleId) const;
 
     std::shared_ptr<ProcessMetricsProvider> m_metricsProvider;
+    std::shared_ptr<MetricsSampler> m_sampler;
+    QThread m_samplerThread;
+    MetricsSamplerWorker* m_samplerWorker = nullptr;
     QTimer m_updateTimer;
+    QElapsedTimer m_clock;
+    SamplingScheduler m_scheduler;
     QVector<RunningGame> m_games;
     QHash<QString, int> m_gameIndex;
+    AlertEngine m_alertEngine;
+    FlightRecorder m_recorder;
+    MetricsExporter m_exporter;
+    QVector<ExportedGame> m_exportGames;
+    QVector<int> m_updatedGames;
+    QVector<const ProcessMetrics*> m_alertMetrics;
+    QVector<AlertState*> m_alertStates;
+    QVector<AlertTransition> m_alertTransitions;
+    ChangeSet m_changes;
+    int m_transactionDepth = 0;
+    QHash<int, Subscription> m_subscriptions;
+    MetricFieldMask m_demandedFields = 0;
+    int m_nextSubscriptionId = 1;
+    int m_exporterSubscription = 0;
+    RunningGamesModel* m_gamesModel = nullptr;
+    ActiveAlertsModel* m_alertsModel = nullptr;
+    ProcessExitWatcher* m_exitWatcher = nullptr;
+    PressureMonitor* m_pressureMonitor = nullptr;
     int m_updateIntervalMs = 1000;
+    int m_historyCapacity = 300;
+    quint64 m_tick = 0;
+    quint64 m_lastAppliedTick = 0;
+    bool m_threadedSampling = false;
+    bool m_aggregateProcessTree = false;
+    bool m_samplePending = false;
+    bool m_overlayVisible = true;
+    bool m_onBattery = false;
+    bool m_providerOnBattery = false;
 };
 
 } // namespace Runtime
@@ -0,0 +1,189 @@
+#include "SamplingScheduler.hpp"
+
+#include <limits>
+
+namespace Runtime {
+
+namespace {
+constexpr qint64 NS_PER_MS = 1'000'000;
+constexpr int GROUP_MULTIPLIERS[METRIC_GROUP_COUNT] = {1, 2, 5};
+} // namespace
+
+SamplingScheduler::SamplingScheduler(qint64 baseIntervalMs)
+    : m_baseIntervalMs(qMax<qint64>(1, baseIntervalMs))
+{
+    for (int i = 0; i < METRIC_GROUP_COUNT; ++i) {
+        m_groups[i].intervalMs = effectiveIntervalMs(static_cast<MetricGroup>(i));
+    }
+}
+
+qint64 SamplingScheduler::baseIntervalMs() const
+{
+    return m_baseIntervalMs;
+}
+
+void SamplingScheduler::setBaseIntervalMs(qint64 intervalMs, qint64 nowNs)
+{
+    m_baseIntervalMs = qMax<qint64>(1, intervalMs);
+    updateIntervals(nowNs);
+}
+
+bool SamplingScheduler::lowPower() const
+{
+    return m_lowPower;
+}
+
+void SamplingScheduler::setLowPower(bool enabled, qint64 nowNs)
+{
+    if (m_lowPower == enabled) {
+        return;
+    }
+    m_lowPower = enabled;
+    updateIntervals(nowNs);
+}
+
+MetricGroupMask SamplingScheduler::burstGroups() const
+{
+    return m_burstGroups;
+}
+
+void SamplingScheduler::setBurstGroups(MetricGroupMask groups, qint64 nowNs)
+{
+    groups &= ALL_METRIC_GROUPS;
+    if (m_burstGroups == groups) {
+        return;
+    }
+    m_burstGroups = groups;
+    updateIntervals(nowNs);
+}
+
+qint64 SamplingScheduler::maxIntervalMs(MetricGroup group) const
+{
+    return m_maxIntervalMs[static_cast<int>(group)];
+}
+
+void SamplingScheduler::setMaxIntervalMs(MetricGroup group, qint64 intervalMs, qint64 nowNs)
+{
+    intervalMs = intervalMs > 0 ? qMax(MIN_BURST_INTERVAL_MS, intervalMs) : 0;
+    qint64& current = m_maxIntervalMs[static_cast<int>(group)];
+    if (current == intervalMs) {
+        return;
+    }
+    current = intervalMs;
+    updateIntervals(nowNs);
+}
+
+void SamplingScheduler::start(qint64 nowNs)
+{
+    for (GroupState& group : m_groups) {
+        group.nextDueNs = nowNs + group.intervalMs * NS_PER_MS;
+    }
+}
+
+MetricGroupMask SamplingScheduler::takeDueGroups(qint64 nowNs)
+{
+    MetricGroupMask due = 0;
+    for (int i = 0; i < METRIC_GROUP_COUNT; ++i) {
+        GroupState& group = m_groups[i];
+        if (group.nextDueNs > nowNs) {
+            continue;
+        }
+
+        due |= metricGroupBit(static_cast<MetricGroup>(i));
+        const qint64 lateness = nowNs - group.nextDueNs;
+        ++group.samples;
+        group.totalLatenessNs += lateness;
+        group.maxLatenessNs = qMax(group.maxLatenessNs, lateness);
+        group.lastSampleNs = nowNs;
+
+        const qint64 intervalNs = group.intervalMs * NS_PER_MS;
+        group.nextDueNs += intervalNs;
+        if (group.nextDueNs <= nowNs) {
+            // More than a whole interval late (e.g. the machine was suspended):
+            // restart from now instead of firing a catch-up burst.
+            ++group.missed;
+            group.nextDueNs = nowNs + intervalNs;
+        }
+    }
+    return due;
+}
+
+void SamplingScheduler::markAllSampled(qint64 nowNs)
+{
+    for (GroupState& group : m_groups) {
+        ++group.samples;
+        group.lastSampleNs = nowNs;
+        group.nextDueNs = nowNs + group.intervalMs * NS_PER_MS;
+    }
+}
+
+qint64 SamplingScheduler::nextDeadlineNs() const
+{
+    qint64 deadline = std::numeric_limits<qint64>::max();
+    for (const GroupState& group : m_groups) {
+        deadline = qMin(deadline, group.nextDueNs);
+    }
+    return deadline;
+}
+
+const SamplingScheduler::GroupState& SamplingScheduler::groupState(MetricGroup group) const
+{
+    return m_groups[static_cast<int>(group)];
+}
+
+void SamplingScheduler::recordSampleCost(qint64 durationNs)
+{
+    ++m_sampleCount;
+    m_totalSampleCostNs += durationNs;
+    m_maxSampleCostNs = qMax(m_maxSampleCostNs, durationNs);
+}
+
+quint64 SamplingScheduler::sampleCount() const
+{
+    return m_sampleCount;
+}
+
+qint64 SamplingScheduler::totalSampleCostNs() const
+{
+    return m_totalSampleCostNs;
+}
+
+qint64 SamplingScheduler::maxSampleCostNs() const
+{
+    return m_maxSampleCostNs;
+}
+
+qint64 SamplingScheduler::effectiveIntervalMs(MetricGroup group) const
+{
+    const int index = static_cast<int>(group);
+    const qint64 normal = m_baseIntervalMs * GROUP_MULTIPLIERS[index];
+    qint64 interval = m_lowPower ? normal * LOW_POWER_FACTOR : normal;
+    if (m_maxIntervalMs[index] > 0) {
+        interval = qMin(interval, m_maxIntervalMs[index]);
+    }
+    if (m_burstGroups & metricGroupBit(group)) {
+        // An alert is active: watch closely even when the overlay is hidden.
+        interval = qMin(interval, qMin(normal, qMax(MIN_BURST_INTERVAL_MS, m_baseIntervalMs / BURST_DIVISOR)));
+    }
+    return interval;
+}
+
+void SamplingScheduler::updateIntervals(qint64 nowNs)
+{
+    for (int i = 0; i < METRIC_GROUP_COUNT; ++i) {
+        GroupState& group = m_groups[i];
+        const qint64 interval = effectiveIntervalMs(static_cast<MetricGroup>(i));
+        if (interval == group.intervalMs) {
+            continue;
+        }
+        group.intervalMs = interval;
+        if (group.lastSampleNs < 0) {
+            continue;
+        }
+        // Re-anchor on the last sample so that a rate change takes effect
+        // immediately without sampling twice in a row.
+        group.nextDueNs = qMax(nowNs, group.lastSampleNs + interval * NS_PER_MS);
+    }
+}
+
+} // namespace Runtime
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "ProcessMetricsProvider.hpp"
+
+#include <QtGlobal>
+
+namespace Runtime {
+
+// Decides which metric groups are due on a monotonic clock. Each group runs
+// at a multiple of the base interval (Fast x1, Medium x2, Slow x5), stretched
+// by LOW_POWER_FACTOR in low-power mode and shortened to a burst rate for
+// groups with an active alert, and capped by the freshness subscribers ask
+// for. Deadlines advance by whole intervals from the
+// previous deadline rather than from the wake-up time, so timer latency does
+// not accumulate; a group that falls a full interval behind is resynchronised
+// and counted as missed. Times are nanoseconds on the caller's clock.
+class SamplingScheduler {
+public:
+    static constexpr int LOW_POWER_FACTOR = 4;
+    static constexpr int BURST_DIVISOR = 4;
+    static constexpr qint64 MIN_BURST_INTERVAL_MS = 250;
+
+    struct GroupState {
+        qint64 intervalMs = 0;
+        qint64 nextDueNs = 0;
+        qint64 lastSampleNs = -1;
+        quint64 samples = 0;
+        quint64 missed = 0;
+        qint64 totalLatenessNs = 0;
+        qint64 maxLatenessNs = 0;
+    };
+
+    explicit SamplingScheduler(qint64 baseIntervalMs = 1000);
+
+    qint64 baseIntervalMs() const;
+    void setBaseIntervalMs(qint64 intervalMs, qint64 nowNs);
+
+    bool lowPower() const;
+    void setLowPower(bool enabled, qint64 nowNs);
+
+    MetricGroupMask burstGroups() const;
+    void setBurstGroups(MetricGroupMask groups, qint64 nowNs);
+
+    // Upper bound on a group's interval, or 0 for none. Bounds below
+    // MIN_BURST_INTERVAL_MS are raised to it.
+    qint64 maxIntervalMs(MetricGroup group) const;
+    void setMaxIntervalMs(MetricGroup group, qint64 intervalMs, qint64 nowNs);
+
+    // Starts every group's first interval at nowNs.
+    void start(qint64 nowNs);
+
+    // Returns the groups due at nowNs and advances their deadlines.
+    MetricGroupMask takeDueGroups(qint64 nowNs);
+
+    // Records an out-of-band sample of every group (refreshNow()) and
+    // restarts their intervals from nowNs.
+    void markAllSampled(qint64 nowNs);
+
+    qint64 nextDeadlineNs() const;
+    const GroupState& groupState(MetricGroup group) const;
+
+    // Provider time spent per sample, for overhead reporting.
+    void recordSampleCost(qint64 durationNs);
+    quint64 sampleCount() const;
+    qint64 totalSampleCostNs() const;
+    qint64 maxSampleCostNs() const;
+
+private:
+    qint64 effectiveIntervalMs(MetricGroup group) const;
+    void updateIntervals(qint64 nowNs);
+
+    qint64 m_baseIntervalMs;
+    bool m_lowPower = false;
+    MetricGroupMask m_burstGroups = 0;
+    qint64 m_maxIntervalMs[METRIC_GROUP_COUNT] = {};
+    GroupState m_groups[METRIC_GROUP_COUNT];
+    quint64 m_sampleCount = 0;
+    qint64 m_totalSampleCostNs = 0;
+    qint64 m_maxSampleCostNs = 0;
+};
+
+} // namespace Runtime
@@ -0,0 +1,439 @@
+#include "SensorDiscovery.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+#include <algorithm>
+#include <cstring>
+
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace Runtime {
+
+namespace {
+const QStringList CPU_HWMON_NAMES = {
+    QStringLiteral("k10temp"),
+    QStringLiteral("zenpower"),
+    QStringLiteral("coretemp"),
+    QStringLiteral("cpu_thermal")
+};
+
+const QStringList CPU_TEMP_LABELS = {
+    QStringLiteral("Tctl"),
+    QStringLiteral("Tdie"),
+    QStringLiteral("Package id 0")
+};
+
+const QStringList CPU_THERMAL_ZONE_TYPES = {
+    QStringLiteral("x86_pkg_temp"),
+    QStringLiteral("cpu-thermal"),
+    QStringLiteral("cpu_thermal"),
+    QStringLiteral("soc_thermal"),
+    QStringLiteral("acpitz")
+};
+
+const QStringList GPU_HWMON_NAMES = {
+    QStringLiteral("amdgpu"),
+    QStringLiteral("nouveau"),
+    QStringLiteral("i915"),
+    QStringLiteral("xe")
+};
+
+const char* const SENSOR_SUBSYSTEMS[] = {
+    "SUBSYSTEM=hwmon",
+    "SUBSYSTEM=drm",
+    "SUBSYSTEM=thermal",
+    "SUBSYSTEM=power_supply"
+};
+
+QByteArray readAttribute(const QString& path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return {};
+    }
+    return file.readAll().trimmed();
+}
+
+QByteArray encodePath(const QString& path)
+{
+    return QFile::encodeName(path);
+}
+
+bool hasNumericSuffix(const QString& name, const QString& prefix)
+{
+    if (!name.startsWith(prefix) || name.size() == prefix.size()) {
+        return false;
+    }
+    for (qsizetype i = prefix.size(); i < name.size(); ++i) {
+        if (!name.at(i).isDigit()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Entries such as hwmon3 or card12, sorted numerically rather than lexically.
+QStringList numberedEntries(const QString& directory, const QString& prefix)
+{
+    QStringList entries;
+    const QStringList names = QDir(directory).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString& name : names) {
+        if (hasNumericSuffix(name, prefix)) {
+            entries.append(name);
+        }
+    }
+    std::sort(entries.begin(), entries.end(), [&prefix](const QString& a, const QString& b) {
+        return a.mid(prefix.size()).toInt() < b.mid(prefix.size()).toInt();
+    });
+    return entries;
+}
+
+QString symlinkName(const QString& path)
+{
+    const QFileInfo info(path);
+    if (!info.isSymLink()) {
+        return {};
+    }
+    return QFileInfo(info.symLinkTarget()).fileName();
+}
+
+// Returns the tempN_input whose tempN_label matches one of labels.
+QString tempInputByLabel(const QString& hwmonDir, const QStringList& labels)
+{
+    const QStringList labelFiles = QDir(hwmonDir).entryList({QStringLiteral("temp*_label")}, QDir::Files);
+    for (const QString& label : labels) {
+        for (const QString& labelFile : labelFiles) {
+            if (QString::fromUtf8(readAttribute(hwmonDir + QLatin1Char('/') + labelFile))
+                    .compare(label, Qt::CaseInsensitive) != 0) {
+                continue;
+            }
+            QString input = labelFile;
+            input.replace(QStringLiteral("_label"), QStringLiteral("_input"));
+            const QString path = hwmonDir + QLatin1Char('/') + input;
+            if (QFile::exists(path)) {
+                return path;
+            }
+        }
+    }
+    return {};
+}
+
+QString firstExisting(const QString& directory, const QStringList& names)
+{
+    for (const QString& name : names) {
+        const QString path = directory + QLatin1Char('/') + name;
+        if (QFile::exists(path)) {
+            return path;
+        }
+    }
+    return {};
+}
+
+QString powerInput(const QString& hwmonDir)
+{
+    return firstExisting(hwmonDir, {QStringLiteral("power1_average"), QStringLiteral("power1_input")});
+}
+
+void resolveGpuHwmon(const QString& hwmonDir, GpuSensors& gpu)
+{
+    if (gpu.edgeTemperature.isEmpty()) {
+        QString edge = tempInputByLabel(hwmonDir, {QStringLiteral("edge")});
+        if (edge.isEmpty()) {
+            edge = firstExisting(hwmonDir, {QStringLiteral("temp1_input")});
+        }
+        gpu.edgeTemperature = encodePath(edge);
+    }
+    if (gpu.junctionTemperature.isEmpty()) {
+        gpu.junctionTemperature = encodePath(tempInputByLabel(hwmonDir, {QStringLiteral("junction")}));
+    }
+    if (gpu.power.isEmpty()) {
+        gpu.power = encodePath(powerInput(hwmonDir));
+    }
+}
+
+// The name the kernel gives the device in drm-pdev: the target of the
+// card's device link, or the PCI slot from its uevent.
+QByteArray deviceAddress(const QString& device)
+{
+    const QString linked = symlinkName(device);
+    if (!linked.isEmpty()) {
+        return linked.toUtf8();
+    }
+    const QList<QByteArray> lines = readAttribute(device + QStringLiteral("/uevent")).split('\n');
+    for (const QByteArray& line : lines) {
+        if (line.startsWith("PCI_SLOT_NAME=")) {
+            return line.mid(static_cast<int>(sizeof("PCI_SLOT_NAME=") - 1)).trimmed();
+        }
+    }
+    return {};
+}
+
+void discoverCpuTemperature(const QString& sysRoot, SensorMap& map)
+{
+    const QString hwmonRoot = sysRoot + QStringLiteral("/class/hwmon");
+    const QStringList hwmons = numberedEntries(hwmonRoot, QStringLiteral("hwmon"));
+    for (const QString& wanted : CPU_HWMON_NAMES) {
+        for (const QString& hwmon : hwmons) {
+            const QString dir = hwmonRoot + QLatin1Char('/') + hwmon;
+            if (QString::fromUtf8(readAttribute(dir + QStringLiteral("/name"))) != wanted) {
+                continue;
+            }
+            QString input = tempInputByLabel(dir, CPU_TEMP_LABELS);
+            if (input.isEmpty()) {
+                input = firstExisting(dir, {QStringLiteral("temp1_input")});
+            }
+            if (!input.isEmpty()) {
+                map.cpuTemperature = encodePath(input);
+                return;
+            }
+        }
+    }
+
+    const QString thermalRoot = sysRoot + QStringLiteral("/class/thermal");
+    const QStringList zones = numberedEntries(thermalRoot, QStringLiteral("thermal_zone"));
+    for (const QString& wanted : CPU_THERMAL_ZONE_TYPES) {
+        for (const QString& zone : zones) {
+            const QString dir = thermalRoot + QLatin1Char('/') + zone;
+            if (QString::fromUtf8(readAttribute(dir + QStringLiteral("/type"))) == wanted
+                && QFile::exists(dir + QStringLiteral("/temp"))) {
+                map.cpuTemperature = encodePath(dir + QStringLiteral("/temp"));
+                return;
+            }
+        }
+    }
+
+    // Unknown platform: keep the historical behaviour of using the first zone.
+    if (!zones.isEmpty()) {
+        const QString path = thermalRoot + QLatin1Char('/') + zones.first() + QStringLiteral("/temp");
+        if (QFile::exists(path)) {
+            map.cpuTemperature = encodePath(path);
+        }
+    }
+}
+
+void discoverGpus(const QString& sysRoot, SensorMap& map)
+{
+    const QString drmRoot = sysRoot + QStringLiteral("/class/drm");
+    for (const QString& card : numberedEntries(drmRoot, QStringLiteral("card"))) {
+        if (map.gpus.size() >= MAX_GPU_DEVICES) {
+            break;
+        }
+        const QString device = drmRoot + QLatin1Char('/') + card + QStringLiteral("/device");
+        GpuSensors gpu;
+        gpu.busy = encodePath(firstExisting(device, {QStringLiteral("gpu_busy_percent")}));
+        gpu.driver = symlinkName(device + QStringLiteral("/driver")).toUtf8();
+        if (gpu.busy.isEmpty() && gpu.driver.isEmpty()) {
+            continue;
+        }
+        gpu.card = card.toUtf8();
+        gpu.pciAddress = deviceAddress(device);
+
+        const QString hwmonRoot = device + QStringLiteral("/hwmon");
+        for (const QString& hwmon : numberedEntries(hwmonRoot, QStringLiteral("hwmon"))) {
+            resolveGpuHwmon(hwmonRoot + QLatin1Char('/') + hwmon, gpu);
+        }
+        map.gpus.append(gpu);
+    }
+
+    // Prefer a card that reports utilization, then any card with a bound driver.
+    for (int i = 0; i < map.gpus.size() && map.primaryGpu < 0; ++i) {
+        if (!map.gpus[i].busy.isEmpty()) {
+            map.primaryGpu = i;
+        }
+    }
+    if (map.primaryGpu < 0 && !map.gpus.isEmpty()) {
+        map.primaryGpu = 0;
+    }
+    if (map.primaryGpu >= 0 && !map.gpus[map.primaryGpu].edgeTemperature.isEmpty()) {
+        return;
+    }
+
+    // No card exposes a temperature, e.g. with a driver that registers its
+    // hwmon outside the DRM device: fall back to a GPU hwmon by name.
+    const QString hwmonRoot = sysRoot + QStringLiteral("/class/hwmon");
+    const QStringList hwmons = numberedEntries(hwmonRoot, QStringLiteral("hwmon"));
+    for (const QString& wanted : GPU_HWMON_NAMES) {
+        for (const QString& hwmon : hwmons) {
+            const QString dir = hwmonRoot + QLatin1Char('/') + hwmon;
+            if (QString::fromUtf8(readAttribute(dir + QStringLiteral("/name"))) != wanted) {
+                continue;
+            }
+            GpuSensors found;
+            resolveGpuHwmon(dir, found);
+            if (found.edgeTemperature.isEmpty()) {
+                continue;
+            }
+            if (map.primaryGpu < 0) {
+                map.gpus.append(found);
+                map.primaryGpu = map.gpus.size() - 1;
+                return;
+            }
+            GpuSensors& primary = map.gpus[map.primaryGpu];
+            primary.edgeTemperature = found.edgeTemperature;
+            primary.junctionTemperature = found.junctionTemperature;
+            if (primary.power.isEmpty()) {
+                primary.power = found.power;
+            }
+            return;
+        }
+    }
+}
+
+void discoverPower(const QString& sysRoot, SensorMap& map)
+{
+    const QString supplyRoot = sysRoot + QStringLiteral("/class/power_supply");
+    const QStringList supplies = QDir(supplyRoot).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    for (const QString& supply : supplies) {
+        const QString dir = supplyRoot + QLatin1Char('/') + supply;
+        if (readAttribute(dir + QStringLiteral("/type")) == "Battery"
+            && QFile::exists(dir + QStringLiteral("/power_now"))) {
+            map.power = encodePath(dir + QStringLiteral("/power_now"));
+            return;
+        }
+    }
+
+    // On handheld APUs the GPU hwmon reports package power.
+    if (map.primaryGpu >= 0 && !map.gpus[map.primaryGpu].power.isEmpty()) {
+        map.power = map.gpus[map.primaryGpu].power;
+        return;
+    }
+
+    const QString hwmonRoot = sysRoot + QStringLiteral("/class/hwmon");
+    for (const QString& hwmon : numberedEntries(hwmonRoot, QStringLiteral("hwmon"))) {
+        const QString path = powerInput(hwmonRoot + QLatin1Char('/') + hwmon);
+        if (!path.isEmpty()) {
+            map.power = encodePath(path);
+            return;
+        }
+    }
+}
+
+bool isAdapterType(const QByteArray& type)
+{
+    return type == "Mains" || type == "USB";
+}
+
+bool entryEquals(const char* entry, qint64 length, const char* expected)
+{
+    return length == static_cast<qint64>(std::strlen(expected)) && std::memcmp(entry, expected, length) == 0;
+}
+} // namespace
+
+SensorMap discoverSensors(const QString& sysRoot)
+{
+    SensorMap map;
+    discoverCpuTemperature(sysRoot, map);
+    discoverGpus(sysRoot, map);
+    discoverPower(sysRoot, map);
+    return map;
+}
+
+bool readOnBattery(const QString& sysRoot)
+{
+    const QString supplyRoot = sysRoot + QStringLiteral("/class/power_supply");
+    const QStringList supplies = QDir(supplyRoot).entryList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    bool hasAdapter = false;
+    bool hasBattery = false;
+    bool discharging = false;
+    for (const QString& supply : supplies) {
+        const QString dir = supplyRoot + QLatin1Char('/') + supply;
+        // Batteries of wireless mice and gamepads do not power the machine.
+        if (readAttribute(dir + QStringLiteral("/scope")) == "Device") {
+            continue;
+        }
+        const QByteArray type = readAttribute(dir + QStringLiteral("/type"));
+        if (isAdapterType(type)) {
+            if (readAttribute(dir + QStringLiteral("/online")) == "1") {
+                return false;
+            }
+            hasAdapter = true;
+        } else if (type == "Battery") {
+            hasBattery = true;
+            discharging = discharging || readAttribute(dir + QStringLiteral("/status")) == "Discharging";
+        }
+    }
+    return hasBattery && (hasAdapter || discharging);
+}
+
+void addSensorUevent(const char* data, qint64 size, SensorChanges* changes)
+{
+    bool sensor = false;
+    bool powerSupply = false;
+    bool hotplug = false;
+    qint64 offset = 0;
+    while (offset < size) {
+        const char* entry = data + offset;
+        const qint64 length = static_cast<qint64>(strnlen(entry, static_cast<size_t>(size - offset)));
+        for (const char* subsystem : SENSOR_SUBSYSTEMS) {
+            sensor = sensor || entryEquals(entry, length, subsystem);
+        }
+        powerSupply = powerSupply || entryEquals(entry, length, "SUBSYSTEM=power_supply");
+        hotplug = hotplug || entryEquals(entry, length, "ACTION=add") || entryEquals(entry, length, "ACTION=remove");
+        offset += length + 1;
+    }
+
+    // Change events, such as thermal trips and the periodic battery updates,
+    // leave the discovered paths valid.
+    changes->devices = changes->devices || (sensor && hotplug);
+    changes->powerSource = changes->powerSource || powerSupply;
+}
+
+SensorHotplugMonitor::~SensorHotplugMonitor()
+{
+    if (m_socket >= 0) {
+        ::close(m_socket);
+    }
+}
+
+bool SensorHotplugMonitor::open()
+{
+    if (m_socket >= 0) {
+        return true;
+    }
+
+    const int fd = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_KOBJECT_UEVENT);
+    if (fd < 0) {
+        return false;
+    }
+
+    sockaddr_nl address {};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = 1; // kernel uevents
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        ::close(fd);
+        return false;
+    }
+
+    m_socket = fd;
+    return true;
+}
+
+bool SensorHotplugMonitor::isOpen() const
+{
+    return m_socket >= 0;
+}
+
+SensorChanges SensorHotplugMonitor::takePendingChanges()
+{
+    SensorChanges changes;
+    if (m_socket < 0) {
+        return changes;
+    }
+
+    char buffer[4096];
+    for (;;) {
+        const ssize_t bytes = ::recv(m_socket, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (bytes <= 0) {
+            break;
+        }
+        addSensorUevent(buffer, bytes, &changes);
+    }
+    return changes;
+}
+
+} // namespace Runtime
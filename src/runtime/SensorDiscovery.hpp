@@ -0,0 +1,82 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+namespace Runtime {
+
+// Machines have an iGPU, a dGPU and rarely an eGPU on top.
+constexpr int MAX_GPU_DEVICES = 4;
+
+// The sensors of one DRM card. Empty paths do not exist on the card.
+struct GpuSensors {
+    QByteArray card;                // e.g. "card1"
+    QByteArray pciAddress;          // e.g. "0000:03:00.0", as in fdinfo drm-pdev
+    QByteArray driver;              // e.g. "amdgpu", informational
+    QByteArray busy;                // percent
+    QByteArray edgeTemperature;     // millidegrees Celsius
+    QByteArray junctionTemperature; // millidegrees Celsius
+    QByteArray power;               // microwatts
+};
+
+// Absolute paths of the sysfs attributes the provider reads every tick. An
+// empty path means the sensor does not exist on this machine and is never
+// probed again until the next discovery.
+struct SensorMap {
+    QByteArray cpuTemperature; // millidegrees Celsius
+    QByteArray power;          // microwatts, whole system
+    // Every DRM card with a bound driver, in card order, up to
+    // MAX_GPU_DEVICES. A GPU known only from a hwmon has an empty card.
+    QVector<GpuSensors> gpus;
+    // The GPU reported for processes that do not use one of their own: the
+    // first card that reports utilization, else the first card. -1 without
+    // a GPU.
+    int primaryGpu = -1;
+};
+
+// Walks <sysRoot>/class/hwmon/*/name, <sysRoot>/class/thermal/*/type and
+// <sysRoot>/class/drm/card*/device once and resolves stable sensor paths,
+// independent of the boot-time hwmon numbering.
+SensorMap discoverSensors(const QString& sysRoot);
+
+// Reads <sysRoot>/class/power_supply: true when a battery is present and no
+// AC or USB adapter is online. Without an adapter in sysfs, as on some
+// handhelds, the battery's own status decides.
+bool readOnBattery(const QString& sysRoot);
+
+// What a batch of kernel uevents touched.
+struct SensorChanges {
+    // A sensor device was added or removed: the sensor map is out of date.
+    bool devices = false;
+    // A power supply changed state, e.g. the AC adapter was plugged in. Such
+    // events also arrive periodically while a battery charges or discharges.
+    bool powerSource = false;
+};
+
+// Classifies one uevent message ("ACTION@DEVPATH" followed by NUL-separated
+// KEY=VALUE pairs) and adds what it touched to changes.
+void addSensorUevent(const char* data, qint64 size, SensorChanges* changes);
+
+// Listens for kernel uevents on the hwmon, drm, thermal and power_supply
+// subsystems so that the sensor map can be rebuilt on hotplug. Polling is
+// non-blocking and costs one recv() per call.
+class SensorHotplugMonitor {
+public:
+    SensorHotplugMonitor() = default;
+    ~SensorHotplugMonitor();
+
+    SensorHotplugMonitor(const SensorHotplugMonitor&) = delete;
+    SensorHotplugMonitor& operator=(const SensorHotplugMonitor&) = delete;
+
+    bool open();
+    bool isOpen() const;
+
+    // Drains pending uevents and returns what they touched.
+    SensorChanges takePendingChanges();
+
+private:
+    int m_socket = -1;
+};
+
+} // namespace Runtime
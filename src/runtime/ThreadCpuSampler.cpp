@@ -0,0 +1,175 @@
+#include "ThreadCpuSampler.hpp"
+
+#include "ProcfsParsers.hpp"
+
+#include <algorithm>
+
+#include <dirent.h>
+#include <unistd.h>
+
+namespace Runtime {
+
+namespace {
+constexpr int THREAD_COUNT_FIELD = 20;
+constexpr int STAT_BUFFER_SIZE = 1024;
+// Bounds the work per tick for processes with very many threads.
+constexpr int MAX_THREADS = 1024;
+
+bool parseTid(const char* name, qint64* tid)
+{
+    if (*name == '\0') {
+        return false;
+    }
+    qint64 value = 0;
+    for (; *name != '\0'; ++name) {
+        if (*name < '0' || *name > '9') {
+            return false;
+        }
+        value = value * 10 + (*name - '0');
+    }
+    *tid = value;
+    return true;
+}
+} // namespace
+
+ThreadCpuSampler::ThreadCpuSampler(qint64 pid, QByteArray procRoot)
+    : m_pid(pid)
+    , m_taskDir(procRoot + '/' + QByteArray::number(pid) + "/task")
+{
+}
+
+qint64 ThreadCpuSampler::pid() const
+{
+    return m_pid;
+}
+
+int ThreadCpuSampler::threadCount() const
+{
+    return m_threads.size();
+}
+
+qint64 ThreadCpuSampler::threadAt(int index) const
+{
+    return m_threads.at(index).tid;
+}
+
+void ThreadCpuSampler::sample(const char* processStat, qint64 processStatSize, quint64 nowNs,
+                              FileDescriptorCache& files)
+{
+    qint64 threadCount = 0;
+    if (Procfs::statField(processStat, processStatSize, THREAD_COUNT_FIELD, &threadCount)
+        && threadCount != m_threadCount) {
+        m_threadCount = threadCount;
+        m_rescan = true;
+    }
+    if (m_rescan) {
+        rescan(files);
+    }
+
+    const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+    const double elapsedSeconds = m_lastSampleNs > 0 && nowNs > m_lastSampleNs
+        ? (nowNs - m_lastSampleNs) / 1e9
+        : 0.0;
+    m_lastSampleNs = nowNs;
+
+    char buffer[STAT_BUFFER_SIZE];
+    for (Thread& thread : m_threads) {
+        const qint64 bytes = files.readPath(thread.statPath, buffer, sizeof(buffer));
+        qint64 ticks = 0;
+        if (bytes <= 0 || !Procfs::statCpuTicks(buffer, bytes, &ticks)) {
+            // The thread exited; pick up the new thread list next tick.
+            thread.cpuPercent = 0.0;
+            m_rescan = true;
+            continue;
+        }
+
+        // Threads rename themselves after they start, so keep it current.
+        Procfs::statComm(buffer, bytes, thread.name, sizeof(thread.name));
+        thread.cpuPercent = 0.0;
+        if (thread.ticks >= 0 && ticks >= thread.ticks && ticksPerSecond > 0 && elapsedSeconds > 0.0) {
+            const double busySeconds = (ticks - thread.ticks) / static_cast<double>(ticksPerSecond);
+            // Tick granularity can push a saturated thread slightly past 100%.
+            thread.cpuPercent = qMin(busySeconds / elapsedSeconds * 100.0, 100.0);
+        }
+        thread.ticks = ticks;
+    }
+}
+
+void ThreadCpuSampler::collectHottest(ProcessMetrics& metrics) const
+{
+    for (const Thread& thread : m_threads) {
+        if (thread.cpuPercent <= 0.0) {
+            continue;
+        }
+        metrics.threadCpuPercent = qMax(metrics.threadCpuPercent, thread.cpuPercent);
+
+        int position = metrics.hotThreadCount;
+        while (position > 0 && metrics.hotThreads[position - 1].cpuPercent < thread.cpuPercent) {
+            --position;
+        }
+        if (position >= HOT_THREAD_COUNT) {
+            continue;
+        }
+        const int last = qMin(metrics.hotThreadCount, HOT_THREAD_COUNT - 1);
+        for (int i = last; i > position; --i) {
+            metrics.hotThreads[i] = metrics.hotThreads[i - 1];
+        }
+        ThreadCpuUsage& usage = metrics.hotThreads[position];
+        usage.tid = thread.tid;
+        usage.cpuPercent = thread.cpuPercent;
+        std::copy(std::begin(thread.name), std::end(thread.name), std::begin(usage.name));
+        metrics.hotThreadCount = qMin(metrics.hotThreadCount + 1, HOT_THREAD_COUNT);
+    }
+}
+
+void ThreadCpuSampler::release(FileDescriptorCache& files)
+{
+    for (const Thread& thread : std::as_const(m_threads)) {
+        files.releasePath(thread.statPath);
+    }
+    m_threads.clear();
+    m_threadCount = -1;
+    m_rescan = true;
+    m_lastSampleNs = 0;
+}
+
+void ThreadCpuSampler::rescan(FileDescriptorCache& files)
+{
+    m_rescan = false;
+
+    QVector<qint64> tids;
+    if (DIR* dir = ::opendir(m_taskDir.constData())) {
+        while (const dirent* entry = ::readdir(dir)) {
+            qint64 tid = 0;
+            if (parseTid(entry->d_name, &tid) && tids.size() < MAX_THREADS) {
+                tids.append(tid);
+            }
+        }
+        ::closedir(dir);
+    }
+    std::sort(tids.begin(), tids.end());
+
+    // Merge the listing into the table: survivors keep their baselines.
+    QVector<Thread> threads;
+    threads.reserve(tids.size());
+    int old = 0;
+    for (qint64 tid : std::as_const(tids)) {
+        while (old < m_threads.size() && m_threads[old].tid < tid) {
+            files.releasePath(m_threads[old++].statPath);
+        }
+        if (old < m_threads.size() && m_threads[old].tid == tid) {
+            threads.append(m_threads[old++]);
+            continue;
+        }
+        Thread thread;
+        thread.tid = tid;
+        thread.statPath = m_taskDir + '/' + QByteArray::number(tid) + "/stat";
+        threads.append(thread);
+    }
+    while (old < m_threads.size()) {
+        files.releasePath(m_threads[old++].statPath);
+    }
+    m_threads = threads;
+}
+
+} // namespace Runtime
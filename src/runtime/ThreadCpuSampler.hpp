@@ -0,0 +1,57 @@
+#pragma once
+
+#include "FileDescriptorCache.hpp"
+#include "ProcessMetricsProvider.hpp"
+
+#include <QByteArray>
+#include <QVector>
+#include <QtGlobal>
+
+namespace Runtime {
+
+// Per-thread CPU usage of one process from /proc/<pid>/task/<tid>/stat. The
+// threads live in a table sorted by TID that is kept between ticks: the task
+// directory is listed again only when the process's thread count changes or
+// a thread's stat stops reading, and the new listing is merged into the
+// table so that surviving threads keep their previous tick counts. In steady
+// state a tick costs one pread() per thread and does not allocate.
+class ThreadCpuSampler {
+public:
+    ThreadCpuSampler(qint64 pid, QByteArray procRoot);
+
+    qint64 pid() const;
+    int threadCount() const;
+    qint64 threadAt(int index) const;
+
+    // processStat is the process's own /proc/<pid>/stat, already read by the
+    // caller. nowNs is a monotonic timestamp. A thread's first sample only
+    // establishes its baseline.
+    void sample(const char* processStat, qint64 processStatSize, quint64 nowNs, FileDescriptorCache& files);
+
+    // Raises metrics.threadCpuPercent to this process's busiest thread and
+    // merges its threads into metrics.hotThreads, so that the threads of a
+    // whole process tree can be ranked together.
+    void collectHottest(ProcessMetrics& metrics) const;
+
+    void release(FileDescriptorCache& files);
+
+private:
+    struct Thread {
+        qint64 tid = 0;
+        qint64 ticks = -1;
+        double cpuPercent = 0.0;
+        char name[THREAD_NAME_SIZE] = {};
+        QByteArray statPath;
+    };
+
+    void rescan(FileDescriptorCache& files);
+
+    qint64 m_pid = 0;
+    QByteArray m_taskDir;
+    QVector<Thread> m_threads;
+    qint64 m_threadCount = -1;
+    bool m_rescan = true;
+    quint64 m_lastSampleNs = 0;
+};
+
+} // namespace Runtime
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts heap allocations for the zero-allocation checks of the tests and the
+// alloc* benchmarks. It replaces the global operator new and delete, which
+// cannot be inline, so include it from exactly one source file per executable.
+
+namespace AllocationTracking {
+inline std::atomic<bool> counting{false};
+inline std::atomic<qint64> allocations{0};
+} // namespace AllocationTracking
+
+// Counts the allocations made while it is alive.
+class AllocationCounter {
+public:
+    AllocationCounter()
+    {
+        AllocationTracking::allocations = 0;
+        AllocationTracking::counting = true;
+    }
+
+    ~AllocationCounter()
+    {
+        AllocationTracking::counting = false;
+    }
+
+    AllocationCounter(const AllocationCounter&) = delete;
+    AllocationCounter& operator=(const AllocationCounter&) = delete;
+
+    qint64 count() const
+    {
+        return AllocationTracking::allocations;
+    }
+};
+
+void* operator new(std::size_t size)
+{
+    if (AllocationTracking::counting) {
+        ++AllocationTracking::allocations;
+    }
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
@@ -0,0 +1,1230 @@
+#include "AllocationCounter.hpp"
+#include "TestFixtures.hpp"
+#include "runtime/FileDescriptorCache.hpp"
+#include "runtime/FrameTimingChannel.hpp"
+#include "runtime/GpuEngineSampler.hpp"
+#include "runtime/PressureMonitor.hpp"
+#include "runtime/ProcessMetricsProvider.hpp"
+#include "runtime/ProcfsParsers.hpp"
+#include "runtime/SensorDiscovery.hpp"
+#include "runtime/ThreadCpuSampler.hpp"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QTest>
+
+#include <cstring>
+#include <ctime>
+#include <initializer_list>
+#include <limits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+// A handheld-like sysfs tree: an NVMe hwmon ahead of the CPU so that hwmon0
+// is the wrong sensor, an APU on card1 behind an eDP connector, and a battery.
+bool buildSysFixture(const QString& sys)
+{
+    return writeFixture(sys, "class/hwmon/hwmon0/name", "nvme\n")
+        && writeFixture(sys, "class/hwmon/hwmon0/temp1_input", "38850\n")
+        && writeFixture(sys, "class/hwmon/hwmon1/name", "k10temp\n")
+        && writeFixture(sys, "class/hwmon/hwmon1/temp1_label", "Tctl\n")
+        && writeFixture(sys, "class/hwmon/hwmon1/temp1_input", "61500\n")
+        && writeFixture(sys, "class/hwmon/hwmon1/temp3_label", "Tccd1\n")
+        && writeFixture(sys, "class/hwmon/hwmon1/temp3_input", "58000\n")
+        && writeFixture(sys, "class/thermal/thermal_zone0/type", "acpitz\n")
+        && writeFixture(sys, "class/thermal/thermal_zone0/temp", "45000\n")
+        && writeFixture(sys, "class/drm/card1-eDP-1/status", "connected\n")
+        && linkFixture(sys, "class/drm/card1/device/driver", "../../../../bus/pci/drivers/amdgpu")
+        && writeFixture(sys, "class/drm/card1/device/uevent", "DRIVER=amdgpu\nPCI_SLOT_NAME=0000:04:00.0\n")
+        && writeFixture(sys, "class/drm/card1/device/gpu_busy_percent", "37\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon2/name", "amdgpu\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon2/temp1_label", "edge\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon2/temp1_input", "55000\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon2/temp2_label", "junction\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon2/temp2_input", "63000\n")
+        && writeFixture(sys, "class/drm/card1/device/hwmon/hwmon2/power1_average", "15000000\n")
+        && writeFixture(sys, "class/power_supply/ACAD/type", "Mains\n")
+        && writeFixture(sys, "class/power_supply/ACAD/online", "1\n")
+        && writeFixture(sys, "class/power_supply/BAT1/type", "Battery\n")
+        && writeFixture(sys, "class/power_supply/BAT1/status", "Charging\n")
+        && writeFixture(sys, "class/power_supply/BAT1/power_now", "21500000\n");
+}
+
+// 1.2 GB of the 1.6 GB RSS is the game's share; 200 MB of its share is in swap.
+const char SMAPS_ROLLUP[] = "00400000-7ffd5b3f2000 ---p 00000000 00:00 0                          [rollup]\n"
+                            "Rss:             1638400 kB\n"
+                            "Pss:             1228800 kB\n"
+                            "Pss_Anon:         900000 kB\n"
+                            "Pss_File:         328800 kB\n"
+                            "Shared_Clean:     512000 kB\n"
+                            "Shared_Dirty:          0 kB\n"
+                            "Private_Clean:    102400 kB\n"
+                            "Private_Dirty:   1024000 kB\n"
+                            "Swap:             262144 kB\n"
+                            "SwapPss:          204800 kB\n"
+                            "Locked:                0 kB\n";
+
+bool buildProcFixture(const QString& proc)
+{
+    return writeFixture(proc, "meminfo", "MemTotal:       16384000 kB\nMemFree:         8000000 kB\n")
+        && writeFixture(proc, "4242/stat",
+                        "4242 (Game (x64) Shipping) S 1 4242 4242 0 -1 4194560 "
+                        "1200 0 3 0 250 75 0 0 20 0 48 0 1000 8000000 51200\n")
+        && writeFixture(proc, "4242/statm", statmFixture(1638400))
+        && writeFixture(proc, "4242/smaps_rollup", SMAPS_ROLLUP);
+}
+
+// The game runs in a systemd scope of its own, under a system that is
+// stalling on IO elsewhere. PSI totals are in microseconds.
+const char GAME_SCOPE[] = "/user.slice/user-1000.slice/user@1000.service/app.slice/app-steam-4242.scope";
+
+QByteArray pressureFile(const char* some, quint64 totalUs)
+{
+    return QStringLiteral("some %1 avg60=0.00 avg300=0.00 total=%2\n"
+                          "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n")
+        .arg(QLatin1String(some))
+        .arg(totalUs)
+        .toLatin1();
+}
+
+bool addPressureFixture(const QString& proc, const QString& sys)
+{
+    const QString scope = QStringLiteral("fs/cgroup") + QLatin1String(GAME_SCOPE);
+    return writeFixture(proc, "4242/cgroup", QByteArray("0::") + GAME_SCOPE + '\n')
+        && writeFixture(proc, "pressure/cpu", pressureFile("avg10=9.50", 90000000))
+        && writeFixture(proc, "pressure/memory", pressureFile("avg10=0.00", 1000))
+        && writeFixture(proc, "pressure/io", pressureFile("avg10=31.25", 500000000))
+        && writeFixture(sys, scope + "/cpu.pressure", pressureFile("avg10=4.20", 2000000))
+        && writeFixture(sys, scope + "/memory.pressure", pressureFile("avg10=12.34", 3000000))
+        && writeFixture(sys, scope + "/io.pressure", pressureFile("avg10=0.50", 400000));
+}
+
+// A discrete GPU next to the APU of buildSysFixture(), busy and hot.
+bool addDiscreteGpu(const QString& sys)
+{
+    return linkFixture(sys, "class/drm/card2/device/driver", "../../../../bus/pci/drivers/amdgpu")
+        && writeFixture(sys, "class/drm/card2/device/uevent", "DRIVER=amdgpu\nPCI_SLOT_NAME=0000:03:00.0\n")
+        && writeFixture(sys, "class/drm/card2/device/gpu_busy_percent", "88\n")
+        && writeFixture(sys, "class/drm/card2/device/hwmon/hwmon3/name", "amdgpu\n")
+        && writeFixture(sys, "class/drm/card2/device/hwmon/hwmon3/temp1_label", "edge\n")
+        && writeFixture(sys, "class/drm/card2/device/hwmon/hwmon3/temp1_input", "71000\n")
+        && writeFixture(sys, "class/drm/card2/device/hwmon/hwmon3/power1_average", "120000000\n");
+}
+
+// fdinfo of an amdgpu client, which reports busy time per engine class.
+QByteArray amdgpuFdinfo(qint64 clientId, qint64 gfxNs, qint64 computeNs)
+{
+    return QStringLiteral("pos:\t0\nflags:\t02100002\nmnt_id:\t24\nino:\t1081\ndrm-driver:\tamdgpu\n"
+                          "drm-client-id:\t%1\ndrm-pdev:\t0000:03:00.0\ndrm-memory-vram:\t1048576 KiB\n"
+                          "drm-memory-gtt:\t65536 KiB\ndrm-memory-cpu:\t0 KiB\ndrm-resident-vram:\t1048576 KiB\n"
+                          "drm-engine-gfx:\t%2 ns\ndrm-engine-compute:\t%3 ns\n")
+        .arg(clientId)
+        .arg(gfxNs)
+        .arg(computeNs)
+        .toLatin1();
+}
+
+// fdinfo of an xe client, which reports busy cycles against a total.
+QByteArray xeFdinfo(qint64 clientId, qint64 rcsCycles, qint64 vcsCycles, qint64 totalCycles)
+{
+    return QStringLiteral("pos:\t0\nflags:\t02100002\ndrm-driver:\txe\ndrm-client-id:\t%1\ndrm-pdev:\t0000:00:02.0\n"
+                          "drm-cycles-rcs:\t%2\ndrm-total-cycles-rcs:\t%4\n"
+                          "drm-engine-capacity-vcs:\t2\ndrm-cycles-vcs:\t%3\ndrm-total-cycles-vcs:\t%4\n"
+                          "drm-total-system:\t512 MiB\ndrm-resident-system:\t256 MiB\ndrm-resident-stolen:\t4194304\n")
+        .arg(clientId)
+        .arg(rcsCycles)
+        .arg(vcsCycles)
+        .arg(totalCycles)
+        .toLatin1();
+}
+
+// A kernel uevent message: a header followed by KEY=VALUE pairs, each
+// NUL-terminated.
+QByteArray uevent(std::initializer_list<const char*> entries)
+{
+    QByteArray message;
+    for (const char* entry : entries) {
+        message += entry;
+        message += '\0';
+    }
+    return message;
+}
+
+// Shared-memory names are global; keep test runs from colliding.
+QByteArray frameChannelPrefix(const char* tag)
+{
+    return QByteArrayLiteral("/runtime-frames-test-") + tag + '-'
+        + QByteArray::number(QCoreApplication::applicationPid());
+}
+
+quint64 monotonicNowNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<quint64>(now.tv_sec) * 1'000'000'000ull + static_cast<quint64>(now.tv_nsec);
+}
+} // namespace
+
+class MetricsProviderTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void testStatFieldWithSpacesInComm();
+    void testStatFieldMalformed();
+    void testStatComm();
+    void testStatusVmRss();
+    void testStatmResident();
+    void testSysfsInteger();
+    void testPidList();
+    void testDrmFdinfo();
+    void testSmapsRollup();
+    void testPressure();
+    void testDescriptorCacheReuse();
+    void testZeroAllocationsPerSample();
+    void testSensorDiscovery();
+    void testSensorDiscoveryThermalZoneFallback();
+    void testSensorDiscoveryMultipleGpus();
+    void testSensorDiscoveryPowerSource();
+    void testSensorUevents();
+    void testProviderReadsFixtureTree();
+    void testProviderAggregatesProcessTree();
+    void testThreadCpuSampler();
+    void testGpuEngineSampler();
+    void testProviderMapsGameToItsGpu();
+    void testProviderSamplesRequestedFields();
+    void testProviderBacksOffFailingSensor();
+    void testProviderReadsPressure();
+    void testFrameTimingRing();
+    void testProviderReadsFrameTiming();
+    void testProviderReportsStalledFrames();
+    void testProviderFollowsReplacedFrameChannel();
+};
+
+void MetricsProviderTest::testStatFieldWithSpacesInComm()
+{
+    const char stat[] = "4242 (Game (x64) Shipping) S 1 4242 4242 0 -1 4194560 "
+                        "1200 0 3 0 250 75 0 0 20 0 48 0 1000 8000000 51200\n";
+    const qint64 size = static_cast<qint64>(std::strlen(stat));
+
+    qint64 value = 0;
+    QVERIFY(Runtime::Procfs::statField(stat, size, 4, &value));
+    QCOMPARE(value, 1LL);
+    QVERIFY(Runtime::Procfs::statField(stat, size, 14, &value));
+    QCOMPARE(value, 250LL);
+    QVERIFY(Runtime::Procfs::statField(stat, size, 15, &value));
+    QCOMPARE(value, 75LL);
+    QVERIFY(Runtime::Procfs::statField(stat, size, 20, &value));
+    QCOMPARE(value, 48LL);
+
+    qint64 ticks = 0;
+    QVERIFY(Runtime::Procfs::statCpuTicks(stat, size, &ticks));
+    QCOMPARE(ticks, 325LL);
+}
+
+void MetricsProviderTest::testStatFieldMalformed()
+{
+    qint64 value = -7;
+    const char noParen[] = "4242 game S 1 2 3";
+    QVERIFY(!Runtime::Procfs::statField(noParen, std::strlen(noParen), 4, &value));
+
+    const char truncated[] = "4242 (game) S 1 2 3\n";
+    QVERIFY(!Runtime::Procfs::statField(truncated, std::strlen(truncated), 14, &value));
+    QVERIFY(!Runtime::Procfs::statField(truncated, std::strlen(truncated), 3, &value));
+    QCOMPARE(value, -7LL);
+    // Field 4 is the first numeric one.
+    QVERIFY(Runtime::Procfs::statField(truncated, std::strlen(truncated), 4, &value));
+    QCOMPARE(value, 1LL);
+}
+
+void MetricsProviderTest::testStatComm()
+{
+    char name[Runtime::THREAD_NAME_SIZE] = {};
+    const char stat[] = "4243 (Render (Main)) S 1 4242 4242 0 -1 4194560 0 0 0 0 10 5\n";
+    QVERIFY(Runtime::Procfs::statComm(stat, std::strlen(stat), name, sizeof(name)));
+    QCOMPARE(QByteArray(name), QByteArray("Render (Main)"));
+
+    char shortName[5] = {};
+    QVERIFY(Runtime::Procfs::statComm(stat, std::strlen(stat), shortName, sizeof(shortName)));
+    QCOMPARE(QByteArray(shortName), QByteArray("Rend"));
+
+    const char noParen[] = "4243 render S 1";
+    QVERIFY(!Runtime::Procfs::statComm(noParen, std::strlen(noParen), name, sizeof(name)));
+    QCOMPARE(QByteArray(name), QByteArray("Render (Main)"));
+}
+
+void MetricsProviderTest::testStatusVmRss()
+{
+    const char status[] = "Name:\tgame.exe\nVmPeak:\t 9000000 kB\nVmRSSX:\t 1 kB\nVmRSS:\t  204800 kB\nThreads:\t48\n";
+    const qint64 size = static_cast<qint64>(std::strlen(status));
+
+    qint64 kb = 0;
+    QVERIFY(Runtime::Procfs::keyValueKb(status, size, "VmRSS:", &kb));
+    QCOMPARE(kb, 204800LL);
+    QVERIFY(Runtime::Procfs::keyValueKb(status, size, "Threads:", &kb));
+    QCOMPARE(kb, 48LL);
+    QVERIFY(!Runtime::Procfs::keyValueKb(status, size, "VmSwap:", &kb));
+}
+
+void MetricsProviderTest::testStatmResident()
+{
+    const char statm[] = "2000000 51200 3000 100 0 90000 0\n";
+    qint64 pages = 0;
+    QVERIFY(Runtime::Procfs::statmResidentPages(statm, std::strlen(statm), &pages));
+    QCOMPARE(pages, 51200LL);
+}
+
+void MetricsProviderTest::testSysfsInteger()
+{
+    qint64 value = 0;
+    QVERIFY(Runtime::Procfs::sysfsInteger("72500\n", 6, &value));
+    QCOMPARE(value, 72500LL);
+    QVERIFY(Runtime::Procfs::sysfsInteger(" -12 \n", 6, &value));
+    QCOMPARE(value, -12LL);
+    QVERIFY(!Runtime::Procfs::sysfsInteger("12a\n", 4, &value));
+    QVERIFY(!Runtime::Procfs::sysfsInteger("\n", 1, &value));
+    QCOMPARE(value, -12LL);
+
+    // The largest qint64 parses; one more overflows and is rejected.
+    QVERIFY(Runtime::Procfs::sysfsInteger("9223372036854775807\n", 20, &value));
+    QCOMPARE(value, std::numeric_limits<qint64>::max());
+    QVERIFY(!Runtime::Procfs::sysfsInteger("9223372036854775808\n", 20, &value));
+    QVERIFY(!Runtime::Procfs::sysfsInteger("18446744073709551616\n", 21, &value));
+    QCOMPARE(value, std::numeric_limits<qint64>::max());
+}
+
+void MetricsProviderTest::testPidList()
+{
+    qint64 pids[4] = {};
+    const char children[] = "4243 4244 \n";
+    QCOMPARE(Runtime::Procfs::pidList(children, std::strlen(children), pids, 4), 2);
+    QCOMPARE(pids[0], 4243LL);
+    QCOMPARE(pids[1], 4244LL);
+
+    QCOMPARE(Runtime::Procfs::pidList("", 0, pids, 4), 0);
+    QCOMPARE(Runtime::Procfs::pidList("1 2 3 4 5", 9, pids, 4), 4);
+    QCOMPARE(Runtime::Procfs::pidList("12 x", 4, pids, 4), -1);
+    QCOMPARE(Runtime::Procfs::pidList("-3", 2, pids, 4), -1);
+}
+
+void MetricsProviderTest::testDrmFdinfo()
+{
+    Runtime::Procfs::DrmFdinfo info;
+    const QByteArray amdgpu = amdgpuFdinfo(7, 123456789, 0);
+    QVERIFY(Runtime::Procfs::drmFdinfo(amdgpu.constData(), amdgpu.size(), &info));
+    QCOMPARE(info.clientId, 7LL);
+    QCOMPARE(QByteArray(info.pdev), QByteArray("0000:03:00.0"));
+    QCOMPARE(info.engineCount, 2);
+    QCOMPARE(QByteArray(info.engines[0].name), QByteArray("gfx"));
+    QVERIFY(info.engines[0].hasBusyNs);
+    QCOMPARE(info.engines[0].busyNs, quint64(123456789));
+    QCOMPARE(info.engines[0].capacity, 1LL);
+    QCOMPARE(QByteArray(info.engines[1].name), QByteArray("compute"));
+    // drm-resident-vram repeats drm-memory-vram and is not counted twice.
+    QCOMPARE(info.vramKb, 1048576LL);
+    QCOMPARE(info.gttKb, 65536LL);
+
+    const QByteArray xe = xeFdinfo(9, 300, 40, 1000);
+    QVERIFY(Runtime::Procfs::drmFdinfo(xe.constData(), xe.size(), &info));
+    QCOMPARE(info.clientId, 9LL);
+    QCOMPARE(QByteArray(info.pdev), QByteArray("0000:00:02.0"));
+    QCOMPARE(info.engineCount, 2);
+    QVERIFY(!info.engines[0].hasBusyNs);
+    QCOMPARE(info.engines[0].cycles, quint64(300));
+    QCOMPARE(info.engines[0].totalCycles, quint64(1000));
+    QCOMPARE(QByteArray(info.engines[1].name), QByteArray("vcs"));
+    QCOMPARE(info.engines[1].capacity, 2LL);
+    QCOMPARE(info.vramKb, 0LL);
+    QCOMPARE(info.gttKb, 262144LL);
+
+    // Not a DRM client: the output is left alone.
+    const char file[] = "pos:\t0\nflags:\t02100002\nmnt_id:\t24\nino:\t1081\n";
+    QVERIFY(!Runtime::Procfs::drmFdinfo(file, std::strlen(file), &info));
+    QCOMPARE(info.clientId, 9LL);
+}
+
+void MetricsProviderTest::testSmapsRollup()
+{
+    Runtime::Procfs::SmapsRollup rollup;
+    QVERIFY(Runtime::Procfs::smapsRollup(SMAPS_ROLLUP, std::strlen(SMAPS_ROLLUP), &rollup));
+    QCOMPARE(rollup.pssKb, 1228800LL);
+    QCOMPARE(rollup.ussKb, 1126400LL);
+    QCOMPARE(rollup.swapKb, 204800LL);
+
+    // Kernels without SwapPss report the whole swapped-out size.
+    const char oldKernel[] = "Rss:\t2048 kB\nPss:\t1024 kB\nPrivate_Dirty:\t512 kB\nSwap:\t64 kB\n";
+    QVERIFY(Runtime::Procfs::smapsRollup(oldKernel, std::strlen(oldKernel), &rollup));
+    QCOMPARE(rollup.ussKb, 512LL);
+    QCOMPARE(rollup.swapKb, 64LL);
+
+    const char status[] = "Name:\tgame.exe\nVmRSS:\t204800 kB\n";
+    QVERIFY(!Runtime::Procfs::smapsRollup(status, std::strlen(status), &rollup));
+    QCOMPARE(rollup.pssKb, 1024LL);
+}
+
+void MetricsProviderTest::testPressure()
+{
+    // cpu.pressure has a "full" line since Linux 5.13; only "some" is read.
+    const char cpu[] = "some avg10=2.04 avg60=0.75 avg300=0.15 total=150338920\n"
+                       "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n";
+    Runtime::Procfs::PressureStats stats;
+    QVERIFY(Runtime::Procfs::pressureSome(cpu, std::strlen(cpu), &stats));
+    QCOMPARE(stats.avg10, 2.04);
+    QCOMPARE(stats.totalUs, quint64(150338920));
+
+    const char malformed[] = "some avg60=0.75 total=12\n";
+    QVERIFY(!Runtime::Procfs::pressureSome(malformed, std::strlen(malformed), &stats));
+    const char fullOnly[] = "full avg10=1.00 avg60=0.00 avg300=0.00 total=5\n";
+    QVERIFY(!Runtime::Procfs::pressureSome(fullOnly, std::strlen(fullOnly), &stats));
+    QCOMPARE(stats.totalUs, quint64(150338920));
+
+    // Hybrid hierarchies list the v1 controllers first.
+    const char hybrid[] = "12:memory:/user.slice\n1:name=systemd:/user.slice/game.scope\n"
+                          "0::/user.slice/game.scope\n";
+    qint64 offset = 0;
+    qint64 length = 0;
+    QVERIFY(Runtime::Procfs::unifiedCgroupPath(hybrid, std::strlen(hybrid), &offset, &length));
+    QCOMPARE(QByteArray(hybrid + offset, length), QByteArray("/user.slice/game.scope"));
+
+    const char legacy[] = "12:memory:/user.slice\n1:name=systemd:/user.slice/game.scope\n";
+    QVERIFY(!Runtime::Procfs::unifiedCgroupPath(legacy, std::strlen(legacy), &offset, &length));
+}
+
+void MetricsProviderTest::testDescriptorCacheReuse()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    file.write("41000\n");
+    file.flush();
+
+    Runtime::FileDescriptorCache cache;
+    const QByteArray path = file.fileName().toLocal8Bit();
+
+    char buffer[64];
+    QCOMPARE(cache.readPath(path, buffer, sizeof(buffer)), 6LL);
+    QCOMPARE(cache.openDescriptorCount(), 1);
+
+    file.resize(0);
+    file.seek(0);
+    file.write("43000\n");
+    file.flush();
+
+    qint64 value = 0;
+    const qint64 bytes = cache.readPath(path, buffer, sizeof(buffer));
+    QVERIFY(Runtime::Procfs::sysfsInteger(buffer, bytes, &value));
+    QCOMPARE(value, 43000LL);
+    QCOMPARE(cache.openDescriptorCount(), 1);
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QVERIFY(cache.readProcFile(pid, Runtime::FileDescriptorCache::ProcFile::Stat, buffer, sizeof(buffer)) > 0);
+    QCOMPARE(cache.openDescriptorCount(), 2);
+
+    cache.releasePid(pid);
+    QCOMPARE(cache.openDescriptorCount(), 1);
+    QVERIFY(cache.readPath(QByteArrayLiteral("/nonexistent/sensor"), buffer, sizeof(buffer)) < 0);
+    QCOMPARE(cache.openDescriptorCount(), 1);
+
+    // A file that cannot be read does not close the PID's other files.
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QString proc = root.path() + QStringLiteral("/proc");
+    QVERIFY(buildProcFixture(proc));
+    QVERIFY(QFile::remove(proc + QStringLiteral("/4242/smaps_rollup")));
+    Runtime::FileDescriptorCache fixtureCache(QFile::encodeName(proc));
+    QVERIFY(fixtureCache.readProcFile(4242, Runtime::FileDescriptorCache::ProcFile::Stat, buffer, sizeof(buffer)) > 0);
+    QVERIFY(fixtureCache.readProcFile(4242, Runtime::FileDescriptorCache::ProcFile::SmapsRollup, buffer,
+                                      sizeof(buffer)) < 0);
+    QCOMPARE(fixtureCache.openDescriptorCount(), 1);
+    fixtureCache.releasePid(4242);
+    QCOMPARE(fixtureCache.openDescriptorCount(), 0);
+}
+
+void MetricsProviderTest::testZeroAllocationsPerSample()
+{
+    QTemporaryFile sensor;
+    QVERIFY(sensor.open());
+    sensor.write("65000\n");
+    sensor.flush();
+
+    Runtime::FileDescriptorCache cache;
+    const QByteArray sensorPath = sensor.fileName().toLocal8Bit();
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    char statBuffer[1024];
+    char statmBuffer[128];
+    char smapsBuffer[2048];
+    char sensorBuffer[64];
+
+    // Warm the cache: opening descriptors allocates, steady-state sampling must not.
+    QVERIFY(cache.readProcFile(pid, Runtime::FileDescriptorCache::ProcFile::Stat, statBuffer, sizeof(statBuffer)) > 0);
+    QVERIFY(cache.readProcFile(pid, Runtime::FileDescriptorCache::ProcFile::Statm, statmBuffer, sizeof(statmBuffer)) > 0);
+    QVERIFY(cache.readProcFile(pid, Runtime::FileDescriptorCache::ProcFile::SmapsRollup, smapsBuffer, sizeof(smapsBuffer)) > 0);
+    QVERIFY(cache.readPath(sensorPath, sensorBuffer, sizeof(sensorBuffer)) > 0);
+
+    bool parsed = true;
+    qint64 allocations = 0;
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < 100; ++i) {
+            qint64 ticks = 0;
+            qint64 rssPages = 0;
+            qint64 milli = 0;
+            Runtime::Procfs::SmapsRollup rollup;
+            const qint64 statBytes = cache.readProcFile(pid, Runtime::FileDescriptorCache::ProcFile::Stat,
+                                                        statBuffer, sizeof(statBuffer));
+            const qint64 statmBytes = cache.readProcFile(pid, Runtime::FileDescriptorCache::ProcFile::Statm,
+                                                         statmBuffer, sizeof(statmBuffer));
+            const qint64 smapsBytes = cache.readProcFile(pid, Runtime::FileDescriptorCache::ProcFile::SmapsRollup,
+                                                         smapsBuffer, sizeof(smapsBuffer));
+            const qint64 sensorBytes = cache.readPath(sensorPath, sensorBuffer, sizeof(sensorBuffer));
+            parsed = parsed
+                && Runtime::Procfs::statCpuTicks(statBuffer, statBytes, &ticks)
+                && Runtime::Procfs::statmResidentPages(statmBuffer, statmBytes, &rssPages)
+                && Runtime::Procfs::smapsRollup(smapsBuffer, smapsBytes, &rollup)
+                && Runtime::Procfs::sysfsInteger(sensorBuffer, sensorBytes, &milli);
+        }
+        allocations = counter.count();
+    }
+
+    QVERIFY(parsed);
+    QCOMPARE(allocations, qint64(0));
+
+    // The whole provider over the fixture tree: once every descriptor and
+    // per-process sampler exists, a tick allocates only the returned vector.
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    paths.frameChannelPrefix = QString::fromLatin1(frameChannelPrefix("alloc"));
+    QVERIFY(buildProcFixture(paths.procRoot));
+    QVERIFY(buildSysFixture(paths.sysRoot));
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    const QVector<qint64> pids{4242};
+    for (int i = 0; i < 3; ++i) {
+        QVERIFY(provider->metricsForPids(pids).first().valid);
+    }
+
+    constexpr int TICKS = 100;
+    bool valid = true;
+    {
+        AllocationCounter counter;
+        for (int i = 0; i < TICKS; ++i) {
+            valid = provider->metricsForPids(pids).first().valid && valid;
+        }
+        allocations = counter.count();
+    }
+
+    QVERIFY(valid);
+    QCOMPARE(allocations, qint64(TICKS));
+}
+
+void MetricsProviderTest::testSensorDiscovery()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QString sys = root.path() + QStringLiteral("/sys");
+    QVERIFY(buildSysFixture(sys));
+
+    const Runtime::SensorMap map = Runtime::discoverSensors(sys);
+    QCOMPARE(map.cpuTemperature, QFile::encodeName(sys + "/class/hwmon/hwmon1/temp1_input"));
+    QCOMPARE(map.power, QFile::encodeName(sys + "/class/power_supply/BAT1/power_now"));
+    QCOMPARE(map.gpus.size(), 1);
+    QCOMPARE(map.primaryGpu, 0);
+
+    const Runtime::GpuSensors& gpu = map.gpus.first();
+    QCOMPARE(gpu.edgeTemperature, QFile::encodeName(sys + "/class/drm/card1/device/hwmon/hwmon2/temp1_input"));
+    QCOMPARE(gpu.junctionTemperature, QFile::encodeName(sys + "/class/drm/card1/device/hwmon/hwmon2/temp2_input"));
+    QCOMPARE(gpu.busy, QFile::encodeName(sys + "/class/drm/card1/device/gpu_busy_percent"));
+    QCOMPARE(gpu.power, QFile::encodeName(sys + "/class/drm/card1/device/hwmon/hwmon2/power1_average"));
+    QCOMPARE(gpu.card, QByteArray("card1"));
+    QCOMPARE(gpu.pciAddress, QByteArray("0000:04:00.0"));
+    QCOMPARE(gpu.driver, QByteArray("amdgpu"));
+}
+
+void MetricsProviderTest::testSensorDiscoveryThermalZoneFallback()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QString sys = root.path();
+    QVERIFY(writeFixture(sys, "class/thermal/thermal_zone0/type", "acpitz\n"));
+    QVERIFY(writeFixture(sys, "class/thermal/thermal_zone0/temp", "45000\n"));
+    QVERIFY(writeFixture(sys, "class/thermal/thermal_zone1/type", "x86_pkg_temp\n"));
+    QVERIFY(writeFixture(sys, "class/thermal/thermal_zone1/temp", "71000\n"));
+
+    const Runtime::SensorMap map = Runtime::discoverSensors(sys);
+    QCOMPARE(map.cpuTemperature, QFile::encodeName(sys + "/class/thermal/thermal_zone1/temp"));
+    QVERIFY(map.gpus.isEmpty());
+    QCOMPARE(map.primaryGpu, -1);
+    QVERIFY(map.power.isEmpty());
+}
+
+void MetricsProviderTest::testSensorDiscoveryMultipleGpus()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QString sys = root.path() + QStringLiteral("/sys");
+    QVERIFY(buildSysFixture(sys));
+    QVERIFY(addDiscreteGpu(sys));
+    // A card without a driver is not a GPU we can read.
+    QVERIFY(writeFixture(sys, "class/drm/card0/device/uevent", "PCI_SLOT_NAME=0000:00:08.0\n"));
+
+    const Runtime::SensorMap map = Runtime::discoverSensors(sys);
+    QCOMPARE(map.gpus.size(), 2);
+    QCOMPARE(map.primaryGpu, 0);
+    QCOMPARE(map.gpus[0].card, QByteArray("card1"));
+    QCOMPARE(map.gpus[1].card, QByteArray("card2"));
+    QCOMPARE(map.gpus[1].pciAddress, QByteArray("0000:03:00.0"));
+    QCOMPARE(map.gpus[1].busy, QFile::encodeName(sys + "/class/drm/card2/device/gpu_busy_percent"));
+    QCOMPARE(map.gpus[1].edgeTemperature, QFile::encodeName(sys + "/class/drm/card2/device/hwmon/hwmon3/temp1_input"));
+    QVERIFY(map.gpus[1].junctionTemperature.isEmpty());
+    QCOMPARE(map.gpus[1].power, QFile::encodeName(sys + "/class/drm/card2/device/hwmon/hwmon3/power1_average"));
+    // The battery still measures the whole system.
+    QCOMPARE(map.power, QFile::encodeName(sys + "/class/power_supply/BAT1/power_now"));
+}
+
+void MetricsProviderTest::testSensorDiscoveryPowerSource()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QString sys = root.path() + QStringLiteral("/sys");
+    QVERIFY(buildSysFixture(sys));
+    QVERIFY(!Runtime::readOnBattery(sys));
+
+    QVERIFY(writeFixture(sys, "class/power_supply/ACAD/online", "0\n"));
+    QVERIFY(writeFixture(sys, "class/power_supply/BAT1/status", "Discharging\n"));
+    QVERIFY(Runtime::readOnBattery(sys));
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = sys;
+    QVERIFY(Runtime::createSystemMetricsProvider(paths)->onBattery());
+
+    // A USB-C charger counts as AC.
+    QVERIFY(writeFixture(sys, "class/power_supply/ucsi-source-psy-USBC000:001/type", "USB\n"));
+    QVERIFY(writeFixture(sys, "class/power_supply/ucsi-source-psy-USBC000:001/online", "1\n"));
+    QVERIFY(!Runtime::readOnBattery(sys));
+
+    // Without an adapter in sysfs the battery status decides, and a
+    // gamepad's battery is not the machine's.
+    QTemporaryDir handheld;
+    QVERIFY(handheld.isValid());
+    const QString handheldSys = handheld.path();
+    QVERIFY(writeFixture(handheldSys, "class/power_supply/hid-gamepad-battery/type", "Battery\n"));
+    QVERIFY(writeFixture(handheldSys, "class/power_supply/hid-gamepad-battery/scope", "Device\n"));
+    QVERIFY(writeFixture(handheldSys, "class/power_supply/hid-gamepad-battery/status", "Discharging\n"));
+    QVERIFY(!Runtime::readOnBattery(handheldSys));
+    QVERIFY(writeFixture(handheldSys, "class/power_supply/BAT0/type", "Battery\n"));
+    QVERIFY(writeFixture(handheldSys, "class/power_supply/BAT0/status", "Full\n"));
+    QVERIFY(!Runtime::readOnBattery(handheldSys));
+    QVERIFY(writeFixture(handheldSys, "class/power_supply/BAT0/status", "Discharging\n"));
+    QVERIFY(Runtime::readOnBattery(handheldSys));
+}
+
+void MetricsProviderTest::testSensorUevents()
+{
+    auto classify = [](const QByteArray& message) {
+        Runtime::SensorChanges changes;
+        Runtime::addSensorUevent(message.constData(), message.size(), &changes);
+        return changes;
+    };
+
+    Runtime::SensorChanges changes = classify(uevent({"add@/devices/platform/nct6775.656/hwmon/hwmon4", "ACTION=add",
+                                                      "DEVPATH=/devices/platform/nct6775.656/hwmon/hwmon4",
+                                                      "SUBSYSTEM=hwmon", "SEQNUM=4711"}));
+    QVERIFY(changes.devices);
+    QVERIFY(!changes.powerSource);
+
+    // Thermal trips and battery updates leave the sensor map alone.
+    changes = classify(uevent({"change@/devices/virtual/thermal/thermal_zone0", "ACTION=change",
+                               "SUBSYSTEM=thermal", "SEQNUM=4712"}));
+    QVERIFY(!changes.devices);
+    QVERIFY(!changes.powerSource);
+    changes = classify(uevent({"change@/devices/LNXSYSTM:00/ACPI0003:00/power_supply/ACAD", "ACTION=change",
+                               "SUBSYSTEM=power_supply", "POWER_SUPPLY_ONLINE=0", "SEQNUM=4713"}));
+    QVERIFY(!changes.devices);
+    QVERIFY(changes.powerSource);
+
+    // A new charger is both.
+    changes = classify(uevent({"add@/devices/platform/USBC000:00/power_supply/ucsi-source-psy-USBC000:001",
+                               "ACTION=add", "SUBSYSTEM=power_supply", "SEQNUM=4714"}));
+    QVERIFY(changes.devices);
+    QVERIFY(changes.powerSource);
+
+    changes = classify(uevent({"add@/devices/pci0000:00/0000:00:14.0/usb3/3-1", "ACTION=add", "SUBSYSTEM=usb",
+                               "SEQNUM=4715"}));
+    QVERIFY(!changes.devices);
+    QVERIFY(!changes.powerSource);
+}
+
+void MetricsProviderTest::testProviderReadsFixtureTree()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    QVERIFY(buildProcFixture(paths.procRoot));
+    QVERIFY(buildSysFixture(paths.sysRoot));
+
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    const Runtime::ProcessMetrics metrics = provider->metricsForPid(4242);
+
+    QVERIFY(metrics.valid);
+    QCOMPARE(metrics.pid, 4242LL);
+    QCOMPARE(metrics.temperatureC, 61.5);
+    QCOMPARE(metrics.gpuTemperatureC, 55.0);
+    QCOMPARE(metrics.gpuPercent, 37.0);
+    QCOMPARE(metrics.powerWatts, 21.5);
+    QCOMPARE(metrics.ramMb, 1600.0);
+    QCOMPARE(metrics.ramPercent, 10.0);
+    QCOMPARE(metrics.pssMb, 1200.0);
+    QCOMPARE(metrics.pssPercent, 7.5);
+    QCOMPARE(metrics.ussMb, 1100.0);
+    QCOMPARE(metrics.swapMb, 200.0);
+
+    QVERIFY(!provider->metricsForPid(999).valid);
+}
+
+void MetricsProviderTest::testProviderSamplesRequestedFields()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    QVERIFY(buildProcFixture(paths.procRoot));
+    QVERIFY(buildSysFixture(paths.sysRoot));
+
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    const QVector<qint64> pids{4242, 999};
+
+    // The fast group skips RAM, GPU and sensor reads but still checks liveness.
+    const auto fast = provider->metricsForFields(
+        pids, Runtime::metricGroupFields(Runtime::metricGroupBit(Runtime::MetricGroup::Fast)));
+    QCOMPARE(fast.size(), 2);
+    QVERIFY(fast[0].valid);
+    QVERIFY(!fast[1].valid);
+    QCOMPARE(fast[0].ramMb, 0.0);
+    QCOMPARE(fast[0].gpuPercent, 0.0);
+    QCOMPARE(fast[0].temperatureC, 0.0);
+    QCOMPARE(fast[0].pssMb, 0.0);
+
+    // Individual sensors are read only when asked for.
+    const auto gpuTemperature = provider->metricsForFields(
+        pids, Runtime::metricFieldBit(Runtime::MetricField::GpuTemperatureC));
+    QVERIFY(gpuTemperature[0].valid);
+    QCOMPARE(gpuTemperature[0].gpuTemperatureC, 55.0);
+    QCOMPARE(gpuTemperature[0].temperatureC, 0.0);
+    QCOMPARE(gpuTemperature[0].powerWatts, 0.0);
+
+    const auto slow = provider->metricsForFields(
+        pids, Runtime::metricGroupFields(Runtime::metricGroupBit(Runtime::MetricGroup::Slow)));
+    QCOMPARE(slow[0].temperatureC, 61.5);
+    QCOMPARE(slow[0].powerWatts, 21.5);
+    QCOMPARE(slow[0].ramMb, 0.0);
+    // smaps_rollup is read at the slow rate.
+    QCOMPARE(slow[0].pssMb, 1200.0);
+    QCOMPARE(slow[0].swapMb, 200.0);
+
+    // Merging a partial sample leaves the other fields in place.
+    Runtime::ProcessMetrics merged;
+    merged.cpuPercent = 12.0;
+    merged.ramMb = 512.0;
+    merged.powerWatts = 9.0;
+    Runtime::mergeMetricFields(merged, slow[0], Runtime::metricFieldBit(Runtime::MetricField::TemperatureC));
+    QVERIFY(merged.valid);
+    QCOMPARE(merged.pid, 4242LL);
+    QCOMPARE(merged.cpuPercent, 12.0);
+    QCOMPARE(merged.ramMb, 512.0);
+    QCOMPARE(merged.powerWatts, 9.0);
+    QCOMPARE(merged.temperatureC, 61.5);
+}
+
+void MetricsProviderTest::testProviderBacksOffFailingSensor()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    QVERIFY(buildProcFixture(paths.procRoot));
+    QVERIFY(buildSysFixture(paths.sysRoot));
+
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    QCOMPARE(provider->metricsForPid(4242).temperatureC, 61.5);
+
+    // A failed read is not retried on the next sample, and the other sensors
+    // are still read.
+    QVERIFY(writeFixture(paths.sysRoot, "class/hwmon/hwmon1/temp1_input", "unavailable\n"));
+    QCOMPARE(provider->metricsForPid(4242).temperatureC, 0.0);
+    QVERIFY(writeFixture(paths.sysRoot, "class/hwmon/hwmon1/temp1_input", "62500\n"));
+    const Runtime::ProcessMetrics metrics = provider->metricsForPid(4242);
+    QCOMPARE(metrics.temperatureC, 0.0);
+    QCOMPARE(metrics.gpuTemperatureC, 55.0);
+    QCOMPARE(metrics.powerWatts, 21.5);
+}
+
+void MetricsProviderTest::testProviderReadsPressure()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    QVERIFY(buildProcFixture(paths.procRoot));
+    QVERIFY(addPressureFixture(paths.procRoot, paths.sysRoot));
+    // A second game left in the root cgroup.
+    QVERIFY(writeFixture(paths.procRoot, "4343/stat",
+                         "4343 (launcher) S 1 4343 4343 0 -1 0 0 0 0 0 10 5 0 0 20 0 4 0 1000 0 0\n"));
+    QVERIFY(writeFixture(paths.procRoot, "4343/cgroup", "0::/\n"));
+
+    Runtime::PressureFiles files;
+    QVERIFY(Runtime::pressureFilesForPid(4242, paths, &files));
+    QVERIFY(files.cgroup);
+    const QByteArray& ioPath = files.paths[static_cast<int>(Runtime::PressureResource::Io)];
+    QVERIFY(ioPath.endsWith("app-steam-4242.scope/io.pressure"));
+    QVERIFY(Runtime::pressureFilesForPid(4343, paths, &files));
+    QVERIFY(!files.cgroup);
+    QVERIFY(!Runtime::pressureFilesForPid(999, paths, &files));
+
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    const QVector<qint64> pids{4242, 4343};
+
+    // The first read only establishes the stall baseline.
+    auto metrics = provider->metricsForFields(pids, Runtime::PRESSURE_FIELDS);
+    QCOMPARE(metrics[0].cpuPressure, 4.2);
+    QCOMPARE(metrics[0].memoryPressure, 12.34);
+    QCOMPARE(metrics[0].ioPressure, 0.5);
+    QCOMPARE(metrics[0].memoryStallPercent, 0.0);
+    QCOMPARE(metrics[1].cpuPressure, 9.5);
+    QCOMPARE(metrics[1].ioPressure, 31.25);
+    QCOMPARE(metrics[0].ramMb, 0.0);
+
+    // An hour of stalls between two reads is capped at the elapsed time.
+    const QString scope = paths.sysRoot + QStringLiteral("/fs/cgroup") + QLatin1String(GAME_SCOPE);
+    QVERIFY(writeFixture(scope, "memory.pressure", pressureFile("avg10=55.00", 3600000000ull)));
+    metrics = provider->metricsForFields(pids, Runtime::PRESSURE_FIELDS);
+    QCOMPARE(metrics[0].memoryPressure, 55.0);
+    QCOMPARE(metrics[0].memoryStallPercent, 100.0);
+    QCOMPARE(metrics[0].cpuStallPercent, 0.0);
+    QCOMPARE(metrics[1].memoryStallPercent, 0.0);
+
+    // Outside the medium group the files are not read.
+    metrics = provider->metricsForFields(
+        pids, Runtime::metricGroupFields(Runtime::metricGroupBit(Runtime::MetricGroup::Fast)));
+    QVERIFY(metrics[0].valid);
+    QCOMPARE(metrics[0].memoryPressure, 0.0);
+    QCOMPARE(Runtime::metricGroupOf(Runtime::MetricField::IoStallPercent), Runtime::MetricGroup::Medium);
+}
+
+void MetricsProviderTest::testProviderAggregatesProcessTree()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    const QString& proc = paths.procRoot;
+    QVERIFY(buildProcFixture(proc));
+
+    // 4242 -> 4243 (wineserver-like) and 4244 (already exited); 4243 -> 4245,
+    // forked from a second thread.
+    const char childStat[] = "%1 (child) S 4242 4242 4242 0 -1 4194560 0 0 0 0 10 5 0 0 20 0 %2 0 1000 800000 5120\n";
+    QVERIFY(writeFixture(proc, "4242/task/4242/children", "4243 4244\n"));
+    QVERIFY(writeFixture(proc, "4243/stat", QString::fromLatin1(childStat).arg(4243).arg(2).toLatin1()));
+    QVERIFY(writeFixture(proc, "4243/statm", statmFixture(409600)));
+    QVERIFY(writeFixture(proc, "4243/smaps_rollup", "Rss:\t409600 kB\nPss:\t 204800 kB\nPrivate_Dirty:\t102400 kB\n"));
+    QVERIFY(writeFixture(proc, "4243/task/4243/children", ""));
+    QVERIFY(writeFixture(proc, "4243/task/4250/children", "4245\n"));
+    QVERIFY(writeFixture(proc, "4245/stat", QString::fromLatin1(childStat).arg(4245).arg(1).toLatin1()));
+    QVERIFY(writeFixture(proc, "4245/statm", statmFixture(102400)));
+    QVERIFY(writeFixture(proc, "4245/task/4245/children", ""));
+
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    QCOMPARE(provider->metricsForPid(4242).ramMb, 1600.0);
+
+    provider->setProcessTreeAggregation(true);
+    Runtime::ProcessMetrics metrics = provider->metricsForPid(4242);
+    QVERIFY(metrics.valid);
+    QCOMPARE(metrics.ramMb, 1600.0 + 400.0 + 100.0);
+    // PSS can be summed: shared pages are split between the members.
+    QCOMPARE(metrics.pssMb, 1200.0 + 200.0);
+    QCOMPARE(metrics.ussMb, 1100.0 + 100.0);
+
+    // A descendant exiting drops out on the next tick without a rescan. The
+    // cached descriptor keeps a deleted fixture readable, so an empty stat
+    // stands in for the failing read of a real /proc entry.
+    QVERIFY(writeFixture(proc, "4245/stat", ""));
+    QVERIFY(writeFixture(proc, "4243/task/4250/children", ""));
+    metrics = provider->metricsForPid(4242);
+    QCOMPARE(metrics.ramMb, 1600.0 + 400.0);
+
+    provider->setProcessTreeAggregation(false);
+    QCOMPARE(provider->metricsForPid(4242).ramMb, 1600.0);
+}
+
+void MetricsProviderTest::testThreadCpuSampler()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QString proc = root.path() + QStringLiteral("/proc");
+    const qint64 hz = sysconf(_SC_CLK_TCK);
+    constexpr quint64 SECOND_NS = 1'000'000'000;
+
+    auto writeThread = [&proc](qint64 tid, const char* name, qint64 ticks) {
+        const QString stat = QStringLiteral("%1 (%2) S 1 4242 4242 0 -1 4194560 0 0 0 0 %3 0 0 0 20 0 1 0 1000 0 0\n")
+                                 .arg(tid)
+                                 .arg(QLatin1String(name))
+                                 .arg(ticks);
+        return writeFixture(proc, QStringLiteral("4242/task/%1/stat").arg(tid), stat.toLatin1());
+    };
+    auto processStat = [](int threads) {
+        return QStringLiteral("4242 (Game) S 1 4242 4242 0 -1 4194560 0 0 0 0 0 0 0 0 20 0 %1 0 1000 0 0\n")
+            .arg(threads)
+            .toLatin1();
+    };
+
+    QVERIFY(writeThread(4242, "GameThread", 100));
+    QVERIFY(writeThread(4243, "RenderThread", 200));
+    QVERIFY(writeThread(4244, "AudioThread", 50));
+
+    Runtime::FileDescriptorCache files(QFile::encodeName(proc));
+    Runtime::ThreadCpuSampler sampler(4242, QFile::encodeName(proc));
+    QByteArray stat = processStat(3);
+    sampler.sample(stat.constData(), stat.size(), SECOND_NS, files);
+    QCOMPARE(sampler.threadCount(), 3);
+
+    // The first tick is only a baseline.
+    Runtime::ProcessMetrics metrics;
+    sampler.collectHottest(metrics);
+    QCOMPARE(metrics.hotThreadCount, 0);
+    QCOMPARE(metrics.threadCpuPercent, 0.0);
+
+    // One second later: the render thread saturated its core.
+    QVERIFY(writeThread(4242, "GameThread", 100 + hz / 2));
+    QVERIFY(writeThread(4243, "RenderThread", 200 + hz));
+    QVERIFY(writeThread(4244, "AudioThread", 50 + hz / 10));
+    sampler.sample(stat.constData(), stat.size(), 2 * SECOND_NS, files);
+    sampler.collectHottest(metrics);
+    QCOMPARE(metrics.hotThreadCount, 3);
+    QCOMPARE(metrics.threadCpuPercent, 100.0);
+    QCOMPARE(metrics.hotThreads[0].tid, 4243LL);
+    QCOMPARE(QByteArray(metrics.hotThreads[0].name), QByteArray("RenderThread"));
+    QCOMPARE(metrics.hotThreads[1].tid, 4242LL);
+    QVERIFY(qAbs(metrics.hotThreads[1].cpuPercent - 50.0) < 1.0);
+    QCOMPARE(metrics.hotThreads[2].tid, 4244LL);
+
+    // A new thread shows up with the thread count and starts from a baseline;
+    // the others keep theirs.
+    QVERIFY(writeThread(4245, "Worker", 7));
+    QVERIFY(writeThread(4243, "RenderThread", 200 + 2 * hz));
+    stat = processStat(4);
+    sampler.sample(stat.constData(), stat.size(), 3 * SECOND_NS, files);
+    QCOMPARE(sampler.threadCount(), 4);
+    QCOMPARE(sampler.threadAt(3), 4245LL);
+    metrics = Runtime::ProcessMetrics();
+    sampler.collectHottest(metrics);
+    QCOMPARE(metrics.hotThreadCount, 1);
+    QCOMPARE(metrics.hotThreads[0].tid, 4243LL);
+    QCOMPARE(metrics.threadCpuPercent, 100.0);
+
+    // A thread exiting is dropped on the next tick even if another one took
+    // its place. The cached descriptor keeps a deleted fixture readable, so an
+    // empty stat stands in for the failing read.
+    QVERIFY(writeFixture(proc, "4242/task/4244/stat", ""));
+    QVERIFY(QDir(proc + "/4242/task/4244").removeRecursively());
+    sampler.sample(stat.constData(), stat.size(), 4 * SECOND_NS, files);
+    QCOMPARE(sampler.threadCount(), 4);
+    sampler.sample(stat.constData(), stat.size(), 5 * SECOND_NS, files);
+    QCOMPARE(sampler.threadCount(), 3);
+    QCOMPARE(sampler.threadAt(2), 4245LL);
+
+    sampler.release(files);
+    QCOMPARE(sampler.threadCount(), 0);
+    QCOMPARE(files.openDescriptorCount(), 0);
+}
+
+void MetricsProviderTest::testGpuEngineSampler()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+    const QString proc = root.path() + QStringLiteral("/proc");
+    constexpr quint64 SECOND_NS = 1'000'000'000;
+
+    // fd 3 and its duplicate fd 4 are one amdgpu client, fd 6 an xe client
+    // and fd 5 a regular file.
+    QVERIFY(linkFixture(proc, "4242/fd/3", "/dev/dri/renderD128"));
+    QVERIFY(linkFixture(proc, "4242/fd/4", "/dev/dri/renderD128"));
+    QVERIFY(linkFixture(proc, "4242/fd/5", "/tmp/game.log"));
+    QVERIFY(linkFixture(proc, "4242/fd/6", "/dev/dri/renderD129"));
+    QVERIFY(writeFixture(proc, "4242/fdinfo/3", amdgpuFdinfo(7, 1000, 0)));
+    QVERIFY(writeFixture(proc, "4242/fdinfo/4", amdgpuFdinfo(7, 1000, 0)));
+    QVERIFY(writeFixture(proc, "4242/fdinfo/5", "pos:\t0\nflags:\t0100000\n"));
+    QVERIFY(writeFixture(proc, "4242/fdinfo/6", xeFdinfo(9, 0, 0, 0)));
+
+    Runtime::FileDescriptorCache files(QFile::encodeName(proc));
+    Runtime::GpuEngineSampler sampler(4242, QFile::encodeName(proc));
+
+    // The first tick is only a baseline.
+    Runtime::GpuEngineUsage usage;
+    usage.percent = -1.0;
+    QVERIFY(sampler.sample(SECOND_NS, files, &usage));
+    QCOMPARE(usage.percent, 0.0);
+    QCOMPARE(QByteArray(usage.device), QByteArray("0000:03:00.0"));
+    QCOMPARE(sampler.clientCount(), 2);
+    QCOMPARE(sampler.clientFdAt(0), 3);
+    QCOMPARE(sampler.clientFdAt(1), 6);
+
+    // One second later: gfx was busy 60% of the time, the xe render engine 30%
+    // and one of its two video engines fully.
+    QVERIFY(writeFixture(proc, "4242/fdinfo/3", amdgpuFdinfo(7, 1000 + 6 * SECOND_NS / 10, SECOND_NS / 10)));
+    QVERIFY(writeFixture(proc, "4242/fdinfo/6", xeFdinfo(9, 300, 1000, 1000)));
+    QVERIFY(sampler.sample(2 * SECOND_NS, files, &usage));
+    QCOMPARE(usage.percent, 60.0);
+    QCOMPARE(QByteArray(usage.device), QByteArray("0000:03:00.0"));
+    // The duplicated amdgpu client counts once, next to the xe client's system memory.
+    QCOMPARE(usage.vramMb, 1024.0);
+    QCOMPARE(usage.gttMb, 320.0);
+
+    // A closed descriptor is dropped; the listing then finds its duplicate,
+    // which starts from a new baseline.
+    QVERIFY(writeFixture(proc, "4242/fdinfo/3", ""));
+    QVERIFY(QFile::remove(proc + "/4242/fd/3"));
+    QVERIFY(writeFixture(proc, "4242/fdinfo/6", xeFdinfo(9, 1000, 1000, 2000)));
+    QVERIFY(sampler.sample(3 * SECOND_NS, files, &usage));
+    QCOMPARE(usage.percent, 70.0);
+    QCOMPARE(QByteArray(usage.device), QByteArray("0000:00:02.0"));
+    QVERIFY(writeFixture(proc, "4242/fdinfo/4", amdgpuFdinfo(7, SECOND_NS, 0)));
+    QVERIFY(sampler.sample(4 * SECOND_NS, files, &usage));
+    QCOMPARE(sampler.clientCount(), 2);
+    QCOMPARE(sampler.clientFdAt(0), 4);
+    // Idle: the process stays on the device it last used.
+    QCOMPARE(usage.percent, 0.0);
+    QCOMPARE(QByteArray(usage.device), QByteArray("0000:00:02.0"));
+
+    sampler.release(files);
+    QCOMPARE(sampler.clientCount(), 0);
+    QCOMPARE(files.openDescriptorCount(), 0);
+
+    // A process without DRM clients leaves the provider on the device-wide load.
+    QVERIFY(!Runtime::GpuEngineSampler(999, QFile::encodeName(proc)).sample(SECOND_NS, files, &usage));
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = proc;
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    QVERIFY(buildProcFixture(paths.procRoot));
+    QVERIFY(buildSysFixture(paths.sysRoot));
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    QCOMPARE(provider->metricsForPid(4242).gpuPercent, 0.0);
+    QVERIFY(QDir(proc + "/4242/fd").removeRecursively());
+    provider->releasePid(4242);
+    QCOMPARE(provider->metricsForPid(4242).gpuPercent, 37.0);
+}
+
+void MetricsProviderTest::testProviderMapsGameToItsGpu()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    const QString& proc = paths.procRoot;
+    QVERIFY(buildProcFixture(proc));
+    QVERIFY(buildSysFixture(paths.sysRoot));
+    QVERIFY(addDiscreteGpu(paths.sysRoot));
+
+    // 4242 renders on the discrete GPU; 4250 has no DRM client.
+    QVERIFY(linkFixture(proc, "4242/fd/3", "/dev/dri/renderD129"));
+    QVERIFY(writeFixture(proc, "4242/fdinfo/3", amdgpuFdinfo(7, 0, 0)));
+    QVERIFY(writeFixture(proc, "4250/stat", "4250 (tool) S 1 4250 4250 0 -1 4194560 0 0 0 0 1 1 0 0 20 0 1 0 1000 0 0\n"));
+
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    const QVector<qint64> pids{4242, 4250};
+    const auto metrics = provider->metricsForPids(pids);
+    QCOMPARE(QByteArray(metrics[0].gpuDevice), QByteArray("0000:03:00.0"));
+    QCOMPARE(metrics[0].gpuBusyPercent, 88.0);
+    QCOMPARE(metrics[0].gpuTemperatureC, 71.0);
+    QCOMPARE(metrics[0].gpuPowerWatts, 120.0);
+    // Its own usage, not the device's: the first tick is only a baseline.
+    QCOMPARE(metrics[0].gpuPercent, 0.0);
+    QCOMPARE(metrics[0].powerWatts, 21.5);
+    QCOMPARE(metrics[0].vramMb, 1024.0);
+    QCOMPARE(metrics[0].gttMb, 64.0);
+
+    // Without a client of its own a process is reported on the primary GPU.
+    QCOMPARE(QByteArray(metrics[1].gpuDevice), QByteArray("0000:04:00.0"));
+    QCOMPARE(metrics[1].gpuBusyPercent, 37.0);
+    QCOMPARE(metrics[1].gpuPercent, 37.0);
+    QCOMPARE(metrics[1].gpuTemperatureC, 55.0);
+    QCOMPARE(metrics[1].gpuPowerWatts, 15.0);
+    QCOMPARE(metrics[1].vramMb, 0.0);
+
+    // Slow ticks read the sensors of the device found on the last usage tick.
+    const auto slow = provider->metricsForFields(pids, Runtime::metricFieldBit(Runtime::MetricField::GpuTemperatureC));
+    QCOMPARE(QByteArray(slow[0].gpuDevice), QByteArray("0000:03:00.0"));
+    QCOMPARE(slow[0].gpuTemperatureC, 71.0);
+    QCOMPARE(slow[1].gpuTemperatureC, 55.0);
+}
+
+void MetricsProviderTest::testFrameTimingRing()
+{
+    const QByteArray name = frameChannelPrefix("ring") + "-1";
+    Runtime::FrameTimingWriter writer;
+    QVERIFY(writer.create(name.constData(), 5));
+
+    Runtime::FrameTimingReader reader;
+    QVERIFY(reader.open(name.constData()));
+
+    // Capacity rounds up to 8; the last two frames do not fit.
+    int pushed = 0;
+    for (quint64 i = 0; i < 10; ++i) {
+        pushed += writer.push(100 + i) ? 1 : 0;
+    }
+    QCOMPARE(pushed, 8);
+    QCOMPARE(reader.droppedFrames(), uint64_t(2));
+
+    uint64_t out[16];
+    QCOMPARE(reader.drain(out, 3), 3);
+    QCOMPARE(out[0], uint64_t(100));
+    QCOMPARE(out[2], uint64_t(102));
+
+    // Draining frees slots, so the producer can wrap around.
+    QVERIFY(writer.push(200));
+    QCOMPARE(reader.drain(out, 16), 6);
+    QCOMPARE(out[4], uint64_t(107));
+    QCOMPARE(out[5], uint64_t(200));
+    QCOMPARE(reader.drain(out, 16), 0);
+
+    // A producer that rewrites the header after open() cannot make the reader
+    // index past the slots it validated.
+    const int fd = ::shm_open(name.constData(), O_RDWR | O_CLOEXEC, 0);
+    QVERIFY(fd >= 0);
+    void* mapping = ::mmap(nullptr, sizeof(Runtime::FrameTimingHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    QVERIFY(mapping != MAP_FAILED);
+    auto* header = static_cast<Runtime::FrameTimingHeader*>(mapping);
+    header->capacity = 1u << 30;
+    header->readIndex.store(1ull << 29);
+    header->writeIndex.store((1ull << 29) + 4);
+    QCOMPARE(reader.drain(out, 16), 4);
+    ::munmap(mapping, sizeof(Runtime::FrameTimingHeader));
+
+    writer.close();
+    Runtime::FrameTimingReader late;
+    QVERIFY(!late.open(name.constData()));
+}
+
+void MetricsProviderTest::testProviderReadsFrameTiming()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    paths.frameChannelPrefix = QString::fromLatin1(frameChannelPrefix("provider"));
+    QVERIFY(buildProcFixture(paths.procRoot));
+
+    const QByteArray name = frameChannelPrefix("provider") + "-4242";
+    Runtime::FrameTimingWriter writer;
+    QVERIFY(writer.create(name.constData()));
+
+    // 61 presents 1/60 s apart are 60 frame intervals over one second, with
+    // one 50 ms hitch in the middle.
+    const quint64 frameNs = 1'000'000'000ull / 60;
+    quint64 present = monotonicNowNs() - 2'000'000'000ull;
+    for (int i = 0; i <= 60; ++i) {
+        present += (i == 30) ? 50'000'000ull : frameNs;
+        QVERIFY(writer.push(present));
+    }
+
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    const Runtime::ProcessMetrics metrics = provider->metricsForPid(4242);
+    QVERIFY(metrics.valid);
+    const double spanMs = (59 * frameNs + 50'000'000ull) / 1e6;
+    QVERIFY(qAbs(metrics.fps - 60 * 1000.0 / spanMs) < 0.01);
+    QVERIFY(qAbs(metrics.frameTimeMs - spanMs / 60) < 0.01);
+    QVERIFY(qAbs(metrics.frameTimeMaxMs - 50.0) < 0.01);
+
+    // Without a channel the FPS is unknown rather than a made-up default.
+    Runtime::SystemPaths noChannel = paths;
+    noChannel.frameChannelPrefix = QString::fromLatin1(frameChannelPrefix("missing"));
+    QCOMPARE(Runtime::createSystemMetricsProvider(noChannel)->metricsForPid(4242).fps, 0.0);
+}
+
+void MetricsProviderTest::testProviderReportsStalledFrames()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    paths.frameChannelPrefix = QString::fromLatin1(frameChannelPrefix("stalled"));
+    QVERIFY(buildProcFixture(paths.procRoot));
+
+    const QByteArray name = frameChannelPrefix("stalled") + "-4242";
+    Runtime::FrameTimingWriter writer;
+    QVERIFY(writer.create(name.constData()));
+    QVERIFY(writer.push(monotonicNowNs() - 2'000'000'000ull));
+
+    // A single present two seconds ago and nothing since.
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    const Runtime::ProcessMetrics metrics = provider->metricsForPid(4242);
+    QVERIFY(metrics.fps > 0.0);
+    QVERIFY(metrics.fps < 1.0);
+    QVERIFY(metrics.frameTimeMaxMs >= 2000.0);
+}
+
+void MetricsProviderTest::testProviderFollowsReplacedFrameChannel()
+{
+    QTemporaryDir root;
+    QVERIFY(root.isValid());
+
+    Runtime::SystemPaths paths;
+    paths.procRoot = root.path() + QStringLiteral("/proc");
+    paths.sysRoot = root.path() + QStringLiteral("/sys");
+    paths.frameChannelPrefix = QString::fromLatin1(frameChannelPrefix("restarted"));
+    QVERIFY(buildProcFixture(paths.procRoot));
+
+    const QByteArray name = frameChannelPrefix("restarted") + "-4242";
+    const quint64 frameNs = 1'000'000'000ull / 60;
+    // One second of 60 fps presents ending at endNs.
+    auto pushSecond = [frameNs](Runtime::FrameTimingWriter& writer, quint64 endNs) {
+        bool pushed = true;
+        for (int i = 60; i >= 0; --i) {
+            pushed = writer.push(endNs - i * frameNs) && pushed;
+        }
+        return pushed;
+    };
+
+    Runtime::FrameTimingWriter writer;
+    QVERIFY(writer.create(name.constData()));
+    QVERIFY(pushSecond(writer, monotonicNowNs() - 2'000'000'000ull));
+    auto provider = Runtime::createSystemMetricsProvider(paths);
+    QVERIFY(qAbs(provider->metricsForPid(4242).fps - 60.0) < 0.01);
+
+    // The hook restarts: it unlinks its segment and creates a new one under
+    // the same name. The old mapping would report a two-second stall.
+    writer.close();
+    Runtime::FrameTimingWriter restarted;
+    QVERIFY(restarted.create(name.constData()));
+    QVERIFY(pushSecond(restarted, monotonicNowNs()));
+    const Runtime::ProcessMetrics metrics = provider->metricsForPid(4242);
+    QVERIFY(qAbs(metrics.fps - 60.0) < 0.01);
+    QVERIFY(metrics.frameTimeMaxMs < 20.0);
+}
+
+QTEST_GUILESS_MAIN(MetricsProviderTest)
+#include "MetricsProviderTest.moc"
@@ -1,12 +1,39 @@
 #include "runtime/RunningManager.hpp"
+#include "runtime/AlertRules.hpp"
+#include "runtime/FlightRecorder.hpp"
+#include "runtime/MetricDistribution.hpp"
+#include "runtime/MetricHistory.hpp"
+#include "runtime/ProcessExitWatcher.hpp"
 #include "runtime/ProcessMetricsProvider.hpp"
+#include "runtime/ReplayMetricsProvider.hpp"
+#include "runtime/SamplingScheduler.hpp"
 
+#include <QAbstractItemModelTester>
+#include <QFile>
+#include <QProcess>
 #include <QSignalSpy>
+#include <QTcpSocket>
+#include <QTemporaryDir>
 #include <QTest>
 #include <QVariantList>
 #include <QVariantMap>
 #include <memory>
 
+QByteArray scrapeExporter(int port, const QByteArray& path)
+{
+    QTcpSocket socket;
+    socket.connectToHost(QHostAddress::LocalHost, static_cast<quint16>(port));
+    if (!socket.waitForConnected(5000)) {
+        return QByteArray();
+    }
+    socket.write("GET " + path + " HTTP/1.1\r\nHost: localhost\r\n\r\n");
+    QByteArray response;
+    while (socket.state() != QAbstractSocket::UnconnectedState && socket.waitForReadyRead(5000)) {
+        response += socket.readAll();
+    }
+    return response + socket.readAll();
+}
+
 class MockMetricsProvider : public Runtime::ProcessMetricsProvider {
 public:
     MockMetricsProvider() = default;
@@ -31,10 +58,51 @@ public:
         m_metrics.remove(pid);
     }
 
+    QVector<Runtime::ProcessMetrics> metricsForFields(const QVector<qint64>& pids,
+                                                      const QVector<Runtime::MetricFieldMask>& fields) override
+    {
+        Runtime::MetricFieldMask requested = 0;
+        for (int i = 0; i < pids.size(); ++i) {
+            requested |= fields[i];
+            requestedPidFields[pids[i]] = fields[i];
+        }
+        requestedFields.append(requested);
+        return metricsForPids(pids);
+    }
+    using Runtime::ProcessMetricsProvider::metricsForFields;
+
+    void releasePid(qint64 pid) override
+    {
+        releasedPids.append(pid);
+    }
+
+    bool onBattery() const override
+    {
+        return battery;
+    }
+
+    QVector<qint64> releasedPids;
+    QVector<Runtime::MetricFieldMask> requestedFields;
+    QHash<qint64, Runtime::MetricFieldMask> requestedPidFields;
+    bool battery = false;
+
 private:
     QHash<qint64, Runtime::ProcessMetrics> m_metrics;
 };
 
+class BatchMetricsProvider : public MockMetricsProvider {
+public:
+    QVector<Runtime::ProcessMetrics> metricsForPids(const QVector<qint64>& pids) override
+    {
+        ++batchCalls;
+        lastBatchSize = pids.size();
+        return MockMetricsProvider::metricsForPids(pids);
+    }
+
+    int batchCalls = 0;
+    int lastBatchSize = 0;
+};
+
 class RunningManagerTest : public QObject {
     Q_OBJECT
 
@@ -51,16 +119,45 @@ private slots:
     void testAlerts_HighCpu();
     void testAlerts_HighMemory();
     void testAlerts_LowFps();
+    void testAlerts_SaturatedThread();
+    void testAlerts_Swapping();
+    void testAlerts_MemoryStall();
     void testSuspendResume_Supported();
     void testSuspendResume_Unsupported();
     void testForceQuit();
     void testMultipleGames();
     void testAlertThresholds();
     void testMetricsInvalidProcess();
+    void testThreadedSampling();
+    void testBatchedSampling();
+    void testReleasePidOnExit();
+    void testGamesModelIncrementalUpdates();
+    void testAlertsModel();
+    void testMetricHistoryRingBuffer();
+    void testHistoryStats();
+    void testMetricDistributionQuantiles();
+    void testMetricSummary();
+    void testExitDetectedWithoutSampling();
+    void testLivenessTickWithoutPidfd();
+    void testSamplingScheduler();
+    void testSchedulerLowPowerAndBurst();
+    void testMetricSubscriptions();
+    void testAlertEngineBatch();
+    void testAlertHysteresis();
+    void testAlertDebounce();
+    void testCoalescedTickNotification();
+    void testFlightRecorderRing();
+    void testFlightRecorderDivergentGames();
+    void testFlightRecorderSession();
+    void testReplayProviderClock();
+    void testReplayDrivesManager();
+    void testMetricsExporter();
+    void testMetricsExporterSubscription();
 
 private:
     std::shared_ptr<MockMetricsProvider> m_mockProvider;
     std::unique_ptr<Runtime::RunningManager> m_manager;
+    int m_allMetricsSubscription = 0;
 };
 
 void RunningManagerTest::initTestCase()
@@ -75,6 +172,8 @@ void RunningManagerTest::init()
 {
     m_mockProvider = std::make_shared<MockMetricsProvider>();
     m_manager = std::make_unique<Runtime::RunningManager>(m_mockProvider);
+    // Most tests check metrics no alert reads.
+    m_allMetricsSubscription = m_manager->subscribeAll();
 }
 
 void RunningManagerTest::cleanup()
@@ -164,11 +263,12 @@ void RunningManagerTest::testAlerts_HighTemperature()
 
     bool foundTempAlert = false;
     for (int i = 0; i < alertSpy.count(); ++i) {
-        QVariantMap alert = alertSpy.at(i).at(1).toMap();
-        if (alert.value("type").toString() == "temperature") {
+        const auto alert = alertSpy.at(i).at(1).value<Runtime::AlertInfo>();
+        if (alert.type == "temperature") {
             foundTempAlert = true;
-            QCOMPARE(alert.value("severity").toString(), QString("critical"));
-            QVERIFY(alert.value("message").toString().contains("overheating"));
+            QCOMPARE(alert.severity, QString("critical"));
+            QVERIFY(alert.message.contains("overheating"));
+            QVERIFY(alert.raisedAtMs > 0);
             break;
         }
     }
@@ -198,10 +298,10 @@ void RunningManagerTest::testAlerts_HighCpu()
 
     bool foundCpuAlert = false;
     for (int i = 0; i < alertSpy.count(); ++i) {
-        QVariantMap alert = alertSpy.at(i).at(1).toMap();
-        if (alert.value("type").toString() == "cpu") {
+        const auto alert = alertSpy.at(i).at(1).value<Runtime::AlertInfo>();
+        if (alert.type == "cpu") {
             foundCpuAlert = true;
-            QCOMPARE(alert.value("severity").toString(), QString("warning"));
+            QCOMPARE(alert.severity, QString("warning"));
             break;
         }
     }
@@ -232,10 +332,10 @@ void RunningManagerTest::testAlerts_HighMemory()
 
     bool foundMemAlert = false;
     for (int i = 0; i < alertSpy.count(); ++i) {
-        QVariantMap alert = alertSpy.at(i).at(1).toMap();
-        if (alert.value("type").toString() == "memory") {
+        const auto alert = alertSpy.at(i).at(1).value<Runtime::AlertInfo>();
+        if (alert.type == "memory") {
             foundMemAlert = true;
-            QCOMPARE(alert.value("severity").toString(), QString("warning"));
+            QCOMPARE(alert.severity, QString("warning"));
             break;
         }
     }
@@ -265,16 +365,113 @@ void RunningManagerTest::testAlerts_LowFps()
 
     bool foundFpsAlert = false;
     for (int i = 0; i < alertSpy.count(); ++i) {
-        QVariantMap alert = alertSpy.at(i).at(1).toMap();
-        if (alert.value("type").toString() == "fps") {
+        const auto alert = alertSpy.at(i).at(1).value<Runtime::AlertInfo>();
+        if (alert.type == "fps") {
             foundFpsAlert = true;
-            QCOMPARE(alert.value("severity").toString(), QString("warning"));
+            QCOMPARE(alert.severity, QString("warning"));
             break;
         }
     }
     QVERIFY(foundFpsAlert);
 }
 
+void RunningManagerTest::testAlerts_SaturatedThread()
+{
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.cpuPercent = 30.0;
+    metrics.threadCpuPercent = 100.0;
+    metrics.hotThreadCount = 2;
+    metrics.hotThreads[0].tid = 12350;
+    metrics.hotThreads[0].cpuPercent = 100.0;
+    qstrncpy(metrics.hotThreads[0].name, "RenderThread", sizeof(metrics.hotThreads[0].name));
+    metrics.hotThreads[1].tid = 12345;
+    metrics.hotThreads[1].cpuPercent = 40.0;
+    qstrncpy(metrics.hotThreads[1].name, "GameThread", sizeof(metrics.hotThreads[1].name));
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+
+    QSignalSpy alertSpy(m_manager.get(), &Runtime::RunningManager::alertRaised);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->refreshNow();
+
+    // One saturated thread alerts even though the process as a whole is at 30%.
+    QCOMPARE(alertSpy.count(), 1);
+    const auto alert = alertSpy.first().at(1).value<Runtime::AlertInfo>();
+    QCOMPARE(alert.type, QString("cpuThread"));
+    QCOMPARE(alert.severity, QString("warning"));
+    QVERIFY(alert.message.contains("RenderThread"));
+
+    const QVariantList threads = m_manager->hotThreads("game1");
+    QCOMPARE(threads.size(), 2);
+    QCOMPARE(threads.first().toMap().value("name").toString(), QString("RenderThread"));
+    QCOMPARE(threads.first().toMap().value("tid").toLongLong(), 12350LL);
+    QCOMPARE(threads.last().toMap().value("cpuPercent").toDouble(), 40.0);
+    QCOMPARE(m_manager->games().first().toMap().value("metrics").toMap().value("threadCpuPercent").toDouble(), 100.0);
+}
+
+void RunningManagerTest::testAlerts_Swapping()
+{
+    // RSS looks harmless, but a third of the game's share is in swap.
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.ramMb = 4096.0;
+    metrics.ramPercent = 25.0;
+    metrics.pssMb = 6144.0;
+    metrics.pssPercent = 37.5;
+    metrics.swapMb = 3072.0;
+    metrics.vramMb = 2048.0;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+
+    QSignalSpy alertSpy(m_manager.get(), &Runtime::RunningManager::alertRaised);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->refreshNow();
+
+    QCOMPARE(alertSpy.count(), 1);
+    const auto alert = alertSpy.first().at(1).value<Runtime::AlertInfo>();
+    QCOMPARE(alert.type, QString("swap"));
+    QCOMPARE(alert.severity, QString("critical"));
+    QCOMPARE(alert.value, 3072.0);
+
+    const QVariantMap serialized = m_manager->games().first().toMap().value("metrics").toMap();
+    QCOMPARE(serialized.value("pssMb").toDouble(), 6144.0);
+    QCOMPARE(serialized.value("vramMb").toDouble(), 2048.0);
+}
+
+void RunningManagerTest::testAlerts_MemoryStall()
+{
+    // The game thrashes: its tasks wait on reclaim for almost half of the
+    // time while the 10 s average is still catching up. Some IO stall is
+    // expected while it pages back in.
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.cpuPercent = 40.0;
+    metrics.memoryPressure = 18.0;
+    metrics.memoryStallPercent = 45.0;
+    metrics.ioPressure = 4.0;
+    metrics.ioStallPercent = 7.0;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+
+    QSignalSpy alertSpy(m_manager.get(), &Runtime::RunningManager::alertRaised);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->refreshNow();
+
+    QCOMPARE(alertSpy.count(), 1);
+    const auto alert = alertSpy.first().at(1).value<Runtime::AlertInfo>();
+    QCOMPARE(alert.type, QString("memoryStall"));
+    QCOMPARE(alert.severity, QString("critical"));
+    QCOMPARE(alert.value, 45.0);
+
+    const QVariantMap serialized = m_manager->games().first().toMap().value("metrics").toMap();
+    QCOMPARE(serialized.value("memoryPressure").toDouble(), 18.0);
+    QCOMPARE(serialized.value("ioStallPercent").toDouble(), 7.0);
+}
+
 void RunningManagerTest::testSuspendResume_Supported()
 {
     Runtime::ProcessMetrics metrics;
@@ -312,9 +509,9 @@ void RunningManagerTest::testSuspendResume_Unsupported()
     m_manager->suspendGame("game1");
 
     QCOMPARE(alertSpy.count(), 1);
-    QVariantMap alert = alertSpy.at(0).at(1).toMap();
-    QCOMPARE(alert.value("type").toString(), QString("suspendUnsupported"));
-    QVERIFY(alert.value("message").toString().contains("Wine"));
+    const auto alert = alertSpy.at(0).at(1).value<Runtime::AlertInfo>();
+    QCOMPARE(alert.type, QString("suspendUnsupported"));
+    QVERIFY(alert.message.contains("Wine"));
 }
 
 void RunningManagerTest::testForceQuit()
@@ -401,5 +598,1029 @@ void RunningManagerTest::testMetricsInvalidProcess()
     QCOMPARE(m_manager->games().size(), 0);
 }
 
+void RunningManagerTest::testThreadedSampling()
+{
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.cpuPercent = 42.0;
+    metrics.temperatureC = 88.0;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+
+    // Keep the periodic timer out of the way so only refreshNow() samples.
+    m_manager->setUpdateIntervalMs(60000);
+    m_manager->setThreadedSampling(true);
+    QVERIFY(m_manager->threadedSampling());
+
+    QSignalSpy alertSpy(m_manager.get(), &Runtime::RunningManager::alertRaised);
+
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->refreshNow();
+
+    QTRY_COMPARE(m_manager->metricsFor("game1").cpuPercent, 42.0);
+    QVERIFY(alertSpy.count() > 0);
+
+    m_mockProvider->clearMetrics(12345);
+    QSignalSpy closedSpy(m_manager.get(), &Runtime::RunningManager::gameClosed);
+    m_manager->refreshNow();
+
+    QTRY_COMPARE(closedSpy.count(), 1);
+    QCOMPARE(m_manager->games().size(), 0);
+
+    // A provider swapped in threaded mode is handed to the sampler thread.
+    auto provider = std::make_shared<BatchMetricsProvider>();
+    provider->setMetrics(12345, metrics);
+    m_manager->setMetricsProvider(provider);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->refreshNow();
+    QTRY_VERIFY(provider->batchCalls > 0);
+    QTRY_COMPARE(m_manager->metricsFor("game1").cpuPercent, 42.0);
+
+    m_manager->setThreadedSampling(false);
+    QVERIFY(!m_manager->threadedSampling());
+}
+
+void RunningManagerTest::testBatchedSampling()
+{
+    auto provider = std::make_shared<BatchMetricsProvider>();
+    m_manager->setMetricsProvider(provider);
+
+    Runtime::ProcessMetrics metrics1;
+    metrics1.pid = 12345;
+    metrics1.cpuPercent = 10.0;
+    metrics1.valid = true;
+    provider->setMetrics(12345, metrics1);
+
+    Runtime::ProcessMetrics metrics2;
+    metrics2.pid = 67890;
+    metrics2.cpuPercent = 20.0;
+    metrics2.valid = true;
+    provider->setMetrics(67890, metrics2);
+
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->registerGame("game2", "Test Game 2", 67890, true, "");
+    m_manager->refreshNow();
+
+    QCOMPARE(provider->batchCalls, 1);
+    QCOMPARE(provider->lastBatchSize, 2);
+    QCOMPARE(m_manager->metricsFor("game1").cpuPercent, 10.0);
+    QCOMPARE(m_manager->metricsFor("game2").cpuPercent, 20.0);
+
+    m_manager->suspendGame("game2");
+    m_manager->refreshNow();
+
+    QCOMPARE(provider->batchCalls, 2);
+    QCOMPARE(provider->lastBatchSize, 1);
+}
+
+void RunningManagerTest::testReleasePidOnExit()
+{
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->registerGame("game1", "Test Game 1", 12346, true, "");
+    QCOMPARE(m_mockProvider->releasedPids, QVector<qint64>({12345}));
+
+    m_manager->markGameExited("game1");
+    QCOMPARE(m_mockProvider->releasedPids, QVector<qint64>({12345, 12346}));
+}
+
+void RunningManagerTest::testGamesModelIncrementalUpdates()
+{
+    Runtime::RunningGamesModel* model = m_manager->gamesModel();
+    QAbstractItemModelTester tester(model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+    QSignalSpy insertedSpy(model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removedSpy(model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy changedSpy(model, &QAbstractItemModel::dataChanged);
+    QSignalSpy resetSpy(model, &QAbstractItemModel::modelReset);
+
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.cpuPercent = 30.0;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    QCOMPARE(insertedSpy.count(), 1);
+    QCOMPARE(model->count(), 1);
+    QCOMPARE(model->index(0).data(Runtime::RunningGamesModel::TitleIdRole).toString(), QString("game1"));
+    QCOMPARE(model->index(0).data(Runtime::RunningGamesModel::StateRole).toString(), QString("running"));
+
+    m_manager->refreshNow();
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(model->index(0).data(Runtime::RunningGamesModel::CpuPercentRole).toDouble(), 30.0);
+
+    // Identical samples must not touch the delegates at all.
+    changedSpy.clear();
+    m_manager->refreshNow();
+    QCOMPARE(changedSpy.count(), 0);
+
+    metrics.fps = 45.0;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->refreshNow();
+    QCOMPARE(changedSpy.count(), 1);
+    const QList<int> roles = changedSpy.at(0).at(2).value<QList<int>>();
+    QCOMPARE(roles, QList<int>({Runtime::RunningGamesModel::FpsRole, Runtime::RunningGamesModel::MetricsRole}));
+    const auto rowMetrics = model->index(0).data(Runtime::RunningGamesModel::MetricsRole).value<Runtime::ProcessMetrics>();
+    QCOMPARE(rowMetrics.fps, 45.0);
+    QVERIFY(rowMetrics.sampledAtMs > 0);
+
+    m_manager->markGameExited("game1");
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(model->count(), 0);
+    QCOMPARE(resetSpy.count(), 0);
+}
+
+void RunningManagerTest::testAlertsModel()
+{
+    Runtime::ActiveAlertsModel* model = m_manager->alertsModel();
+    QAbstractItemModelTester tester(model, QAbstractItemModelTester::FailureReportingMode::QtTest);
+
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.temperatureC = 90.0;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->refreshNow();
+
+    QCOMPARE(model->count(), 1);
+    const QModelIndex alert = model->index(0);
+    QCOMPARE(alert.data(Runtime::ActiveAlertsModel::TypeRole).toString(), QString("temperature"));
+    QCOMPARE(alert.data(Runtime::ActiveAlertsModel::SeverityRole).toString(), QString("critical"));
+    QCOMPARE(alert.data(Runtime::ActiveAlertsModel::TitleIdRole).toString(), QString("game1"));
+
+    QSignalSpy removedSpy(model, &QAbstractItemModel::rowsRemoved);
+    metrics.temperatureC = 60.0;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->refreshNow();
+
+    QCOMPARE(removedSpy.count(), 1);
+    QCOMPARE(model->count(), 0);
+
+    metrics.temperatureC = 90.0;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->refreshNow();
+    QCOMPARE(model->count(), 1);
+
+    // The alerts of a game re-registered with a new PID belonged to the old
+    // process.
+    QSignalSpy clearedSpy(m_manager.get(), &Runtime::RunningManager::alertCleared);
+    QSignalSpy committedSpy(m_manager.get(), &Runtime::RunningManager::changesCommitted);
+    m_manager->registerGame("game1", "Test Game 1", 23456, true, "");
+    QCOMPARE(model->count(), 0);
+    QVERIFY(m_manager->alerts().isEmpty());
+    QCOMPARE(clearedSpy.count(), 1);
+    QCOMPARE(committedSpy.last().at(0).toMap().value("cleared").toList().size(), 1);
+
+    metrics.pid = 23456;
+    m_mockProvider->setMetrics(23456, metrics);
+    m_manager->refreshNow();
+    QCOMPARE(model->count(), 1);
+
+    m_manager->markGameExited("game1");
+    QCOMPARE(model->count(), 0);
+}
+
+void RunningManagerTest::testMetricHistoryRingBuffer()
+{
+    Runtime::MetricHistory history(4);
+    QCOMPARE(history.capacity(), 4);
+    QCOMPARE(history.stats(Runtime::MetricField::CpuPercent).count, 0);
+
+    for (int i = 1; i <= 6; ++i) {
+        Runtime::ProcessMetrics metrics;
+        metrics.cpuPercent = i * 10.0;
+        metrics.fps = 100.0 - i;
+        history.append(metrics, i * 1000);
+    }
+
+    // Capacity 4 keeps samples 3..6, newest first by age.
+    QCOMPARE(history.size(), 4);
+    QCOMPARE(history.valueAt(Runtime::MetricField::CpuPercent, 0), 60.0);
+    QCOMPARE(history.valueAt(Runtime::MetricField::CpuPercent, 3), 30.0);
+    QCOMPARE(history.valueAt(Runtime::MetricField::CpuPercent, 4), 0.0);
+    QCOMPARE(history.timestampAt(0), 6000LL);
+
+    const auto all = history.stats(Runtime::MetricField::CpuPercent);
+    QCOMPARE(all.count, 4);
+    QCOMPARE(all.min, 30.0);
+    QCOMPARE(all.max, 60.0);
+    QCOMPARE(all.mean, 45.0);
+    QVERIFY(qAbs(all.stddev - 11.180339887) < 1e-6);
+
+    const auto recent = history.stats(Runtime::MetricField::Fps, 2);
+    QCOMPARE(recent.count, 2);
+    QCOMPARE(recent.min, 94.0);
+    QCOMPARE(recent.max, 95.0);
+    QCOMPARE(recent.mean, 94.5);
+}
+
+void RunningManagerTest::testHistoryStats()
+{
+    m_manager->setHistoryCapacity(3);
+
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    for (double cpu : {10.0, 20.0, 30.0, 40.0}) {
+        metrics.cpuPercent = cpu;
+        m_mockProvider->setMetrics(12345, metrics);
+        m_manager->refreshNow();
+    }
+
+    QCOMPARE(m_manager->historySize("game1"), 3);
+    QCOMPARE(m_manager->historyValue("game1", "cpuPercent", 0), 40.0);
+
+    const QVariantMap stats = m_manager->historyStats("game1", "cpuPercent");
+    QCOMPARE(stats.value("count").toInt(), 3);
+    QCOMPARE(stats.value("min").toDouble(), 20.0);
+    QCOMPARE(stats.value("max").toDouble(), 40.0);
+    QCOMPARE(stats.value("mean").toDouble(), 30.0);
+
+    QVERIFY(m_manager->historyStats("game1", "bogus").isEmpty());
+    QVERIFY(m_manager->historyStats("missing", "cpuPercent").isEmpty());
+}
+
+void RunningManagerTest::testMetricDistributionQuantiles()
+{
+    Runtime::MetricDistribution distribution;
+    QCOMPARE(distribution.quantile(Runtime::MetricField::CpuPercent, 0.5), 0.0);
+
+    // 100 samples of 1..100 over ten seconds; the first half has no frame timing.
+    for (int i = 1; i <= 100; ++i) {
+        Runtime::ProcessMetrics metrics;
+        metrics.cpuPercent = i;
+        metrics.fps = i > 50 ? i : 0.0;
+        distribution.append(metrics, i * 100);
+    }
+
+    const auto summary = distribution.summary(Runtime::MetricField::CpuPercent);
+    QCOMPARE(summary.count, 100);
+    QCOMPARE(summary.min, 1.0);
+    QCOMPARE(summary.max, 100.0);
+    QCOMPARE(summary.mean, 50.5);
+    QVERIFY(qAbs(summary.p50 - 50.0) <= 50.0 * 0.03);
+    QVERIFY(qAbs(summary.p95 - 95.0) <= 95.0 * 0.03);
+    QVERIFY(qAbs(summary.p99 - 99.0) <= 99.0 * 0.03);
+    QCOMPARE(distribution.quantile(Runtime::MetricField::CpuPercent, 0.99), summary.p99);
+
+    const auto fps = distribution.summary(Runtime::MetricField::Fps);
+    QCOMPARE(fps.count, 50);
+    QVERIFY(qAbs(fps.p1 - 51.0) <= 51.0 * 0.03);
+
+    // Two minutes later only the recent samples are inside a 60 s window,
+    // while the session distribution keeps everything.
+    for (int i = 0; i < 10; ++i) {
+        Runtime::ProcessMetrics metrics;
+        metrics.cpuPercent = 500.0;
+        distribution.append(metrics, 130000 + i * 1000);
+    }
+    const auto recent = distribution.summary(Runtime::MetricField::CpuPercent, 60000);
+    QCOMPARE(recent.count, 10);
+    QCOMPARE(recent.min, 500.0);
+    QCOMPARE(recent.p50, 500.0);
+    QCOMPARE(distribution.summary(Runtime::MetricField::CpuPercent).count, 110);
+
+    // Fields outside the mask were not sampled and are not counted again.
+    Runtime::ProcessMetrics partial;
+    partial.cpuPercent = 500.0;
+    partial.temperatureC = 70.0;
+    distribution.append(partial, 140000, Runtime::metricFieldBit(Runtime::MetricField::TemperatureC));
+    QCOMPARE(distribution.summary(Runtime::MetricField::CpuPercent).count, 110);
+    QCOMPARE(distribution.summary(Runtime::MetricField::TemperatureC).count, 111);
+
+    distribution.clear();
+    QCOMPARE(distribution.summary(Runtime::MetricField::CpuPercent).count, 0);
+}
+
+void RunningManagerTest::testMetricSummary()
+{
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.valid = true;
+
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    for (int i = 1; i <= 20; ++i) {
+        metrics.cpuPercent = i * 5.0;
+        metrics.fps = i * 10.0;
+        m_mockProvider->setMetrics(12345, metrics);
+        m_manager->refreshNow();
+    }
+
+    const QVariantMap summary = m_manager->metricSummary("game1", "cpuPercent", 60);
+    QCOMPARE(summary.value("count").toInt(), 20);
+    QCOMPARE(summary.value("max").toDouble(), 100.0);
+    QVERIFY(qAbs(summary.value("p50").toDouble() - 50.0) <= 50.0 * 0.03);
+
+    const double lowFps = m_manager->metricQuantile("game1", "fps", 0.01);
+    QVERIFY(qAbs(lowFps - 10.0) <= 10.0 * 0.03);
+
+    QVERIFY(m_manager->metricSummary("game1", "bogus").isEmpty());
+    QCOMPARE(m_manager->metricQuantile("missing", "fps", 0.5), 0.0);
+}
+
+void RunningManagerTest::testExitDetectedWithoutSampling()
+{
+    QProcess child;
+    child.start(QStringLiteral("sleep"), {QStringLiteral("30")});
+    QVERIFY(child.waitForStarted());
+    const qint64 pid = child.processId();
+
+    Runtime::ProcessExitWatcher probe;
+    if (!probe.watch(pid)) {
+        QSKIP("pidfd_open() is not available");
+    }
+    probe.unwatch(pid);
+
+    // The timer never fires during the test, so only the pidfd can report the exit.
+    m_manager->setUpdateIntervalMs(60000);
+    QSignalSpy closedSpy(m_manager.get(), &Runtime::RunningManager::gameClosed);
+    m_manager->registerGame("game1", "Test Game 1", pid, true, "");
+
+    child.kill();
+    QTRY_COMPARE(closedSpy.count(), 1);
+    QCOMPARE(closedSpy.first().at(0).toString(), QStringLiteral("game1"));
+    QVERIFY(m_manager->games().isEmpty());
+    child.waitForFinished();
+}
+
+void RunningManagerTest::testLivenessTickWithoutPidfd()
+{
+    QProcess child;
+    child.start(QStringLiteral("sleep"), {QStringLiteral("30")});
+    QVERIFY(child.waitForStarted());
+    const qint64 pid = child.processId();
+
+    Runtime::ProcessExitWatcher probe;
+    if (!probe.watch(pid)) {
+        QSKIP("pidfd_open() is not available");
+    }
+    probe.unwatch(pid);
+
+    // Nothing demands a fast metric, so a fast tick only checks liveness.
+    m_manager->unsubscribe(m_allMetricsSubscription);
+    for (const char* type : {"cpu", "fps", "cpuThread"}) {
+        QVERIFY(m_manager->setAlertRule(QVariantMap{{"type", type}, {"enabled", false}}));
+    }
+    const Runtime::MetricFieldMask fastFields =
+        Runtime::metricGroupFields(Runtime::metricGroupBit(Runtime::MetricGroup::Fast));
+    QCOMPARE(m_manager->demandedFields() & fastFields, Runtime::MetricFieldMask(0));
+    m_manager->setUpdateIntervalMs(20);
+
+    // A game watched through its pidfd needs no liveness tick.
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = pid;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(pid, metrics);
+    m_manager->registerGame("game1", "Test Game 1", pid, true, "");
+    QTest::qWait(100);
+    QCOMPARE(m_manager->games().size(), 1);
+    QVERIFY(!m_mockProvider->requestedFields.isEmpty());
+    QVERIFY(!m_mockProvider->requestedFields.contains(Runtime::MetricFieldMask(0)));
+
+    // A PID that cannot be watched is checked on every fast tick.
+    metrics.pid = 999999999;
+    m_mockProvider->setMetrics(metrics.pid, metrics);
+    const int firstRequest = m_mockProvider->requestedFields.size();
+    m_manager->registerGame("game2", "Test Game 2", metrics.pid, true, "");
+    QTRY_VERIFY(m_mockProvider->requestedFields.mid(firstRequest).count(Runtime::MetricFieldMask(0)) >= 3);
+
+    // Liveness ticks add no history rows.
+    const QVector<Runtime::MetricFieldMask> requests = m_mockProvider->requestedFields.mid(firstRequest);
+    const int sampledTicks = requests.size() - requests.count(Runtime::MetricFieldMask(0));
+    QVERIFY(m_manager->historySize("game2") <= sampledTicks);
+    QCOMPARE(m_manager->games().size(), 2);
+
+    child.kill();
+    child.waitForFinished();
+}
+
+void RunningManagerTest::testSamplingScheduler()
+{
+    using Runtime::MetricGroup;
+    using Runtime::metricGroupBit;
+    constexpr qint64 MS = 1'000'000;
+
+    Runtime::SamplingScheduler scheduler(1000);
+    scheduler.start(0);
+    QCOMPARE(scheduler.takeDueGroups(999 * MS), Runtime::MetricGroupMask(0));
+
+    // A late wake-up does not push later deadlines back.
+    QCOMPARE(scheduler.takeDueGroups(1005 * MS), metricGroupBit(MetricGroup::Fast));
+    QCOMPARE(scheduler.nextDeadlineNs(), 2000 * MS);
+    QCOMPARE(scheduler.groupState(MetricGroup::Fast).maxLatenessNs, 5 * MS);
+    QCOMPARE(scheduler.takeDueGroups(2000 * MS),
+             metricGroupBit(MetricGroup::Fast) | metricGroupBit(MetricGroup::Medium));
+
+    // Sleeping through two fast intervals resyncs instead of catching up.
+    QCOMPARE(scheduler.takeDueGroups(5000 * MS), Runtime::ALL_METRIC_GROUPS);
+    QCOMPARE(scheduler.groupState(MetricGroup::Fast).missed, quint64(1));
+    QCOMPARE(scheduler.groupState(MetricGroup::Medium).missed, quint64(0));
+    QCOMPARE(scheduler.nextDeadlineNs(), 6000 * MS);
+    QCOMPARE(scheduler.groupState(MetricGroup::Slow).nextDueNs, 10000 * MS);
+
+    scheduler.markAllSampled(5500 * MS);
+    QCOMPARE(scheduler.groupState(MetricGroup::Fast).samples, quint64(4));
+    QCOMPARE(scheduler.nextDeadlineNs(), 6500 * MS);
+}
+
+void RunningManagerTest::testSchedulerLowPowerAndBurst()
+{
+    auto groupInterval = [this](int group) {
+        const QVariantList groups = m_manager->schedulerState().value("groups").toList();
+        return groups.at(group).toMap().value("intervalMs").toLongLong();
+    };
+
+    QVERIFY(m_manager->overlayVisible());
+    QVERIFY(!m_manager->schedulerState().value("lowPower").toBool());
+    QCOMPARE(groupInterval(0), 1000LL);
+    QCOMPARE(groupInterval(1), 2000LL);
+    QCOMPARE(groupInterval(2), 5000LL);
+
+    QSignalSpy visibleSpy(m_manager.get(), &Runtime::RunningManager::overlayVisibleChanged);
+    m_manager->setOverlayVisible(false);
+    QCOMPARE(visibleSpy.count(), 1);
+    QVERIFY(m_manager->schedulerState().value("lowPower").toBool());
+    QCOMPARE(groupInterval(0), 4000LL);
+    QCOMPARE(groupInterval(2), 20000LL);
+
+    // An overheating game keeps the sensor group at the burst rate.
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.temperatureC = 88.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->refreshNow();
+
+    QVariantMap state = m_manager->schedulerState();
+    QVariantMap slow = state.value("groups").toList().at(2).toMap();
+    QCOMPARE(slow.value("name").toString(), QStringLiteral("slow"));
+    QVERIFY(slow.value("burst").toBool());
+    QCOMPARE(slow.value("intervalMs").toLongLong(), Runtime::SamplingScheduler::MIN_BURST_INTERVAL_MS);
+    QCOMPARE(groupInterval(0), 4000LL);
+    QCOMPARE(state.value("sampleCount").toULongLong(), quint64(1));
+
+    metrics.temperatureC = 60.0;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->refreshNow();
+    QCOMPARE(groupInterval(2), 20000LL);
+
+    m_manager->setOverlayVisible(true);
+    m_manager->setOnBattery(true);
+    QVERIFY(m_manager->schedulerState().value("lowPower").toBool());
+    m_manager->setOnBattery(false);
+    QCOMPARE(groupInterval(0), 1000LL);
+
+    // The provider's power source drives onBattery when it changes, and a
+    // value set in between holds until the next change.
+    QSignalSpy batterySpy(m_manager.get(), &Runtime::RunningManager::onBatteryChanged);
+    m_mockProvider->battery = true;
+    m_manager->refreshNow();
+    QVERIFY(m_manager->onBattery());
+    QVERIFY(m_manager->schedulerState().value("lowPower").toBool());
+    m_manager->setOnBattery(false);
+    m_manager->refreshNow();
+    QVERIFY(!m_manager->onBattery());
+    QCOMPARE(batterySpy.count(), 2);
+}
+
+void RunningManagerTest::testMetricSubscriptions()
+{
+    using Runtime::MetricField;
+    using Runtime::metricFieldBit;
+
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.cpuPercent = 10.0;
+    metrics.ramMb = 1024.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+
+    // Everything is read only on request.
+    QCOMPARE(m_manager->demandedFields(), Runtime::ALL_METRIC_FIELDS);
+    m_manager->refreshNow();
+    QCOMPARE(m_mockProvider->requestedFields.last(), Runtime::ALL_METRIC_FIELDS);
+    m_manager->unsubscribe(m_allMetricsSubscription);
+
+    // Without subscriptions only the metrics alerts need are read.
+    const Runtime::MetricFieldMask alertFields = m_manager->demandedFields();
+    QVERIFY(alertFields & metricFieldBit(MetricField::CpuPercent));
+    QVERIFY(!(alertFields & metricFieldBit(MetricField::RamMb)));
+    m_manager->refreshNow();
+    QCOMPARE(m_mockProvider->requestedFields.last(), alertFields);
+
+    QCOMPARE(m_manager->subscribe({"cpuPercent", "bogus"}), 0);
+    const int frameId = m_manager->subscribe({"frameTimeMs"});
+    QVERIFY(frameId > 0);
+    QVERIFY(m_manager->demandedMetrics().contains("frameTimeMs"));
+    QVERIFY(m_manager->demandedMetrics().contains("powerWatts"));
+    QVERIFY(!m_manager->demandedMetrics().contains("ramMb"));
+
+    // Unsubscribed metrics are not requested and keep their last value.
+    metrics.cpuPercent = 20.0;
+    metrics.ramMb = 2048.0;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->refreshNow();
+    QVERIFY(!(m_mockProvider->requestedFields.last() & metricFieldBit(MetricField::RamMb)));
+    QCOMPARE(m_manager->metricsFor("game1").cpuPercent, 20.0);
+    QCOMPARE(m_manager->metricsFor("game1").ramMb, 1024.0);
+
+    // A subscription scoped to other games only counts while one is tracked,
+    // and is read for that game alone.
+    const int ramId = m_manager->subscribe({"ramMb"}, {"game2"});
+    QVERIFY(!(m_manager->demandedFields() & metricFieldBit(MetricField::RamMb)));
+    m_mockProvider->setMetrics(67890, metrics);
+    m_manager->registerGame("game2", "Test Game 2", 67890, true, "");
+    QVERIFY(m_manager->demandedFields() & metricFieldBit(MetricField::RamMb));
+    m_manager->refreshNow();
+    QVERIFY(m_mockProvider->requestedPidFields.value(67890) & metricFieldBit(MetricField::RamMb));
+    QVERIFY(!(m_mockProvider->requestedPidFields.value(12345) & metricFieldBit(MetricField::RamMb)));
+    QCOMPARE(m_manager->metricsFor("game1").ramMb, 1024.0);
+    m_manager->markGameExited("game2");
+    QVERIFY(!(m_manager->demandedFields() & metricFieldBit(MetricField::RamMb)));
+
+    // Freshness caps the interval of the group that serves the metric.
+    const int powerId = m_manager->subscribe({"powerWatts"}, {}, 2000);
+    const QVariantList groups = m_manager->schedulerState().value("groups").toList();
+    QCOMPARE(groups.at(2).toMap().value("intervalMs").toLongLong(), 2000LL);
+    QCOMPARE(groups.at(0).toMap().value("intervalMs").toLongLong(), 1000LL);
+
+    m_manager->unsubscribe(powerId);
+    m_manager->unsubscribe(ramId);
+    m_manager->unsubscribe(frameId);
+    QCOMPARE(m_manager->demandedFields(), alertFields);
+    QCOMPARE(m_manager->schedulerState().value("groups").toList().at(2).toMap().value("intervalMs").toLongLong(),
+             5000LL);
+}
+
+void RunningManagerTest::testAlertEngineBatch()
+{
+    using Runtime::AlertKind;
+    using Runtime::AlertTransition;
+
+    Runtime::ProcessMetrics metrics[3];
+    metrics[0].temperatureC = 70.0;
+    metrics[1].temperatureC = 92.0;
+    metrics[1].fps = 60.0;
+    metrics[2].fps = 10.0;
+    Runtime::AlertState states[3];
+    const Runtime::ProcessMetrics* metricPointers[] = {&metrics[0], &metrics[1], &metrics[2]};
+    Runtime::AlertState* statePointers[] = {&states[0], &states[1], &states[2]};
+
+    Runtime::AlertEngine engine;
+    QVector<AlertTransition> transitions;
+    engine.evaluate(metricPointers, statePointers, 3, 1000, transitions);
+
+    QCOMPARE(transitions.size(), 2);
+    QCOMPARE(transitions[0].game, 1);
+    QCOMPARE(transitions[0].kind, AlertKind::Temperature);
+    QCOMPARE(transitions[0].type, AlertTransition::Type::Raised);
+    QVERIFY(transitions[0].critical);
+    QCOMPARE(transitions[1].game, 2);
+    QCOMPARE(transitions[1].kind, AlertKind::Fps);
+    QCOMPARE(states[1].active, Runtime::alertKindBit(AlertKind::Temperature));
+    QCOMPARE(states[1].critical, Runtime::alertKindBit(AlertKind::Temperature));
+
+    // Dropping below the critical level only changes the severity. An FPS of
+    // 0 means no frame data and clears the FPS alert.
+    metrics[1].temperatureC = 87.0;
+    metrics[2].fps = 0.0;
+    transitions.clear();
+    engine.evaluate(metricPointers, statePointers, 3, 2000, transitions);
+    QCOMPARE(transitions.size(), 2);
+    QCOMPARE(transitions[0].type, AlertTransition::Type::SeverityChanged);
+    QVERIFY(!transitions[0].critical);
+    QCOMPARE(transitions[1].type, AlertTransition::Type::Cleared);
+    QCOMPARE(states[2].active, Runtime::AlertMask(0));
+
+    // Disabled rules clear their alerts and stop reading their metric.
+    Runtime::AlertRule rule = engine.rule(AlertKind::Temperature);
+    rule.enabled = false;
+    engine.setRule(rule);
+    QVERIFY(!(engine.fields() & Runtime::metricFieldBit(Runtime::MetricField::TemperatureC)));
+    transitions.clear();
+    engine.evaluate(metricPointers, statePointers, 3, 3000, transitions);
+    QCOMPARE(transitions.size(), 1);
+    QCOMPARE(transitions[0].type, AlertTransition::Type::Cleared);
+}
+
+void RunningManagerTest::testAlertHysteresis()
+{
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.temperatureC = 86.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+
+    QSignalSpy raisedSpy(m_manager.get(), &Runtime::RunningManager::alertRaised);
+    QSignalSpy clearedSpy(m_manager.get(), &Runtime::RunningManager::alertCleared);
+    m_manager->refreshNow();
+    QCOMPARE(raisedSpy.count(), 1);
+
+    // Hovering around the threshold neither clears nor re-raises the alert,
+    // and the message is not rebuilt while nothing changes.
+    for (double temperature : {84.0, 85.5, 81.0}) {
+        metrics.temperatureC = temperature;
+        m_mockProvider->setMetrics(12345, metrics);
+        m_manager->refreshNow();
+    }
+    QCOMPARE(raisedSpy.count(), 1);
+    QCOMPARE(clearedSpy.count(), 0);
+    QVERIFY(m_manager->alerts().first().toMap().value("message").toString().contains("86.0"));
+
+    metrics.temperatureC = 79.0;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->refreshNow();
+    QCOMPARE(clearedSpy.count(), 1);
+    QCOMPARE(clearedSpy.first().at(1).toString(), QStringLiteral("temperature"));
+    QVERIFY(m_manager->alerts().isEmpty());
+
+    QVERIFY(!m_manager->setAlertRule(QVariantMap{{"type", "bogus"}}));
+    QCOMPARE(int(m_manager->alertRules().size()), Runtime::ALERT_KIND_COUNT);
+}
+
+void RunningManagerTest::testAlertDebounce()
+{
+    // Keep the periodic timer out of the way so only refreshNow() samples.
+    m_manager->setUpdateIntervalMs(60000);
+    QVERIFY(m_manager->setAlertRule(QVariantMap{{"type", "cpu"}, {"minDurationMs", 150}}));
+    QCOMPARE(m_manager->alertRule(Runtime::AlertKind::Cpu).minDurationMs, 150LL);
+
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.cpuPercent = 99.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+
+    m_manager->refreshNow();
+    QVERIFY(m_manager->alerts().isEmpty());
+
+    QTest::qWait(200);
+    m_manager->refreshNow();
+    QCOMPARE(m_manager->alerts().size(), 1);
+    QCOMPARE(m_manager->alerts().first().toMap().value("type").toString(), QStringLiteral("cpu"));
+}
+
+void RunningManagerTest::testCoalescedTickNotification()
+{
+    Runtime::ProcessMetrics hot;
+    hot.pid = 12345;
+    hot.cpuPercent = 99.0;
+    hot.temperatureC = 88.0;
+    hot.fps = 60.0;
+    hot.valid = true;
+    m_mockProvider->setMetrics(12345, hot);
+
+    Runtime::ProcessMetrics cool = hot;
+    cool.pid = 23456;
+    cool.cpuPercent = 20.0;
+    cool.temperatureC = 60.0;
+    m_mockProvider->setMetrics(23456, cool);
+
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    m_manager->registerGame("game2", "Test Game 2", 23456, true, "");
+    m_manager->registerGame("game3", "Test Game 3", 34567, true, "");
+
+    QSignalSpy gamesSpy(m_manager.get(), &Runtime::RunningManager::gamesChanged);
+    QSignalSpy alertsSpy(m_manager.get(), &Runtime::RunningManager::alertsChanged);
+    QSignalSpy committedSpy(m_manager.get(), &Runtime::RunningManager::changesCommitted);
+    QSignalSpy raisedSpy(m_manager.get(), &Runtime::RunningManager::alertRaised);
+    m_manager->refreshNow();
+
+    // Two updates, two alerts and an exit in one tick: one notification each.
+    QCOMPARE(gamesSpy.count(), 1);
+    QCOMPARE(alertsSpy.count(), 1);
+    QCOMPARE(committedSpy.count(), 1);
+    QCOMPARE(raisedSpy.count(), 2);
+
+    const QVariantMap changes = committedSpy.first().at(0).toMap();
+    QVERIFY(changes.contains("tick"));
+    QCOMPARE(changes.value("updated").toStringList(), QStringList({"game1", "game2"}));
+    QCOMPARE(changes.value("removed").toStringList(), QStringList({"game3"}));
+    QVERIFY(changes.value("added").toStringList().isEmpty());
+    QCOMPARE(changes.value("raised").toList().size(), 2);
+
+    // Fresh metrics alone: changesCommitted() is the only notification.
+    m_manager->refreshNow();
+    QCOMPARE(gamesSpy.count(), 1);
+    QCOMPARE(alertsSpy.count(), 1);
+    QCOMPARE(committedSpy.count(), 2);
+    QCOMPARE(committedSpy.last().at(0).toMap().value("updated").toStringList(), QStringList({"game1", "game2"}));
+
+    // A power source change is part of the tick's transaction.
+    QSignalSpy batterySpy(m_manager.get(), &Runtime::RunningManager::onBatteryChanged);
+    m_mockProvider->battery = true;
+    m_manager->refreshNow();
+    QCOMPARE(batterySpy.count(), 1);
+    QCOMPARE(gamesSpy.count(), 1);
+    QCOMPARE(committedSpy.count(), 3);
+    QCOMPARE(committedSpy.last().at(0).toMap().value("onBattery").toBool(), true);
+}
+
+void RunningManagerTest::testFlightRecorderRing()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("ring.frec");
+
+    Runtime::FlightRecorder recorder;
+    QVERIFY(recorder.open(path, 4));
+    const int slot = recorder.registerGame(12345, "game1", 0);
+    Runtime::ProcessMetrics metrics;
+    metrics.valid = true;
+    metrics.ramMb = 1000.0;
+    for (int i = 0; i < 2000; ++i) {
+        metrics.cpuPercent = i % 100;
+        // A jump too large for a 16-bit delta starts a new block.
+        metrics.ramMb = i == 1500 ? 6000.0 : 1000.0;
+        recorder.recordSample(slot, metrics, 1000 + i * 10);
+    }
+    QVERIFY(recorder.blocksWritten() > 4);
+
+    // The ring keeps the newest blocks, oldest first, without closing the
+    // writer: the mapping is the file.
+    Runtime::FlightRecording recording;
+    QVERIFY(Runtime::readFlightRecording(path, &recording));
+    QCOMPARE(recording.skippedBlocks, 0);
+    QVERIFY(!recording.samples.isEmpty());
+    QVERIFY(recording.samples.size() < 2000);
+    const Runtime::FlightSample& last = recording.samples.last();
+    QCOMPARE(last.timeMs, 1000LL + 1999 * 10);
+    QCOMPARE(last.metrics.cpuPercent, 99.0);
+    QCOMPARE(last.metrics.ramMb, 1000.0);
+    QCOMPARE(last.titleId, QString("game1"));
+    for (int i = 1; i < recording.samples.size(); ++i) {
+        QVERIFY(recording.samples[i - 1].timeMs < recording.samples[i].timeMs);
+    }
+
+    // A torn block fails its checksum and is skipped; the rest stay readable.
+    recorder.close();
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    // Inside the time column of the first block, which holds the newest rows.
+    QVERIFY(file.seek(4096 + sizeof(Runtime::FlightBlockHeader) + 200));
+    QVERIFY(file.write(QByteArray(1, char(0x7f))) == 1);
+    file.close();
+    Runtime::FlightRecording damaged;
+    QVERIFY(Runtime::readFlightRecording(path, &damaged));
+    QCOMPARE(damaged.skippedBlocks, 1);
+    QVERIFY(damaged.samples.size() < recording.samples.size());
+
+    QVERIFY(!Runtime::readFlightRecording(dir.filePath("missing.frec"), &damaged));
+}
+
+void RunningManagerTest::testFlightRecorderDivergentGames()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("divergent.frec");
+
+    Runtime::FlightRecorder recorder;
+    QVERIFY(recorder.open(path, 4));
+    const int small = recorder.registerGame(100, "small", 0);
+    const int large = recorder.registerGame(200, "large", 0);
+    Runtime::ProcessMetrics metrics;
+    metrics.valid = true;
+    // Far more than an int16 delta apart, but each game is steady: every
+    // game keeps its own base, so the rows share one block.
+    for (int i = 0; i < 120; ++i) {
+        metrics.ramMb = 500.0 + i % 10;
+        recorder.recordSample(small, metrics, 1000 + i * 10);
+        metrics.ramMb = 12000.0 + i % 10;
+        recorder.recordSample(large, metrics, 1000 + i * 10 + 5);
+    }
+    QCOMPARE(recorder.blocksWritten(), 1ULL);
+
+    Runtime::FlightRecording recording;
+    QVERIFY(Runtime::readFlightRecording(path, &recording));
+    QCOMPARE(recording.skippedBlocks, 0);
+    QCOMPARE(recording.samples.size(), 240);
+    QCOMPARE(recording.samples[0].titleId, QString("small"));
+    QCOMPARE(recording.samples[0].metrics.ramMb, 500.0);
+    QCOMPARE(recording.samples[1].titleId, QString("large"));
+    QCOMPARE(recording.samples[1].metrics.ramMb, 12000.0);
+    QCOMPARE(recording.samples[239].metrics.ramMb, 12009.0);
+}
+
+void RunningManagerTest::testFlightRecorderSession()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("session.frec");
+
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.cpuPercent = 40.0;
+    metrics.temperatureC = 88.0;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+
+    QSignalSpy recordingSpy(m_manager.get(), &Runtime::RunningManager::recordingChanged);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true, "");
+    QVERIFY(m_manager->startRecording(path));
+    QVERIFY(m_manager->recording());
+    m_manager->refreshNow();
+    m_manager->refreshNow();
+    m_manager->stopRecording();
+    QVERIFY(!m_manager->recording());
+    QCOMPARE(recordingSpy.count(), 2);
+
+    Runtime::FlightRecording recording;
+    QVERIFY(Runtime::readFlightRecording(path, &recording));
+    QCOMPARE(recording.samples.size(), 2);
+    QCOMPARE(recording.samples.first().titleId, QString("game1"));
+    QCOMPARE(recording.samples.first().pid, 12345LL);
+    QCOMPARE(recording.samples.first().metrics.cpuPercent, 40.0);
+    QCOMPARE(recording.samples.first().metrics.temperatureC, 88.0);
+    QCOMPARE(recording.events.size(), 1);
+    QCOMPARE(recording.events.first().kind, Runtime::AlertKind::Temperature);
+    QCOMPARE(recording.events.first().type, Runtime::AlertTransition::Type::Raised);
+    QCOMPARE(recording.events.first().value, 88.0);
+}
+
+void RunningManagerTest::testReplayProviderClock()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QFile trace(dir.filePath("trace.csv"));
+    QVERIFY(trace.open(QIODevice::WriteOnly | QIODevice::Text));
+    trace.write("# two games, one exits early\n"
+                "timeMs,pid,titleId,cpuPercent,fps,valid\n"
+                "10000,100,game1,10,60,1\n"
+                "10000,200,game2,20,30,1\n"
+                "11000,100,game1,50,55,1\n"
+                "11000,200,game2,25,30,0\n"
+                "12000,100,game1,99,40,1\n");
+    trace.close();
+
+    qint64 nowMs = 0;
+    Runtime::ReplayMetricsProvider provider([&nowMs]() {
+        return nowMs;
+    });
+    QVERIFY(provider.loadCsv(trace.fileName()));
+    QCOMPARE(provider.games().size(), 2);
+    QCOMPARE(provider.games().first().titleId, QString("game1"));
+    QCOMPARE(provider.startTimeMs(), 10000LL);
+    QCOMPARE(provider.endTimeMs(), 12000LL);
+
+    // Real time: samples hold until the next timestamp.
+    QCOMPARE(provider.metricsForPid(100).cpuPercent, 10.0);
+    nowMs = 999;
+    QCOMPARE(provider.metricsForPid(100).cpuPercent, 10.0);
+    nowMs = 1000;
+    QCOMPARE(provider.metricsForPid(100).cpuPercent, 50.0);
+    QVERIFY(!provider.metricsForPid(200).valid);
+
+    // Twice as fast, continuing from the current trace time.
+    provider.setSpeed(2.0);
+    nowMs = 1500;
+    QCOMPARE(provider.traceTimeMs(), 12000LL);
+    QCOMPARE(provider.metricsForPid(100).cpuPercent, 99.0);
+    nowMs = 1501;
+    QVERIFY(provider.finished());
+    QVERIFY(!provider.metricsForPid(100).valid);
+
+    // As fast as possible: one timestamp per tick, regardless of the clock.
+    provider.setSpeed(Runtime::ReplayMetricsProvider::AS_FAST_AS_POSSIBLE);
+    provider.restart();
+    const QVector<qint64> pids({100, 200});
+    QCOMPARE(provider.metricsForPids(pids).at(1).fps, 30.0);
+    QCOMPARE(provider.metricsForPids(pids).at(0).fps, 55.0);
+    QCOMPARE(provider.metricsForPids(pids).at(0).fps, 40.0);
+    QVERIFY(!provider.metricsForPids(pids).at(0).valid);
+
+    QVERIFY(!provider.loadCsv(dir.filePath("missing.csv")));
+}
+
+void RunningManagerTest::testReplayDrivesManager()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.filePath("session.frec");
+
+    // Record a short session, then replay it at full speed.
+    {
+        Runtime::FlightRecorder recorder;
+        QVERIFY(recorder.open(path, 4));
+        const int slot = recorder.registerGame(4242, "game1", 0);
+        Runtime::ProcessMetrics metrics;
+        metrics.valid = true;
+        metrics.fps = 60.0;
+        for (int i = 0; i < 600; ++i) {
+            metrics.temperatureC = i < 300 ? 60.0 : 92.0;
+            recorder.recordSample(slot, metrics, 1000 + i * 1000);
+        }
+    }
+
+    auto provider = std::make_shared<Runtime::ReplayMetricsProvider>();
+    QVERIFY(provider->loadRecording(path));
+    provider->setSpeed(Runtime::ReplayMetricsProvider::AS_FAST_AS_POSSIBLE);
+    // Replayed PIDs are not watched, so only the ticks below step the trace.
+    QVERIFY(!provider->readsLiveProcesses());
+    m_manager->setMetricsProvider(provider);
+    m_manager->setUpdateIntervalMs(60000);
+    for (const auto& game : provider->games()) {
+        m_manager->registerGame(game.titleId, game.titleId, game.pid, true);
+    }
+
+    QSignalSpy raisedSpy(m_manager.get(), &Runtime::RunningManager::alertRaised);
+    QSignalSpy closedSpy(m_manager.get(), &Runtime::RunningManager::gameClosed);
+    int ticks = 0;
+    while (closedSpy.isEmpty() && ticks < 1000) {
+        m_manager->refreshNow();
+        ++ticks;
+    }
+    QCOMPARE(ticks, 601);
+    QCOMPARE(raisedSpy.count(), 1);
+    QCOMPARE(raisedSpy.first().at(1).value<Runtime::AlertInfo>().type, QString("temperature"));
+}
+
+void RunningManagerTest::testMetricsExporter()
+{
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.cpuPercent = 42.5;
+    metrics.temperatureC = 90.0;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->registerGame("game \"1\"", "Test Game 1", 12345, true);
+
+    QSignalSpy portSpy(m_manager.get(), &Runtime::RunningManager::exporterPortChanged);
+    QVERIFY(m_manager->startExporter(0));
+    QCOMPARE(portSpy.count(), 1);
+    const int port = m_manager->exporterPort();
+    QVERIFY(port > 0);
+
+    // Published when the exporter starts, before the first tick.
+    QByteArray response = scrapeExporter(port, "/metrics");
+    QVERIFY(response.startsWith("HTTP/1.1 200 OK\r\n"));
+    QVERIFY(response.contains("Content-Type: application/openmetrics-text; version=1.0.0"));
+    QVERIFY(response.contains("runtime_games 1\n"));
+    QVERIFY(!response.contains("runtime_cpu_percent{"));
+    QVERIFY(response.endsWith("# EOF\n"));
+
+    m_manager->refreshNow();
+    response = scrapeExporter(port, "/metrics?name=ignored");
+    const QByteArray body = response.mid(response.indexOf("\r\n\r\n") + 4);
+    QVERIFY(response.contains("Content-Length: " + QByteArray::number(body.size()) + "\r\n"));
+    QVERIFY(body.contains("# TYPE runtime_cpu_percent gauge\n"));
+    QVERIFY(body.contains("runtime_cpu_percent{titleId=\"game \\\"1\\\"\"} 42.5\n"));
+    QVERIFY(body.contains("runtime_temperature_celsius{titleId=\"game \\\"1\\\"\"} 90\n"));
+    QVERIFY(body.contains("runtime_alert_severity{titleId=\"game \\\"1\\\"\",type=\"temperature\"} 2\n"));
+    QVERIFY(body.contains("runtime_alert_severity{titleId=\"game \\\"1\\\"\",type=\"cpu\"} 0\n"));
+    QVERIFY(body.endsWith("# EOF\n"));
+
+    QVERIFY(scrapeExporter(port, "/").startsWith("HTTP/1.1 404"));
+
+    m_manager->stopExporter();
+    QCOMPARE(portSpy.count(), 2);
+    QCOMPARE(m_manager->exporterPort(), 0);
+    QVERIFY(scrapeExporter(port, "/metrics").isEmpty());
+}
+
+void RunningManagerTest::testMetricsExporterSubscription()
+{
+    using Runtime::MetricField;
+    using Runtime::metricFieldBit;
+
+    Runtime::ProcessMetrics metrics;
+    metrics.pid = 12345;
+    metrics.ramMb = 1024.0;
+    metrics.fps = 60.0;
+    metrics.valid = true;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->registerGame("game1", "Test Game 1", 12345, true);
+    m_manager->unsubscribe(m_allMetricsSubscription);
+    m_manager->subscribe({"fps"});
+    QVERIFY(!(m_manager->demandedFields() & metricFieldBit(MetricField::RamMb)));
+
+    // The exporter keeps every gauge fresh, not just the subscribed ones.
+    QVERIFY(m_manager->startExporter(0));
+    const int port = m_manager->exporterPort();
+    QCOMPARE(m_manager->demandedFields(), Runtime::ALL_METRIC_FIELDS);
+    m_manager->refreshNow();
+    QVERIFY(scrapeExporter(port, "/metrics").contains("runtime_ram_megabytes{titleId=\"game1\"} 1024\n"));
+    metrics.ramMb = 2048.0;
+    m_mockProvider->setMetrics(12345, metrics);
+    m_manager->refreshNow();
+    QVERIFY(scrapeExporter(port, "/metrics").contains("runtime_ram_megabytes{titleId=\"game1\"} 2048\n"));
+
+    m_manager->stopExporter();
+    QVERIFY(!(m_manager->demandedFields() & metricFieldBit(MetricField::RamMb)));
+}
+
 QTEST_MAIN(RunningManagerTest)
 #include "RunningManagerTest.moc"
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QByteArray>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QString>
+
+#include <unistd.h>
+
+// Builders for the synthetic /proc and sysfs trees that the provider tests
+// and benchmarks read.
+
+// Writes content to root/relativePath, creating the directories on the way.
+inline bool writeFixture(const QString& root, const QString& relativePath, const QByteArray& content)
+{
+    const QString path = root + QLatin1Char('/') + relativePath;
+    if (!QDir().mkpath(QFileInfo(path).absolutePath())) {
+        return false;
+    }
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+    return file.write(content) == content.size();
+}
+
+// /proc/<pid>/statm content for a process with residentKb resident, in pages
+// of this machine.
+inline QByteArray statmFixture(qint64 residentKb)
+{
+    const qint64 pages = residentKb * 1024 / sysconf(_SC_PAGESIZE);
+    return QByteArray::number(pages * 4) + ' ' + QByteArray::number(pages) + " 3000 100 0 90000 0\n";
+}
+
+// Creates root/relativePath as a symlink to target.
+inline bool linkFixture(const QString& root, const QString& relativePath, const QString& target)
+{
+    const QString path = root + QLatin1Char('/') + relativePath;
+    return QDir().mkpath(QFileInfo(path).absolutePath()) && QFile::link(target, path);
+}
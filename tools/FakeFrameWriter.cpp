@@ -0,0 +1,114 @@
+#include "runtime/FrameTimingChannel.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTextStream>
+
+#include <atomic>
+#include <csignal>
+#include <ctime>
+
+// Publishes synthetic present timestamps into a frame timing channel, standing
+// in for an in-game layer. Point it at a registered game's PID (or register
+// this process) to exercise the FPS metrics and alerts without a GPU.
+
+namespace {
+std::atomic<bool> g_running{true};
+
+void stop(int)
+{
+    g_running = false;
+}
+
+quint64 nowNs()
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return static_cast<quint64>(now.tv_sec) * 1'000'000'000ull + static_cast<quint64>(now.tv_nsec);
+}
+
+void sleepUntil(quint64 deadlineNs)
+{
+    timespec deadline;
+    deadline.tv_sec = static_cast<time_t>(deadlineNs / 1'000'000'000ull);
+    deadline.tv_nsec = static_cast<long>(deadlineNs % 1'000'000'000ull);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) != 0 && g_running) {
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("runtime_fake_frame_writer"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Writes synthetic frame presents into a frame timing channel."));
+    parser.addHelpOption();
+    const QCommandLineOption pidOption(QStringLiteral("pid"), QStringLiteral("PID to publish for (default: this process)."), QStringLiteral("pid"));
+    const QCommandLineOption fpsOption(QStringLiteral("fps"), QStringLiteral("Target frame rate (default: 60)."), QStringLiteral("fps"), QStringLiteral("60"));
+    const QCommandLineOption jitterOption(QStringLiteral("jitter-ms"), QStringLiteral("Random frame time jitter (default: 0)."), QStringLiteral("ms"), QStringLiteral("0"));
+    const QCommandLineOption hitchEveryOption(QStringLiteral("hitch-every"), QStringLiteral("Insert a hitch every N frames (default: never)."), QStringLiteral("frames"), QStringLiteral("0"));
+    const QCommandLineOption hitchOption(QStringLiteral("hitch-ms"), QStringLiteral("Length of each hitch (default: 100)."), QStringLiteral("ms"), QStringLiteral("100"));
+    const QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("Seconds to run (default: until interrupted)."), QStringLiteral("seconds"), QStringLiteral("0"));
+    const QCommandLineOption prefixOption(QStringLiteral("prefix"), QStringLiteral("Channel name prefix."), QStringLiteral("prefix"),
+                                          QString::fromLatin1(Runtime::FRAME_TIMING_DEFAULT_PREFIX));
+    parser.addOptions({pidOption, fpsOption, jitterOption, hitchEveryOption, hitchOption, durationOption, prefixOption});
+    parser.process(app);
+
+    const qint64 pid = parser.isSet(pidOption) ? parser.value(pidOption).toLongLong() : QCoreApplication::applicationPid();
+    const double fps = parser.value(fpsOption).toDouble();
+    const double jitterMs = parser.value(jitterOption).toDouble();
+    const int hitchEvery = parser.value(hitchEveryOption).toInt();
+    const double hitchMs = parser.value(hitchOption).toDouble();
+    const double durationSeconds = parser.value(durationOption).toDouble();
+
+    QTextStream err(stderr);
+    if (pid <= 0 || fps <= 0.0) {
+        err << "pid and fps must be positive\n";
+        return 1;
+    }
+
+    char name[64];
+    const QByteArray prefix = QFile::encodeName(parser.value(prefixOption));
+    Runtime::FrameTimingWriter writer;
+    if (!Runtime::frameTimingChannelName(prefix.constData(), pid, name, sizeof(name)) || !writer.create(name)) {
+        err << "cannot create frame timing channel " << name << '\n';
+        return 1;
+    }
+
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    const quint64 frameNs = static_cast<quint64>(1e9 / fps);
+    const quint64 start = nowNs();
+    const quint64 end = durationSeconds > 0.0 ? start + static_cast<quint64>(durationSeconds * 1e9) : 0;
+    quint64 frames = 0;
+    quint64 dropped = 0;
+    quint64 next = start;
+
+    while (g_running && (end == 0 || next < end)) {
+        quint64 interval = frameNs;
+        if (jitterMs > 0.0) {
+            const double jitter = (QRandomGenerator::global()->generateDouble() * 2.0 - 1.0) * jitterMs;
+            interval = static_cast<quint64>(qMax(0.1, frameNs / 1e6 + jitter) * 1e6);
+        }
+        if (hitchEvery > 0 && frames > 0 && frames % hitchEvery == 0) {
+            interval += static_cast<quint64>(hitchMs * 1e6);
+        }
+        next += interval;
+        sleepUntil(next);
+
+        if (!writer.push(nowNs())) {
+            ++dropped;
+        }
+        ++frames;
+    }
+
+    const double elapsed = (nowNs() - start) / 1e9;
+    QTextStream(stdout) << name << ": " << frames << " frames in " << elapsed << " s ("
+                        << (elapsed > 0.0 ? frames / elapsed : 0.0) << " fps), " << dropped << " dropped\n";
+    return 0;
+}